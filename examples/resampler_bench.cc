@@ -0,0 +1,64 @@
+#include "resampler.hpp"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cmath>
+#include <ctime>
+
+// Throughput of each Resampler preset, in channel-seconds of input
+// converted per second of CPU time (higher is better)
+
+static const unsigned CHANNELS = 2;
+static const size_t   BLOCK    = 512;
+static const double   SECONDS  = 20.0;
+
+double bench(uint32_t in_rate, uint32_t out_rate, Resampler::Quality quality) {
+    Resampler resampler(in_rate, out_rate, CHANNELS, quality);
+
+    std::vector<std::vector<float>> in(CHANNELS, std::vector<float>(BLOCK));
+    std::vector<std::vector<float>> out(CHANNELS, std::vector<float>(resampler.output_frames(BLOCK) + 1));
+    for ( unsigned ch = 0; ch < CHANNELS; ch++ )
+        for ( size_t i = 0; i < BLOCK; i++ )
+            in[ch][i] = static_cast<float>(std::sin(0.01 * i + ch));
+
+    const float* in_ptrs[CHANNELS];
+    float*       out_ptrs[CHANNELS];
+    for ( unsigned ch = 0; ch < CHANNELS; ch++ ) {
+        in_ptrs[ch]  = in[ch].data();
+        out_ptrs[ch] = out[ch].data();
+    }
+
+    size_t blocks = static_cast<size_t>(SECONDS * in_rate / BLOCK);
+    volatile float sink = 0.0f;
+    std::clock_t start = std::clock();
+    for ( size_t b = 0; b < blocks; b++ ) {
+        resampler.process(in_ptrs, BLOCK, out_ptrs);
+        sink = sink + out_ptrs[0][0];
+    }
+    double cpu = static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+
+    double channel_seconds = static_cast<double>(blocks) * BLOCK / in_rate * CHANNELS;
+    return channel_seconds / cpu;
+}
+
+int main() {
+    const uint32_t rates[][2] = {
+        { 44100, 48000 }, { 48000, 44100 }, { 48000, 96000 }, { 96000, 48000 }
+    };
+    const char* names[] = { "FAST", "MEDIUM", "HIGH", "BEST" };
+
+    std::cout << "channel-seconds per CPU-second" << std::endl;
+    std::cout << std::setw(16) << "";
+    for ( const char* name : names )
+        std::cout << std::setw(10) << name;
+    std::cout << std::endl;
+
+    for ( const auto& rate : rates ) {
+        std::cout << std::setw(7) << rate[0] << " -> " << std::setw(5) << rate[1];
+        for ( int q = Resampler::FAST; q <= Resampler::BEST; q++ )
+            std::cout << std::setw(10) << std::fixed << std::setprecision(0)
+                      << bench(rate[0], rate[1], static_cast<Resampler::Quality>(q));
+        std::cout << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,288 @@
+#include "biquad.hpp"
+#include "memory.hpp"
+#include "simd.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+// ---------------------------------------------------------------------
+// --- Designs --- -----------------------------------------------------
+static const double PI = 3.14159265358979323846;
+
+struct Rbj {
+    double cosw, alpha, a; // cos(w0), sin(w0) / 2Q, 10^(gain / 40)
+
+    Rbj(double sample_rate, double freq, double q, double gain_db=0.0) {
+        if ( !(sample_rate > 0.0) || !(freq > 0.0) || !(freq < sample_rate / 2) )
+            throw BiquadUserError("Frequency must be between 0 and Nyquist!");
+        if ( !(q > 0.0) )
+            throw BiquadUserError("Q must be positive!");
+        double w0 = 2.0 * PI * freq / sample_rate;
+        cosw  = std::cos(w0);
+        alpha = std::sin(w0) / (2.0 * q);
+        a     = std::pow(10.0, gain_db / 40.0);
+    }
+};
+
+static BiquadCoeffs normalize(double b0, double b1, double b2, double a0, double a1, double a2) {
+    BiquadCoeffs c;
+    c.b0 = static_cast<float>(b0 / a0);
+    c.b1 = static_cast<float>(b1 / a0);
+    c.b2 = static_cast<float>(b2 / a0);
+    c.a1 = static_cast<float>(a1 / a0);
+    c.a2 = static_cast<float>(a2 / a0);
+    return c;
+}
+
+BiquadCoeffs BiquadCoeffs::lowpass(double sample_rate, double freq, double q) {
+    Rbj r(sample_rate, freq, q);
+    return normalize((1 - r.cosw) / 2, 1 - r.cosw, (1 - r.cosw) / 2, 1 + r.alpha, -2 * r.cosw, 1 - r.alpha);
+}
+
+BiquadCoeffs BiquadCoeffs::highpass(double sample_rate, double freq, double q) {
+    Rbj r(sample_rate, freq, q);
+    return normalize((1 + r.cosw) / 2, -(1 + r.cosw), (1 + r.cosw) / 2, 1 + r.alpha, -2 * r.cosw, 1 - r.alpha);
+}
+
+BiquadCoeffs BiquadCoeffs::bandpass(double sample_rate, double freq, double q) {
+    Rbj r(sample_rate, freq, q);
+    return normalize(r.alpha, 0, -r.alpha, 1 + r.alpha, -2 * r.cosw, 1 - r.alpha);
+}
+
+BiquadCoeffs BiquadCoeffs::notch(double sample_rate, double freq, double q) {
+    Rbj r(sample_rate, freq, q);
+    return normalize(1, -2 * r.cosw, 1, 1 + r.alpha, -2 * r.cosw, 1 - r.alpha);
+}
+
+BiquadCoeffs BiquadCoeffs::allpass(double sample_rate, double freq, double q) {
+    Rbj r(sample_rate, freq, q);
+    return normalize(1 - r.alpha, -2 * r.cosw, 1 + r.alpha, 1 + r.alpha, -2 * r.cosw, 1 - r.alpha);
+}
+
+BiquadCoeffs BiquadCoeffs::peak(double sample_rate, double freq, double q, double gain_db) {
+    Rbj r(sample_rate, freq, q, gain_db);
+    return normalize(1 + r.alpha * r.a, -2 * r.cosw, 1 - r.alpha * r.a,
+                     1 + r.alpha / r.a, -2 * r.cosw, 1 - r.alpha / r.a);
+}
+
+BiquadCoeffs BiquadCoeffs::low_shelf(double sample_rate, double freq, double q, double gain_db) {
+    Rbj    r(sample_rate, freq, q, gain_db);
+    double a = r.a, c = r.cosw, s = 2 * std::sqrt(a) * r.alpha;
+    return normalize(a * ((a + 1) - (a - 1) * c + s), 2 * a * ((a - 1) - (a + 1) * c), a * ((a + 1) - (a - 1) * c - s),
+                     (a + 1) + (a - 1) * c + s, -2 * ((a - 1) + (a + 1) * c), (a + 1) + (a - 1) * c - s);
+}
+
+BiquadCoeffs BiquadCoeffs::high_shelf(double sample_rate, double freq, double q, double gain_db) {
+    Rbj    r(sample_rate, freq, q, gain_db);
+    double a = r.a, c = r.cosw, s = 2 * std::sqrt(a) * r.alpha;
+    return normalize(a * ((a + 1) + (a - 1) * c + s), -2 * a * ((a - 1) + (a + 1) * c), a * ((a + 1) + (a - 1) * c - s),
+                     (a + 1) - (a - 1) * c + s, 2 * ((a - 1) - (a + 1) * c), (a + 1) - (a - 1) * c - s);
+}
+
+// ---------------------------------------------------------------------
+// --- Kernels --- -----------------------------------------------------
+// One stage's arrays, each `lanes` floats (channels rounded up to 4):
+// coef/step/target hold b0, b1, b2, a1, a2 in turn, state z1 then z2
+struct BiquadStage {
+    float* coef;
+    float* step;
+    float* target;
+    float* state;
+    size_t ramp_left;
+};
+
+// Transposed direct form II over n frames of G lane groups at once
+// (independent chains, so their latencies overlap). Group j's frames
+// are 4 floats apart from buf + (g + j) * stride
+template <int G, bool RAMP>
+static void run_stage(BiquadStage& st, size_t lanes, float* buf, size_t stride, size_t g, size_t n) {
+    float4 c[G][5], d[G][5], z1[G], z2[G];
+    float* p[G];
+    for ( int j = 0; j < G; j++ ) {
+        size_t off = (g + j) * 4;
+        for ( int k = 0; k < 5; k++ ) {
+            c[j][k] = float4::load_aligned(st.coef + k * lanes + off);
+            if ( RAMP )
+                d[j][k] = float4::load_aligned(st.step + k * lanes + off);
+        }
+        z1[j] = float4::load_aligned(st.state + off);
+        z2[j] = float4::load_aligned(st.state + lanes + off);
+        p[j]  = buf + (g + j) * stride;
+    }
+
+    for ( size_t i = 0; i < n; i++ ) {
+        for ( int j = 0; j < G; j++ ) {
+            float4 x = float4::load_aligned(p[j] + 4 * i);
+            float4 y = float4::mul_add(c[j][0], x, z1[j]);
+            z1[j] = float4::mul_add(c[j][1], x, z2[j]) - c[j][3] * y;
+            z2[j] = c[j][2] * x - c[j][4] * y;
+            y.store_aligned(p[j] + 4 * i);
+            if ( RAMP )
+                for ( int k = 0; k < 5; k++ )
+                    c[j][k] += d[j][k];
+        }
+    }
+
+    for ( int j = 0; j < G; j++ ) {
+        size_t off = (g + j) * 4;
+        if ( RAMP )
+            for ( int k = 0; k < 5; k++ )
+                c[j][k].store_aligned(st.coef + k * lanes + off);
+        z1[j].store_aligned(st.state + off);
+        z2[j].store_aligned(st.state + lanes + off);
+    }
+}
+
+template <bool RAMP>
+static void run_groups(BiquadStage& st, size_t lanes, float* buf, size_t stride, size_t n) {
+    size_t groups = lanes / 4, g = 0;
+    for ( ; g + 2 <= groups; g += 2 )
+        run_stage<2, RAMP>(st, lanes, buf, stride, g, n);
+    if ( g < groups )
+        run_stage<1, RAMP>(st, lanes, buf, stride, g, n);
+}
+
+// ====== BiquadCascade Implementation ======
+struct BiquadCascade::Impl {
+    unsigned                 nchannels;
+    unsigned                 nstages;
+    size_t                   lanes;
+    Options                  opts;
+
+    AlignedBuffer<float>     memory;
+    std::vector<BiquadStage> stage;
+
+    // Lane group g's frames, 4 floats each, start at scratch + g * max_block * 4
+    AlignedBuffer<float>     scratch;
+
+    Impl(unsigned channels, unsigned stages, const Options& options):
+        nchannels(channels), nstages(stages), lanes((channels + 3) & ~3u), opts(options)
+    {
+        if ( !channels || !stages )
+            throw BiquadUserError("Need at least one channel and one stage!");
+        opts.max_block = std::max<size_t>(opts.max_block, 1);
+
+        size_t per_stage = 17 * lanes;
+        memory.allocate(per_stage * nstages);
+        for ( unsigned s = 0; s < nstages; s++ ) {
+            float* base = memory.data() + s * per_stage;
+            stage.push_back({ base, base + 5 * lanes, base + 10 * lanes, base + 15 * lanes, 0 });
+            std::fill(stage[s].coef, stage[s].coef + lanes, 1.0f);     // b0
+            std::fill(stage[s].target, stage[s].target + lanes, 1.0f); // b0
+        }
+        scratch.allocate(lanes * opts.max_block);
+    }
+
+    void set(unsigned s, unsigned ch, const BiquadCoeffs& c, bool ramp) {
+        if ( s >= nstages || ch >= nchannels )
+            throw BiquadUserError("Stage or channel out of range!");
+        BiquadStage& st = stage[s];
+        const float values[5] = { c.b0, c.b1, c.b2, c.a1, c.a2 };
+        for ( int k = 0; k < 5; k++ )
+            st.target[k * lanes + ch] = values[k];
+
+        if ( ramp && opts.ramp_frames ) {
+            // Every lane of the stage shares one ramp, so re-aim them all
+            float inv = 1.0f / opts.ramp_frames;
+            for ( size_t i = 0; i < 5 * lanes; i++ )
+                st.step[i] = (st.target[i] - st.coef[i]) * inv;
+            st.ramp_left = opts.ramp_frames;
+        } else {
+            for ( int k = 0; k < 5; k++ ) {
+                st.coef[k * lanes + ch] = values[k];
+                st.step[k * lanes + ch] = 0.0f;
+            }
+        }
+    }
+
+    void run(size_t n) {
+        size_t stride = opts.max_block * 4;
+        for ( BiquadStage& st : stage ) {
+            size_t ramped = std::min(n, st.ramp_left);
+            if ( ramped ) {
+                run_groups<true>(st, lanes, scratch.data(), stride, ramped);
+                st.ramp_left -= ramped;
+                if ( !st.ramp_left ) {
+                    std::copy(st.target, st.target + 5 * lanes, st.coef);
+                    std::fill(st.step, st.step + 5 * lanes, 0.0f);
+                }
+            }
+            if ( n > ramped )
+                run_groups<false>(st, lanes, scratch.data() + 4 * ramped, stride, n - ramped);
+        }
+    }
+
+    void process(const float* in, float* out, size_t frames) {
+        DenormalGuard guard;
+        size_t stride = opts.max_block * 4;
+        while ( frames ) {
+            size_t n = std::min(frames, opts.max_block);
+            for ( size_t i = 0; i < n; i++ )
+                for ( unsigned ch = 0; ch < nchannels; ch++ )
+                    scratch[(ch / 4) * stride + 4 * i + ch % 4] = in[i * nchannels + ch];
+            run(n);
+            for ( size_t i = 0; i < n; i++ )
+                for ( unsigned ch = 0; ch < nchannels; ch++ )
+                    out[i * nchannels + ch] = scratch[(ch / 4) * stride + 4 * i + ch % 4];
+            in     += n * nchannels;
+            out    += n * nchannels;
+            frames -= n;
+        }
+    }
+
+    void process(const float* const* in, float* const* out, size_t frames) {
+        DenormalGuard guard;
+        size_t stride = opts.max_block * 4;
+        for ( size_t done = 0; done < frames; ) {
+            size_t n = std::min(frames - done, opts.max_block);
+            for ( unsigned ch = 0; ch < nchannels; ch++ )
+                for ( size_t i = 0; i < n; i++ )
+                    scratch[(ch / 4) * stride + 4 * i + ch % 4] = in[ch][done + i];
+            run(n);
+            for ( unsigned ch = 0; ch < nchannels; ch++ )
+                for ( size_t i = 0; i < n; i++ )
+                    out[ch][done + i] = scratch[(ch / 4) * stride + 4 * i + ch % 4];
+            done += n;
+        }
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- BiquadCascade Class Methods --- ---------------------------------
+BiquadCascade::BiquadCascade(unsigned channels, unsigned stages): BiquadCascade(channels, stages, Options()) {}
+
+BiquadCascade::BiquadCascade(unsigned channels, unsigned stages, const Options& options):
+    pimpl(new Impl(channels, stages, options)) {}
+
+BiquadCascade::~BiquadCascade() = default;
+
+unsigned BiquadCascade::channels() const {
+    return pimpl->nchannels;
+}
+
+unsigned BiquadCascade::stages() const {
+    return pimpl->nstages;
+}
+
+void BiquadCascade::set(unsigned stage, unsigned channel, const BiquadCoeffs& coeffs, bool ramp) {
+    pimpl->set(stage, channel, coeffs, ramp);
+}
+
+void BiquadCascade::set(unsigned stage, const BiquadCoeffs& coeffs, bool ramp) {
+    for ( unsigned ch = 0; ch < pimpl->nchannels; ch++ )
+        pimpl->set(stage, ch, coeffs, ramp);
+}
+
+void BiquadCascade::process(const float* in, float* out, size_t frames) {
+    pimpl->process(in, out, frames);
+}
+
+void BiquadCascade::process(const float* const* in, float* const* out, size_t frames) {
+    pimpl->process(in, out, frames);
+}
+
+void BiquadCascade::reset() {
+    for ( BiquadStage& st : pimpl->stage )
+        std::fill(st.state, st.state + 2 * pimpl->lanes, 0.0f);
+}
@@ -0,0 +1,139 @@
+/**
+ * @file biquad.hpp
+ * @brief Provides @b BiquadCoeffs and @b BiquadCascade for multichannel EQ
+ */
+#ifndef SIMPLY_BIQUAD_HPP_
+#define SIMPLY_BIQUAD_HPP_
+
+#include <string>
+#include <exception>
+#include <memory>
+#include <cstddef>
+
+/**
+ * @class BiquadException
+ * @brief This is the base class of all exceptions thrown by @b BiquadCascade
+ */
+class BiquadException: public std::exception {
+    protected:
+        std::string msg;
+        explicit BiquadException(const std::string& msg): msg(msg) {}
+
+    public:
+        /// @brief Get a message describing the error
+        /// @return NULL-terminated c-string
+        const char* what() const noexcept override { return msg.c_str(); }
+};
+
+/**
+ * @class BiquadUserError
+ * @brief This means a stage/channel index or filter design was invalid
+ */
+class BiquadUserError: public BiquadException {
+    public:
+        explicit BiquadUserError(const std::string& msg): BiquadException("BiquadUserError: " + msg) {}
+};
+
+/**
+ * @struct BiquadCoeffs
+ * @brief Normalized (a0 = 1) coefficients of one second-order section
+ *
+ * `y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]`
+ *
+ * The named designs follow the RBJ Audio EQ Cookbook. Frequencies are
+ * in Hz, @p q is the quality factor and @p gain_db the boost/cut.
+ */
+struct BiquadCoeffs {
+    float b0 = 1.0f;
+    float b1 = 0.0f;
+    float b2 = 0.0f;
+    float a1 = 0.0f;
+    float a2 = 0.0f;
+
+    /// @brief Pass-through
+    static BiquadCoeffs identity() { return BiquadCoeffs(); }
+
+    static BiquadCoeffs lowpass(double sample_rate, double freq, double q);
+    static BiquadCoeffs highpass(double sample_rate, double freq, double q);
+    /// @brief Band-pass with 0 dB peak gain
+    static BiquadCoeffs bandpass(double sample_rate, double freq, double q);
+    static BiquadCoeffs notch(double sample_rate, double freq, double q);
+    static BiquadCoeffs allpass(double sample_rate, double freq, double q);
+    static BiquadCoeffs peak(double sample_rate, double freq, double q, double gain_db);
+    static BiquadCoeffs low_shelf(double sample_rate, double freq, double q, double gain_db);
+    static BiquadCoeffs high_shelf(double sample_rate, double freq, double q, double gain_db);
+};
+
+/**
+ * @class BiquadCascade
+ * @brief Runs the same number of biquad stages on many channels at once
+ *
+ * A biquad is a chain of dependent multiply-adds, so filtering one
+ * channel at a time leaves the CPU waiting on each result. Here the
+ * coefficients and state are stored per stage as arrays over channels
+ * (structure of arrays), and one SIMD lane processes one channel, so 4
+ * (or 8, interleaving two groups) channels advance with each instruction.
+ * Each stage uses the transposed direct form II, and every channel may
+ * have its own coefficients.
+ *
+ * Coefficient changes are interpolated linearly over
+ * @b Options::ramp_frames frames, to avoid zipper noise.
+ * Processing flushes denormals to zero (see @b DenormalGuard).
+ *
+ * @note Call @b set and @b process from the same thread
+ */
+class BiquadCascade {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /**
+         * @struct Options
+         * @brief Coefficient ramps and buffering
+         */
+        struct Options {
+            /// Frames over which a coefficient change is interpolated, 0 to jump
+            size_t ramp_frames = 64;
+            /// Frames processed per pass through the stages
+            size_t max_block   = 256;
+        };
+
+        /// @brief @p stages pass-through stages on each of @p channels channels
+        /// @throws BiquadUserError if @p channels or @p stages is 0
+        BiquadCascade(unsigned channels, unsigned stages);
+
+        /// @brief Create with @p options
+        BiquadCascade(unsigned channels, unsigned stages, const Options& options);
+
+        ~BiquadCascade();
+
+        BiquadCascade(const BiquadCascade&) = delete;
+        BiquadCascade& operator=(const BiquadCascade&) = delete;
+
+        /// @brief Number of channels
+        unsigned channels() const;
+
+        /// @brief Number of stages per channel
+        unsigned stages() const;
+
+        /// @brief Change @p stage of @p channel, ramping unless @p ramp is `false`
+        /// @throws BiquadUserError if @p stage or @p channel is out of range
+        void set(unsigned stage, unsigned channel, const BiquadCoeffs& coeffs, bool ramp=true);
+
+        /// @brief Change @p stage of every channel
+        void set(unsigned stage, const BiquadCoeffs& coeffs, bool ramp=true);
+
+        /// @brief Filter @p frames interleaved frames from @p in into @p out
+        /// @p in and @p out may be the same buffer
+        void process(const float* in, float* out, size_t frames);
+
+        /// @brief Filter @p frames frames of planar channels from @p in into @p out
+        /// @p in and @p out may be the same buffers
+        void process(const float* const* in, float* const* out, size_t frames);
+
+        /// @brief Clear the filter state (not the coefficients)
+        void reset();
+};
+
+#endif // SIMPLY_BIQUAD_HPP_
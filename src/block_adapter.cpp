@@ -0,0 +1,164 @@
+#include "block_adapter.hpp"
+#include "memory.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+// ====== BlockAdapter Implementation ======
+// Input waits in a partial block until it is full; callback output goes
+// through a ring primed with latency frames of silence, which the host
+// drains by exactly as many frames as it supplied
+struct BlockAdapter::Impl {
+    unsigned                  nchannels;
+    size_t                    nblock;
+    block_callback_t          callback;
+    void*                     data;
+    Options                   opts;
+    size_t                    lag;
+    bool                      direct;   // host blocks are whole callback blocks
+
+    AlignedBuffer<float>      partial;  // channels x block
+    size_t                    fill = 0;
+    AlignedBuffer<float>      result;   // channels x block
+    AlignedBuffer<float>      ring;     // channels x capacity
+    size_t                    capacity; // power of two
+    size_t                    head  = 0;
+    size_t                    count = 0;
+    std::vector<const float*> ins;
+    std::vector<float*>       outs;
+
+    Impl(unsigned channels, size_t block, block_callback_t cb, void* user, const Options& options):
+        nchannels(channels), nblock(block), callback(cb), data(user), opts(options) {
+        if ( !channels || !block )
+            throw BlockAdapterUserError("Channels and block must be at least 1!");
+        if ( !cb )
+            throw BlockAdapterUserError("Callback must not be null!");
+
+        size_t host = opts.host_block ? opts.host_block : opts.max_host;
+        if ( !host )
+            throw BlockAdapterUserError("max_host must be at least 1!");
+        direct = opts.host_block && opts.host_block % block == 0;
+        lag    = opts.host_block ? block - std::gcd(opts.host_block, block) : block - 1;
+
+        capacity = 1;
+        while ( capacity < lag + host )
+            capacity <<= 1;
+        if ( !direct ) {
+            partial.allocate(static_cast<size_t>(channels) * block);
+            result.allocate(static_cast<size_t>(channels) * block);
+            ring.allocate(static_cast<size_t>(channels) * capacity);
+        }
+        ins.resize(channels);
+        outs.resize(channels);
+        reset();
+    }
+
+    void reset() {
+        fill  = 0;
+        head  = 0;
+        count = lag;
+        if ( !direct )
+            ring.zero();
+    }
+
+    void run(const float* const* in, size_t in_offset, float* const* out, size_t out_offset) {
+        for ( unsigned ch = 0; ch < nchannels; ch++ ) {
+            ins[ch]  = in[ch] + in_offset;
+            outs[ch] = out[ch] + out_offset;
+        }
+        callback(ins.data(), outs.data(), nblock, data);
+    }
+
+    void run_into_ring(const float* const* in, size_t offset) {
+        for ( unsigned ch = 0; ch < nchannels; ch++ ) {
+            ins[ch]  = in ? in[ch] + offset : partial.data() + ch * nblock;
+            outs[ch] = result.data() + ch * nblock;
+        }
+        callback(ins.data(), outs.data(), nblock, data);
+
+        size_t tail = (head + count) & (capacity - 1);
+        size_t n    = std::min(nblock, capacity - tail);
+        for ( unsigned ch = 0; ch < nchannels; ch++ ) {
+            const float* src = result.data() + ch * nblock;
+            float*       dst = ring.data() + ch * capacity;
+            std::copy(src, src + n, dst + tail);
+            std::copy(src + n, src + nblock, dst);
+        }
+        count += nblock;
+    }
+
+    void process(const float* const* in, float* const* out, size_t frames) {
+        if ( opts.host_block ? frames != opts.host_block : frames > opts.max_host )
+            throw BlockAdapterUserError("Host callback of " + std::to_string(frames) + " frames wasn't promised!");
+
+        if ( direct ) {
+            for ( size_t done = 0; done < frames; done += nblock )
+                run(in, done, out, done);
+            return;
+        }
+
+        size_t done = 0;
+        while ( done < frames ) {
+            // Whole blocks are run from the host buffer itself
+            if ( !fill && frames - done >= nblock ) {
+                run_into_ring(in, done);
+                done += nblock;
+                continue;
+            }
+            size_t n = std::min(frames - done, nblock - fill);
+            for ( unsigned ch = 0; ch < nchannels; ch++ )
+                std::copy(in[ch] + done, in[ch] + done + n, partial.data() + ch * nblock + fill);
+            fill += n;
+            done += n;
+            if ( fill == nblock ) {
+                run_into_ring(nullptr, 0);
+                fill = 0;
+            }
+        }
+
+        // The latency guarantees count >= frames here
+        size_t n = std::min(frames, capacity - head);
+        for ( unsigned ch = 0; ch < nchannels; ch++ ) {
+            const float* src = ring.data() + ch * capacity;
+            std::copy(src + head, src + head + n, out[ch]);
+            std::copy(src, src + frames - n, out[ch] + n);
+        }
+        head   = (head + frames) & (capacity - 1);
+        count -= frames;
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- BlockAdapter Class Methods --- ----------------------------------
+BlockAdapter::BlockAdapter(unsigned channels, size_t block, block_callback_t callback, void* data):
+    BlockAdapter(channels, block, callback, data, Options()) {}
+
+BlockAdapter::BlockAdapter(unsigned channels, size_t block, block_callback_t callback, void* data, const Options& options):
+    pimpl(new Impl(channels, block, callback, data, options)) {}
+
+BlockAdapter::~BlockAdapter() = default;
+
+unsigned BlockAdapter::channels() const {
+    return pimpl->nchannels;
+}
+
+size_t BlockAdapter::block() const {
+    return pimpl->nblock;
+}
+
+size_t BlockAdapter::latency() const {
+    return pimpl->lag;
+}
+
+bool BlockAdapter::passthrough() const {
+    return pimpl->direct;
+}
+
+void BlockAdapter::process(const float* const* in, float* const* out, size_t frames) {
+    pimpl->process(in, out, frames);
+}
+
+void BlockAdapter::reset() {
+    pimpl->reset();
+}
@@ -0,0 +1,111 @@
+/**
+ * @file block_adapter.hpp
+ * @brief Provides @b BlockAdapter, re-blocking host callbacks into fixed-size DSP blocks
+ */
+#ifndef SIMPLY_BLOCK_ADAPTER_HPP_
+#define SIMPLY_BLOCK_ADAPTER_HPP_
+
+#include <string>
+#include <exception>
+#include <memory>
+#include <cstddef>
+
+/// @typedef block_callback_t
+/// @brief Processes one fixed-size block of planar audio
+/// @param in One buffer per channel
+/// @param out One buffer per channel, to write in full (may be @p in, if the host's are)
+/// @param frames Always the adapter's block size
+/// @param data As given to the adapter
+typedef void (*block_callback_t)(const float* const* in, float* const* out, size_t frames, void* data);
+
+/**
+ * @class BlockAdapterException
+ * @brief This is the base class of all exceptions thrown by @b BlockAdapter
+ */
+class BlockAdapterException: public std::exception {
+    protected:
+        std::string msg;
+        explicit BlockAdapterException(const std::string& msg): msg(msg) {}
+
+    public:
+        /// @brief Get a message describing the error
+        /// @return NULL-terminated c-string
+        const char* what() const noexcept override { return msg.c_str(); }
+};
+
+/**
+ * @class BlockAdapterUserError
+ * @brief This means a size was invalid, or a host callback had a size it promised not to
+ */
+class BlockAdapterUserError: public BlockAdapterException {
+    public:
+        explicit BlockAdapterUserError(const std::string& msg): BlockAdapterException("BlockAdapterUserError: " + msg) {}
+};
+
+/**
+ * @class BlockAdapter
+ * @brief Runs a fixed-block callback from host callbacks of another size
+ *
+ * Host input is gathered into blocks of exactly @p block frames for the
+ * callback, and its output is handed back to the host delayed by the
+ * smallest latency that never runs dry:
+ * - host callbacks of varying size (@b Options::host_block of 0), up to
+ *   @b Options::max_host frames: @p block - 1 frames;
+ * - host callbacks of a fixed N frames: @p block - gcd(N, @p block)
+ *   frames, e.g. @p block - N when N divides @p block;
+ * - a fixed N that is a multiple of @p block: no latency at all, and no
+ *   re-blocking: the callback runs straight on the host's buffers.
+ *
+ * Whole blocks found in a host buffer are also passed to the callback
+ * in place rather than copied, whatever the mode.
+ */
+class BlockAdapter {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /**
+         * @struct Options
+         * @brief What the host promises about its callbacks
+         */
+        struct Options {
+            /// Frames in every host callback, or 0 if they vary
+            size_t host_block = 0;
+            /// Largest host callback, when they vary
+            size_t max_host   = 4096;
+        };
+
+        /// @brief Adapter calling @p callback on blocks of @p block frames of @p channels channels
+        BlockAdapter(unsigned channels, size_t block, block_callback_t callback, void* data=nullptr);
+
+        /// @brief Create with @p options
+        /// @throws BlockAdapterUserError if @p channels or @p block is 0, or @p callback is null
+        BlockAdapter(unsigned channels, size_t block, block_callback_t callback, void* data, const Options& options);
+
+        ~BlockAdapter();
+
+        BlockAdapter(const BlockAdapter&) = delete;
+        BlockAdapter& operator=(const BlockAdapter&) = delete;
+
+        /// @brief Number of channels
+        unsigned channels() const;
+
+        /// @brief Frames per callback block
+        size_t block() const;
+
+        /// @brief Frames by which the output lags the input, on top of the callback's own latency
+        size_t latency() const;
+
+        /// @brief Check if host buffers go straight to the callback, without re-blocking
+        bool passthrough() const;
+
+        /// @brief Process one host callback of @p frames frames
+        /// @throws BlockAdapterUserError if @p frames breaks the promise made in @b Options
+        void process(const float* const* in, float* const* out, size_t frames);
+
+        /// @brief Drop buffered audio, back to @b latency frames of silence
+        void reset();
+};
+
+#endif // SIMPLY_BLOCK_ADAPTER_HPP_
@@ -0,0 +1,239 @@
+/**
+ * @file chain.hpp
+ * @brief Provides @b StaticChain, per-sample stages fused into one loop at compile time
+ */
+#ifndef SIMPLY_CHAIN_HPP_
+#define SIMPLY_CHAIN_HPP_
+
+#include "biquad.hpp"
+#include "graph.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace chain_detail {
+    // Whether S can run 4 samples at a time, as float4 operator()(float4)
+    template <typename S, typename = void>
+    struct has_vector : std::false_type {};
+    template <typename S>
+    struct has_vector<S, std::enable_if_t<std::is_same<decltype(std::declval<S&>()(std::declval<float4>())), float4>::value>>
+        : std::true_type {};
+
+    // Whether S has state to clear, as void reset()
+    template <typename S, typename = void>
+    struct has_reset : std::false_type {};
+    template <typename S>
+    struct has_reset<S, std::void_t<decltype(std::declval<S&>().reset())>> : std::true_type {};
+
+    template <typename S>
+    void reset(S& s, std::true_type) { s.reset(); }
+    template <typename S>
+    void reset(S&, std::false_type) {}
+}
+
+/**
+ * @class StaticChain
+ * @brief A fixed sequence of per-sample stages, run as one loop
+ *
+ * Each stage is a value type with `float operator()(float)`. The chain
+ * applies them in order to every sample with a fold expression, so the
+ * compiler inlines the whole chain into a single pass: intermediate
+ * results stay in registers rather than making a round trip through a
+ * buffer between stages.
+ *
+ * If every stage also has `float4 operator()(float4)` (stateless stages
+ * such as @b GainStage and @b ClipStage), the chain runs 4 samples at a
+ * time. Stages may have `void reset()` to clear their state.
+ *
+ * A chain is itself a stage, so chains nest. Wrap one in a
+ * @b FusedChainNode to put it in a @b Graph.
+ *
+ * @code
+ * StaticChain chain{GainStage{0.5f}, BiquadStage{BiquadCoeffs::lowpass(48000, 8000, 0.7)}, ClipStage{1.0f}};
+ * chain.process(in, out, frames);
+ * @endcode
+ *
+ * @note Stage parameters are plain members: change them on the thread running the chain
+ */
+template <typename... Stages>
+class StaticChain {
+    protected:
+        std::tuple<Stages...> stages;
+
+    public:
+        /// @brief Whether the whole chain runs 4 samples at a time
+        static constexpr bool vectorized = (chain_detail::has_vector<Stages>::value && ...);
+
+        /// @brief Chain of default-constructed stages
+        StaticChain() = default;
+
+        /// @brief Chain of copies of @p s, in order
+        explicit StaticChain(Stages... s): stages(std::move(s)...) {}
+
+        /// @brief Number of stages
+        static constexpr size_t size() { return sizeof...(Stages); }
+
+        /// @brief Access stage @p I, e.g. to change its parameters
+        template <size_t I>
+        auto& stage() { return std::get<I>(stages); }
+
+        /// @brief Access stage @p I
+        template <size_t I>
+        const auto& stage() const { return std::get<I>(stages); }
+
+        /// @brief Run one sample through every stage
+        float operator()(float x) {
+            std::apply([&x](Stages&... s) { ((x = s(x)), ...); }, stages);
+            return x;
+        }
+
+        /// @brief Run 4 samples through every stage
+        template <bool V = vectorized, typename = std::enable_if_t<V>>
+        float4 operator()(float4 x) {
+            std::apply([&x](Stages&... s) { ((x = s(x)), ...); }, stages);
+            return x;
+        }
+
+        /// @brief Run @p frames samples from @p in into @p out (which may be @p in)
+        void process(const float* in, float* out, size_t frames) {
+            size_t i = 0;
+            if constexpr ( vectorized ) {
+                for ( ; i + 4 <= frames; i += 4 )
+                    (*this)(float4::load(in + i)).store(out + i);
+            }
+            for ( ; i < frames; i++ )
+                out[i] = (*this)(in[i]);
+        }
+
+        /// @brief Clear the state of every stage that has some
+        void reset() {
+            std::apply([](Stages&... s) { (chain_detail::reset(s, chain_detail::has_reset<Stages>()), ...); }, stages);
+        }
+};
+
+// ---------------------------------------------------------------------
+// --- Stages --- ------------------------------------------------------
+
+/**
+ * @struct GainStage
+ * @brief Multiplies by @b gain
+ */
+struct GainStage {
+    float gain = 1.0f;
+
+    float  operator()(float x) const  { return x * gain; }
+    float4 operator()(float4 x) const { return x * float4::broadcast(gain); }
+};
+
+/**
+ * @struct ClipStage
+ * @brief Clamps to [-@b ceiling, @b ceiling], e.g. before conversion to integers
+ */
+struct ClipStage {
+    float ceiling = 1.0f;
+
+    float  operator()(float x) const  { return std::min(std::max(x, -ceiling), ceiling); }
+    float4 operator()(float4 x) const { return float4::min(float4::max(x, float4::broadcast(-ceiling)), float4::broadcast(ceiling)); }
+};
+
+/**
+ * @struct BiquadStage
+ * @brief One second-order section (transposed direct form II)
+ */
+struct BiquadStage {
+    BiquadCoeffs c;
+    float        z1 = 0.0f;
+    float        z2 = 0.0f;
+
+    BiquadStage() = default;
+    explicit BiquadStage(const BiquadCoeffs& coeffs): c(coeffs) {}
+
+    float operator()(float x) {
+        float y = c.b0 * x + z1;
+        z1 = c.b1 * x - c.a1 * y + z2;
+        z2 = c.b2 * x - c.a2 * y;
+        return y;
+    }
+
+    void reset() { z1 = z2 = 0.0f; }
+};
+
+/**
+ * @struct LimiterStage
+ * @brief Peak limiter with instant attack and exponential release
+ *
+ * The envelope follows the peak level, jumping up at once and decaying
+ * by @b release per sample; while it exceeds @b ceiling, the gain is
+ * ceiling / envelope, so the output never exceeds @b ceiling.
+ */
+struct LimiterStage {
+    float ceiling = 1.0f;
+    float release = 0.0f; // per-sample decay of the envelope
+    float env     = 0.0f;
+
+    LimiterStage() = default;
+
+    /// @brief Limit to @p ceiling, releasing with a time constant of @p release_ms
+    LimiterStage(float ceiling, double sample_rate, double release_ms):
+        ceiling(ceiling), release(static_cast<float>(std::exp(-1000.0 / (release_ms * sample_rate)))) {}
+
+    float operator()(float x) {
+        env = std::max(std::fabs(x), env * release);
+        return env > ceiling ? x * (ceiling / env) : x;
+    }
+
+    void reset() { env = 0.0f; }
+};
+
+// ---------------------------------------------------------------------
+// --- Graph Node --- --------------------------------------------------
+
+/**
+ * @class FusedChainNode
+ * @brief A @b StaticChain per channel, as a @b GraphNode with one input and output per channel
+ *
+ * Stages are reset when the node is prepared.
+ */
+template <typename... Stages>
+class FusedChainNode: public GraphNode {
+    protected:
+        std::vector<StaticChain<Stages...>> chains;
+
+    public:
+        /// @brief Node running a copy of @p chain on each of @p channels channels
+        FusedChainNode(unsigned channels, const StaticChain<Stages...>& chain): chains(channels, chain) {}
+
+        /// @brief Chain of @p channel, e.g. to change its stages' parameters from the audio thread
+        StaticChain<Stages...>& chain(unsigned channel) { return chains[channel]; }
+
+        unsigned num_inputs() const override { return static_cast<unsigned>(chains.size()); }
+
+        unsigned num_outputs() const override { return static_cast<unsigned>(chains.size()); }
+
+        void prepare(uint32_t sample_rate, size_t max_block) override {
+            (void) sample_rate;
+            (void) max_block;
+            for ( StaticChain<Stages...>& c : chains )
+                c.reset();
+        }
+
+        void process(const float* const* in, float* const* out, size_t frames) override {
+            for ( size_t c = 0; c < chains.size(); c++ )
+                chains[c].process(in[c], out[c], frames);
+        }
+};
+
+/// @brief Make a @b FusedChainNode of @p channels channels running @p stages
+template <typename... Stages>
+std::shared_ptr<FusedChainNode<Stages...>> make_fused_chain(unsigned channels, Stages... stages) {
+    return std::make_shared<FusedChainNode<Stages...>>(channels, StaticChain<Stages...>(std::move(stages)...));
+}
+
+#endif // SIMPLY_CHAIN_HPP_
@@ -0,0 +1,570 @@
+#include "convolver.hpp"
+#include "fft.hpp"
+#include "futex.hpp"
+#include "lockfree.hpp"
+#include "memory.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// ---------------------------------------------------------------------
+// --- Helpers --- -----------------------------------------------------
+static void check_block_size(size_t block_size) {
+    if ( block_size < 4 || (block_size & (block_size - 1)) )
+        throw ConvolverUserError("Block size " + std::to_string(block_size) + " is not a power of two of at least 4!");
+}
+
+// acc += x * h for packed spectra of n floats: bins 0/1 are the real DC
+// and Nyquist values, the rest interleaved complex pairs
+static void spectrum_mac(float* acc, const float* x, const float* h, size_t n) {
+    acc[0] += x[0] * h[0];
+    acc[1] += x[1] * h[1];
+    float re = x[2] * h[2] - x[3] * h[3];
+    float im = x[2] * h[3] + x[3] * h[2];
+    acc[2] += re;
+    acc[3] += im;
+    for ( size_t i = 4; i < n; i += 4 ) {
+        float4 sum = float4::load_aligned(acc + i) + complex_mul(float4::load_aligned(x + i), float4::load_aligned(h + i));
+        sum.store_aligned(acc + i);
+    }
+}
+
+// ====== ConvolutionIR Implementation ======
+struct ConvolutionIR::Impl {
+    size_t               block;
+    size_t               length;
+    size_t               count;
+    AlignedBuffer<float> spectra; // count * 2 * block
+
+    Impl(const float* ir, size_t len, size_t block_size): block(block_size), length(len) {
+        check_block_size(block_size);
+        if ( !ir || !len )
+            throw ConvolverUserError("Impulse response is empty!");
+
+        count = (len + block - 1) / block;
+        spectra.allocate(count * 2 * block);
+        std::shared_ptr<const FftPlan> plan = FftPlan::get(2 * block);
+        for ( size_t p = 0; p < count; p++ ) {
+            float* s = spectra.data() + p * 2 * block;
+            size_t n = std::min(block, len - p * block);
+            std::copy(ir + p * block, ir + p * block + n, s); // second half stays zero
+            plan->forward(s);
+        }
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- ConvolutionIR Class Methods --- ---------------------------------
+ConvolutionIR::ConvolutionIR(const float* ir, size_t length, size_t block_size):
+    pimpl(new Impl(ir, length, block_size)) {}
+
+ConvolutionIR::~ConvolutionIR() = default;
+
+size_t ConvolutionIR::block_size() const {
+    return pimpl->block;
+}
+
+size_t ConvolutionIR::length() const {
+    return pimpl->length;
+}
+
+size_t ConvolutionIR::partitions() const {
+    return pimpl->count;
+}
+
+const float* ConvolutionIR::spectrum(size_t p) const {
+    return pimpl->spectra.data() + p * 2 * pimpl->block;
+}
+
+// ====== UniformConvolver Implementation ======
+// New IRs come in through a triple buffer, so the latest one set wins and
+// the ones it overwrites are dropped by the control thread. Replaced IRs
+// go back through a queue, also to be dropped by the control thread: the
+// audio thread never holds the last reference to an IR
+struct UniformConvolver::Impl {
+    using IrPtr = std::shared_ptr<const ConvolutionIR>;
+
+    size_t                         block;
+    size_t                         capacity; // partitions the delay line holds
+    size_t                         crossfade;
+    std::shared_ptr<const FftPlan> plan;
+
+    IrPtr                          ir;
+    IrPtr                          pending; // crossfading towards this
+    size_t                         fade_pos = 0;
+
+    TripleBuffer<IrPtr>            incoming;
+    SpscQueue<IrPtr>               outgoing{4};
+
+    // [previous block | current block], the overlap-save input window
+    AlignedBuffer<float>           window;
+    // Spectra of the last `capacity` windows, newest at `head`
+    AlignedBuffer<float>           fdl;
+    size_t                         head = 0;
+
+    AlignedBuffer<float>           acc;
+    AlignedBuffer<float>           acc_pending;
+    AlignedBuffer<float>           output; // last block's result, played during the next
+    size_t                         fill = 0;
+
+    Impl(IrPtr initial, const Options& options) {
+        if ( !initial )
+            throw ConvolverUserError("Impulse response is null!");
+        block     = initial->block_size();
+        capacity  = std::max(options.max_partitions, initial->partitions());
+        crossfade = std::max<size_t>(options.crossfade_blocks, 1) * block;
+        plan      = FftPlan::get(2 * block);
+        ir        = std::move(initial);
+
+        window.allocate(2 * block);
+        fdl.allocate(capacity * 2 * block);
+        acc.allocate(2 * block);
+        acc_pending.allocate(2 * block);
+        output.allocate(block);
+    }
+
+    void accumulate(const ConvolutionIR& filter, float* dst) const {
+        size_t n = 2 * block;
+        std::fill(dst, dst + n, 0.0f);
+        size_t slot = head;
+        for ( size_t p = 0; p < filter.partitions(); p++ ) {
+            spectrum_mac(dst, fdl.data() + slot * n, filter.spectrum(p), n);
+            slot = slot ? slot - 1 : capacity - 1;
+        }
+        plan->inverse(dst);
+    }
+
+    // Audio thread: hands the replaced IR to the control thread. At most
+    // two fades end between calls to set_ir, which empties the queue, so
+    // there is always room
+    void retire(IrPtr old) {
+        IrPtr* slot = outgoing.write_slot();
+        *slot = std::move(old);
+        outgoing.commit();
+    }
+
+    void run_block() {
+        // A new IR is only picked up between crossfades, so one set
+        // mid-fade waits for the current fade to finish
+        if ( !pending && incoming.update() )
+            pending = incoming.read_slot();
+
+        head = head + 1 == capacity ? 0 : head + 1;
+        plan->forward(window.data(), fdl.data() + head * 2 * block);
+        std::copy(window.data() + block, window.data() + 2 * block, window.data());
+
+        float scale = 1.0f / (2 * block);
+        accumulate(*ir, acc.data());
+        if ( !pending ) {
+            for ( size_t i = 0; i < block; i++ )
+                output[i] = acc[block + i] * scale;
+            return;
+        }
+
+        accumulate(*pending, acc_pending.data());
+        float step = 1.0f / crossfade;
+        for ( size_t i = 0; i < block; i++ ) {
+            float g = std::min(1.0f, (fade_pos + i) * step);
+            output[i] = (acc[block + i] + g * (acc_pending[block + i] - acc[block + i])) * scale;
+        }
+        fade_pos += block;
+        if ( fade_pos >= crossfade ) {
+            IrPtr old = std::move(ir);
+            ir        = std::move(pending);
+            fade_pos  = 0;
+            retire(std::move(old));
+        }
+    }
+
+    void process(const float* in, float* out, size_t frames) {
+        while ( frames ) {
+            size_t n = std::min(frames, block - fill);
+            // Read the input before writing, in case in == out
+            std::copy(in, in + n, window.data() + block + fill);
+            std::copy(output.data() + fill, output.data() + fill + n, out);
+            fill   += n;
+            in     += n;
+            out    += n;
+            frames -= n;
+            if ( fill == block ) {
+                run_block();
+                fill = 0;
+            }
+        }
+    }
+
+    void set_ir(IrPtr next) {
+        if ( !next )
+            throw ConvolverUserError("Impulse response is null!");
+        if ( next->block_size() != block )
+            throw ConvolverUserError("Impulse response has a different block size!");
+        if ( next->partitions() > capacity )
+            throw ConvolverUserError(
+                "Impulse response has " + std::to_string(next->partitions()) +
+                " partitions, but the convolver only holds " + std::to_string(capacity) + "!"
+            );
+
+        // Drop what the audio thread is done with, then publish
+        while ( IrPtr* old = outgoing.read_slot() ) {
+            old->reset();
+            outgoing.release();
+        }
+        incoming.write_slot() = std::move(next);
+        incoming.publish();
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- UniformConvolver Class Methods --- ------------------------------
+UniformConvolver::UniformConvolver(std::shared_ptr<const ConvolutionIR> ir):
+    UniformConvolver(std::move(ir), Options()) {}
+
+UniformConvolver::UniformConvolver(std::shared_ptr<const ConvolutionIR> ir, const Options& options):
+    pimpl(new Impl(std::move(ir), options)) {}
+
+UniformConvolver::~UniformConvolver() = default;
+
+size_t UniformConvolver::block_size() const {
+    return pimpl->block;
+}
+
+size_t UniformConvolver::latency() const {
+    return pimpl->block;
+}
+
+void UniformConvolver::process(const float* in, float* out, size_t frames) {
+    pimpl->process(in, out, frames);
+}
+
+void UniformConvolver::set_ir(std::shared_ptr<const ConvolutionIR> ir) {
+    pimpl->set_ir(std::move(ir));
+}
+
+void UniformConvolver::reset() {
+    pimpl->window.zero();
+    pimpl->fdl.zero();
+    pimpl->output.zero();
+    pimpl->fill = 0;
+}
+
+// ====== NonUniformConvolver Implementation ======
+struct NonUniformConvolver::Impl {
+    // A run of equal partitions, convolved by uniform overlap-save. The
+    // head is run by process(), the others by the workers
+    struct Segment {
+        size_t                               size;   // P, samples per partition
+        size_t                               offset; // into the IR
+        std::shared_ptr<const ConvolutionIR> ir;     // IR[offset, ...) in partitions of P
+
+        // Per channel: input (head: the 2P overlap-save window, tail:
+        // a 4P ring), delay line and output (tail: two slots of P)
+        AlignedBuffer<float>                 input;
+        AlignedBuffer<float>                 fdl;
+        AlignedBuffer<float>                 output;
+        AlignedBuffer<float>                 acc;
+        size_t                               slot = 0;
+        std::shared_ptr<const FftPlan>       plan;
+        std::vector<float*>                  slots[2]; // tail: each channel's output slot
+
+        // Tail only: job k (the convolution of input block k) is
+        // submitted once its P samples are in, and its output plays
+        // 2P later
+        std::atomic<uint64_t>                submitted{0};
+        std::atomic<uint64_t>                completed{0};
+        bool                                 busy  = false; // guarded by m
+        bool                                 valid = false; // audio thread only
+    };
+
+    size_t                                block;
+    unsigned                              channels;
+    std::vector<std::unique_ptr<Segment>> segments;
+    uint64_t                              time = 0;
+    std::atomic<uint64_t>                 missed{0};
+
+    std::mutex                            m;
+    Futex                                 signal; // bumped on every submission
+    bool                                  stopping = false;
+    std::vector<Thread>                   workers;
+    unsigned                              created  = 0; // workers with a thread, started or not
+
+    Impl(const float* ir, size_t length, size_t block_size, unsigned nchannels, const Options& options):
+        block(block_size), channels(nchannels)
+    {
+        check_block_size(block_size);
+        if ( !ir || !length )
+            throw ConvolverUserError("Impulse response is empty!");
+        if ( !channels )
+            throw ConvolverUserError("Need at least one channel!");
+
+        // Segment i has partitions of P = 4^i B and starts at 2P (the
+        // head at 0), so it ends where the next one starts: 8P
+        size_t size = block, offset = 0;
+        while ( offset < length ) {
+            size_t next = 4 * size;
+            size_t end  = (next <= options.max_partition && 2 * next < length) ? 2 * next : length;
+            add_segment(ir + offset, end - offset, size, offset);
+            offset = end;
+            size   = next;
+        }
+
+        if ( segments.size() > 1 ) {
+            if ( !options.threads )
+                throw ConvolverUserError("Impulse response needs at least one worker thread!");
+            workers.resize(options.threads);
+            try {
+                for ( Thread& worker : workers ) {
+                    worker.create(worker_main, this);
+                    created++;
+                    worker.set_priority(options.priority);
+                    worker.start();
+                }
+            } catch ( ... ) {
+                stop(); // ~Impl won't run, and the started workers are waiting
+                throw;
+            }
+        }
+    }
+
+    ~Impl() {
+        stop();
+    }
+
+    // Workers a failed constructor created but never started are started
+    // here, only to see stopping and return, as they can't be joined before
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stopping = true;
+        }
+        signal.fetch_add(1);
+        signal.wake_all();
+        for ( unsigned i = 0; i < created; i++ ) {
+            try {
+                if ( !workers[i].started() )
+                    workers[i].start();
+                workers[i].join();
+            } catch ( ... ) { ; }
+        }
+        workers.clear();
+        created = 0;
+    }
+
+    void add_segment(const float* ir, size_t length, size_t size, size_t offset) {
+        std::unique_ptr<Segment> seg(new Segment());
+        seg->size   = size;
+        seg->offset = offset;
+        seg->ir     = std::make_shared<const ConvolutionIR>(ir, length, size);
+
+        bool head = segments.empty();
+        seg->input.allocate(channels * (head ? 2 : 4) * size);
+        seg->fdl.allocate(channels * seg->ir->partitions() * 2 * size);
+        seg->output.allocate(head ? 0 : channels * 2 * size);
+        seg->acc.allocate(2 * size);
+        seg->plan = FftPlan::get(2 * size);
+        if ( !head )
+            for ( unsigned ch = 0; ch < channels; ch++ )
+                for ( int i = 0; i < 2; i++ )
+                    seg->slots[i].push_back(seg->output.data() + (ch * 2 + i) * size);
+        segments.push_back(std::move(seg));
+    }
+
+    // Transform the window already copied into each channel's current
+    // delay line slot, and write the segment's next P output samples
+    void convolve(Segment& seg, float* const* out) {
+        const FftPlan& plan = *seg.plan;
+        size_t n     = 2 * seg.size;
+        size_t parts = seg.ir->partitions();
+        float  scale = 1.0f / n;
+        for ( unsigned ch = 0; ch < channels; ch++ ) {
+            float* fdl = seg.fdl.data() + ch * parts * n;
+            plan.forward(fdl + seg.slot * n);
+
+            float* acc = seg.acc.data();
+            std::fill(acc, acc + n, 0.0f);
+            size_t slot = seg.slot;
+            for ( size_t p = 0; p < parts; p++ ) {
+                spectrum_mac(acc, fdl + slot * n, seg.ir->spectrum(p), n);
+                slot = slot ? slot - 1 : parts - 1;
+            }
+            plan.inverse(acc);
+            for ( size_t i = 0; i < seg.size; i++ )
+                out[ch][i] = acc[seg.size + i] * scale;
+        }
+    }
+
+    // ====== Audio thread ======
+    void process(const float* const* in, float* const* out, size_t frames) {
+        if ( frames != block )
+            throw ConvolverUserError("NonUniformConvolver must process exactly block_size() frames!");
+
+        // Decide once per period whether each tail segment's output is
+        // ready, so a job finishing mid-period is never half-played
+        for ( size_t s = 1; s < segments.size(); s++ ) {
+            Segment& seg = *segments[s];
+            if ( time % seg.size )
+                continue;
+            uint64_t period = time / seg.size;
+            seg.valid = period >= 2 && seg.completed.load(std::memory_order_acquire) >= period - 1;
+            if ( period >= 2 && !seg.valid ) // the only place a late job is counted
+                missed.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Store the input everywhere first, as out may alias in
+        Segment& head  = *segments[0];
+        size_t   parts = head.ir->partitions();
+        head.slot = head.slot + 1 == parts ? 0 : head.slot + 1;
+        for ( unsigned ch = 0; ch < channels; ch++ ) {
+            float* window = head.input.data() + ch * 2 * block;
+            std::copy(window + block, window + 2 * block, window);
+            std::copy(in[ch], in[ch] + block, window + block);
+            std::copy(window, window + 2 * block, head.fdl.data() + (ch * parts + head.slot) * 2 * block);
+            for ( size_t s = 1; s < segments.size(); s++ ) {
+                Segment& seg  = *segments[s];
+                size_t   ring = 4 * seg.size;
+                std::copy(in[ch], in[ch] + block, seg.input.data() + ch * ring + time % ring);
+            }
+        }
+
+        convolve(head, out);
+
+        for ( size_t s = 1; s < segments.size(); s++ ) {
+            Segment& seg = *segments[s];
+            if ( !seg.valid )
+                continue;
+            uint64_t period = time / seg.size;
+            size_t   phase  = time % seg.size;
+            for ( unsigned ch = 0; ch < channels; ch++ ) {
+                const float* src = seg.output.data() + (ch * 2 + (period - 2) % 2) * seg.size + phase;
+                float*       dst = out[ch];
+                for ( size_t i = 0; i < block; i++ )
+                    dst[i] += src[i];
+            }
+        }
+
+        time += block;
+        bool submitted = false;
+        for ( size_t s = 1; s < segments.size(); s++ ) {
+            Segment& seg = *segments[s];
+            if ( time % seg.size == 0 ) {
+                seg.submitted.store(time / seg.size, std::memory_order_release);
+                submitted = true;
+            }
+        }
+        // No lock: a worker reads the signal before looking for work, so
+        // a bump in between makes its wait return at once
+        if ( submitted ) {
+            signal.fetch_add(1);
+            signal.wake_all();
+        }
+    }
+
+    // ====== Workers ======
+    static int worker_main(void* data) {
+        static_cast<Impl*>(data)->work();
+        return 0;
+    }
+
+    // Earliest-deadline-first: job k of a segment is due at 2P after
+    // its input was complete, i.e. at sample (k + 2) * P
+    Segment* pick() {
+        Segment* best          = nullptr;
+        uint64_t best_deadline = 0;
+        for ( size_t s = 1; s < segments.size(); s++ ) {
+            Segment& seg = *segments[s];
+            uint64_t k   = seg.completed.load(std::memory_order_relaxed);
+            if ( seg.busy || k >= seg.submitted.load(std::memory_order_acquire) )
+                continue;
+            uint64_t deadline = (k + 2) * seg.size;
+            if ( !best || deadline < best_deadline ) {
+                best          = &seg;
+                best_deadline = deadline;
+            }
+        }
+        return best;
+    }
+
+    void work() {
+        std::unique_lock<std::mutex> lock(m);
+        while ( true ) {
+            Segment* seg = nullptr;
+            while ( true ) {
+                uint32_t seen = signal.load();
+                if ( stopping || (seg = pick()) )
+                    break;
+                lock.unlock();
+                signal.wait(seen);
+                lock.lock();
+            }
+            if ( stopping )
+                return;
+            seg->busy = true;
+            lock.unlock();
+            run_job(*seg);
+            lock.lock();
+            seg->busy = false;
+        }
+    }
+
+    void run_job(Segment& seg) {
+        uint64_t k     = seg.completed.load(std::memory_order_relaxed);
+        size_t   size  = seg.size;
+        size_t   ring  = 4 * size;
+        size_t   parts = seg.ir->partitions();
+        size_t   n     = 2 * size;
+
+        // The window is input blocks k - 1 and k
+        seg.slot = seg.slot + 1 == parts ? 0 : seg.slot + 1;
+        size_t start = static_cast<size_t>(((k + 3) % 4) * size);
+        for ( unsigned ch = 0; ch < channels; ch++ ) {
+            const float* src = seg.input.data() + ch * ring;
+            float*       dst = seg.fdl.data() + (ch * parts + seg.slot) * n;
+            size_t first = std::min(n, ring - start);
+            std::copy(src + start, src + start + first, dst);
+            std::copy(src, src + (n - first), dst + first);
+        }
+
+        // Block k + 3 overwrites block k - 1 in the ring; if that has
+        // started, this job is far too late and its input is unusable.
+        // Its output was due long before, so process() already counted it
+        if ( seg.submitted.load(std::memory_order_acquire) >= k + 3 ) {
+            for ( unsigned ch = 0; ch < channels; ch++ ) {
+                float* dst = seg.fdl.data() + (ch * parts + seg.slot) * n;
+                std::fill(dst, dst + n, 0.0f);
+            }
+        }
+
+        convolve(seg, seg.slots[k % 2].data());
+
+        seg.completed.store(k + 1, std::memory_order_release);
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- NonUniformConvolver Class Methods --- ---------------------------
+NonUniformConvolver::NonUniformConvolver(const float* ir, size_t length, size_t block_size, unsigned channels):
+    NonUniformConvolver(ir, length, block_size, channels, Options()) {}
+
+NonUniformConvolver::NonUniformConvolver(const float* ir, size_t length, size_t block_size, unsigned channels,
+                                         const Options& options):
+    pimpl(new Impl(ir, length, block_size, channels, options)) {}
+
+NonUniformConvolver::~NonUniformConvolver() = default;
+
+size_t NonUniformConvolver::block_size() const {
+    return pimpl->block;
+}
+
+size_t NonUniformConvolver::segments() const {
+    return pimpl->segments.size();
+}
+
+uint64_t NonUniformConvolver::missed_blocks() const {
+    return pimpl->missed.load(std::memory_order_relaxed);
+}
+
+void NonUniformConvolver::process(const float* const* in, float* const* out, size_t frames) {
+    pimpl->process(in, out, frames);
+}
@@ -0,0 +1,214 @@
+/**
+ * @file convolver.hpp
+ * @brief Provides @b ConvolutionIR, @b UniformConvolver and @b NonUniformConvolver for long FIR filters
+ */
+#ifndef SIMPLY_CONVOLVER_HPP_
+#define SIMPLY_CONVOLVER_HPP_
+
+#include "threads.hpp"
+
+#include <string>
+#include <exception>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class ConvolverException
+ * @brief This is the base class of all exceptions thrown by the convolution classes
+ */
+class ConvolverException: public std::exception {
+    protected:
+        std::string msg;
+        explicit ConvolverException(const std::string& msg): msg(msg) {}
+
+    public:
+        /// @brief Get a message describing the error
+        /// @return NULL-terminated c-string
+        const char* what() const noexcept override { return msg.c_str(); }
+};
+
+/**
+ * @class ConvolverUserError
+ * @brief This means an impulse response or block size is not supported
+ */
+class ConvolverUserError: public ConvolverException {
+    public:
+        explicit ConvolverUserError(const std::string& msg): ConvolverException("ConvolverUserError: " + msg) {}
+};
+
+/**
+ * @class ConvolutionIR
+ * @brief An impulse response cut into block-sized partitions and transformed
+ *
+ * Computing the spectra is the expensive part of loading an IR, so it is
+ * done once here and the result shared (through @b std::shared_ptr)
+ * by every channel that uses the same filter.
+ */
+class ConvolutionIR {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /// @brief Partition @p length samples of @p ir into blocks of @p block_size
+        /// @throws ConvolverUserError if @p ir is empty or @p block_size is not a power of two of at least 4
+        ConvolutionIR(const float* ir, size_t length, size_t block_size);
+
+        ~ConvolutionIR();
+
+        ConvolutionIR(const ConvolutionIR&) = delete;
+        ConvolutionIR& operator=(const ConvolutionIR&) = delete;
+
+        /// @brief Samples per partition
+        size_t block_size() const;
+
+        /// @brief Length of the impulse response in samples
+        size_t length() const;
+
+        /// @brief Number of partitions
+        size_t partitions() const;
+
+        /// @brief Packed spectrum (see @b FftPlan) of partition @p p, 2 * @b block_size floats
+        const float* spectrum(size_t p) const;
+};
+
+/**
+ * @class UniformConvolver
+ * @brief Convolves one channel with a @b ConvolutionIR by uniformly partitioned overlap-save
+ *
+ * Every block of input is transformed once and kept in a frequency-domain
+ * delay line, so a block of output costs one forward FFT, one complex
+ * multiply-accumulate per partition and one inverse FFT, regardless of
+ * the IR length.
+ *
+ * Input is gathered into whole blocks, so @b process accepts any number
+ * of frames and the output is delayed by exactly one block.
+ *
+ * Nothing is allocated after construction, so @b process is safe to call
+ * from a real-time thread.
+ */
+class UniformConvolver {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /**
+         * @struct Options
+         * @brief Capacity of the delay line and IR crossfades
+         */
+        struct Options {
+            /// Largest IR (in partitions) @b set_ir will accept, 0 for the initial IR's
+            size_t max_partitions   = 0;
+            /// Length of the crossfade after @b set_ir, in blocks
+            size_t crossfade_blocks = 1;
+        };
+
+        /// @brief Convolve with @p ir
+        /// @throws ConvolverUserError if @p ir is null
+        explicit UniformConvolver(std::shared_ptr<const ConvolutionIR> ir);
+
+        /// @brief Convolve with @p ir with @p options
+        UniformConvolver(std::shared_ptr<const ConvolutionIR> ir, const Options& options);
+
+        ~UniformConvolver();
+
+        UniformConvolver(const UniformConvolver&) = delete;
+        UniformConvolver& operator=(const UniformConvolver&) = delete;
+
+        /// @brief Samples per block (and partition)
+        size_t block_size() const;
+
+        /// @brief Delay added by the convolver, one block
+        size_t latency() const;
+
+        /// @brief Filter @p frames samples from @p in into @p out
+        /// @p in and @p out may be the same buffer
+        void process(const float* in, float* out, size_t frames);
+
+        /// @brief Crossfade to @p ir over the next @b Options::crossfade_blocks blocks
+        /// Call from one control thread, while another runs @b process: the IR
+        /// is handed over without locks and picked up at the next block. If a
+        /// crossfade is under way, the latest IR set waits for it to finish.
+        /// Replaced IRs are released by the next call to @b set_ir (or the
+        /// destructor), never by @b process
+        /// @throws ConvolverUserError if @p ir has another block size or too many partitions
+        void set_ir(std::shared_ptr<const ConvolutionIR> ir);
+
+        /// @brief Clear the delay line and pending output
+        void reset();
+};
+
+/**
+ * @class NonUniformConvolver
+ * @brief Convolves several channels with a long IR at zero latency, using worker threads for the tail
+ *
+ * The IR is split into segments whose partitions grow by 4x: the head
+ * uses partitions of one block and is computed in @b process, so the
+ * direct sound has no added latency. Each following segment, with
+ * partitions of P = 4B, 16B, ... samples, starts 2P into the IR: its
+ * input is complete P samples before its output is needed, so it is
+ * computed on a worker @b Thread while further blocks play.
+ *
+ * Workers always take the pending job with the earliest deadline. A job
+ * that isn't finished when its output is due is dropped (that segment
+ * is silent for one period) and counted in @b missed_blocks.
+ *
+ * All channels share the segment spectra and are computed by the same
+ * job. Nothing is allocated after construction.
+ *
+ * @note @b process must be called with exactly @b block_size frames
+ */
+class NonUniformConvolver {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /**
+         * @struct Options
+         * @brief Partitioning and worker threads
+         */
+        struct Options {
+            /// Largest partition, in samples; the last segment uses as many as it needs
+            size_t           max_partition = 16384;
+            /// Worker threads computing the tail segments
+            unsigned         threads       = 2;
+            /// Priority of the workers, below the audio thread's
+            Thread::Priority priority      = Thread::HIGH;
+        };
+
+        /// @brief Convolve @p channels channels with @p length samples of @p ir
+        /// @throws ConvolverUserError if @p ir is empty or the sizes are not supported
+        /// @throws ThreadUserError or ThreadRuntimeError if a worker can't be set up; those already set up are joined first
+        NonUniformConvolver(const float* ir, size_t length, size_t block_size, unsigned channels);
+
+        /// @brief Convolve with @p options
+        /// @throws ConvolverUserError if @p ir is empty, the sizes are not supported, or it needs workers and
+        ///         @b Options::threads is 0
+        /// @throws ThreadUserError or ThreadRuntimeError if a worker can't be set up; those already set up are joined first
+        NonUniformConvolver(const float* ir, size_t length, size_t block_size, unsigned channels, const Options& options);
+
+        /// @brief Stops the worker threads
+        ~NonUniformConvolver();
+
+        NonUniformConvolver(const NonUniformConvolver&) = delete;
+        NonUniformConvolver& operator=(const NonUniformConvolver&) = delete;
+
+        /// @brief Frames per call to @b process
+        size_t block_size() const;
+
+        /// @brief Number of segments, including the head
+        size_t segments() const;
+
+        /// @brief Blocks of tail output dropped because a worker missed its deadline
+        uint64_t missed_blocks() const;
+
+        /// @brief Filter one block from each channel of @p in into @p out
+        /// @p in and @p out may be the same buffers
+        /// @throws ConvolverUserError if @p frames is not @b block_size
+        void process(const float* const* in, float* const* out, size_t frames);
+};
+
+#endif // SIMPLY_CONVOLVER_HPP_
@@ -0,0 +1,231 @@
+#include "delay.hpp"
+#include "memory.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static const size_t TAIL = 3; // extra samples a 4-point read needs past its window
+
+// Cubic Hermite (Catmull-Rom) weights of x[-1], x[0], x[1], x[2] at u in [0, 1)
+static void hermite_weights(float u, float* w) {
+    float u2 = u * u;
+    float u3 = u2 * u;
+    w[0] = -0.5f * u3 + u2 - 0.5f * u;
+    w[1] =  1.5f * u3 - 2.5f * u2 + 1.0f;
+    w[2] = -1.5f * u3 + 2.0f * u2 + 0.5f * u;
+    w[3] =  0.5f * u3 - 0.5f * u2;
+}
+
+// ====== DelayLine Implementation ======
+struct DelayLine::Impl {
+    size_t               longest;
+    size_t               block;
+    size_t               length;   // power of two
+    size_t               mask;
+    size_t               mirror;   // samples copied past the end
+    size_t               pos = 0;  // next sample to write, in [0, length)
+    AlignedBuffer<float> buf;      // length + mirror
+
+    Impl(size_t max_delay, const Options& options):
+        longest(max_delay), block(std::max<size_t>(options.max_block, 1)) {
+        mirror = block + TAIL;
+        length = 1;
+        while ( length < longest + block + TAIL + 1 )
+            length <<= 1;
+        mask = length - 1;
+        buf.allocate(length + mirror);
+    }
+
+    void check(size_t frames) const {
+        if ( frames > block )
+            throw DelayUserError("Block is larger than Options::max_block!");
+    }
+
+    void write(const float* in, size_t frames) {
+        check(frames);
+        while ( frames ) {
+            size_t n = std::min(frames, length - pos);
+            std::copy(in, in + n, buf.data() + pos);
+            if ( pos < mirror )
+                std::copy(in, in + std::min(n, mirror - pos), buf.data() + length + pos);
+            pos     = (pos + n) & mask;
+            in     += n;
+            frames -= n;
+        }
+    }
+
+    // Contiguous window whose element i is the sample @p offset before
+    // output i of a read of @p frames frames
+    const float* window(size_t offset, size_t frames) const {
+        return buf.data() + ((pos - frames - offset) & mask);
+    }
+
+    void read_fixed(float delay, float* out, size_t frames, Interpolation interpolation) const {
+        check(frames);
+        float  lowest = interpolation == HERMITE ? 1.0f : 0.0f;
+        float  d      = std::min(std::max(delay, lowest), static_cast<float>(longest));
+        size_t whole  = static_cast<size_t>(d);
+        float  frac   = d - whole;
+
+        size_t i = 0;
+        if ( interpolation == LINEAR ) {
+            // y[i] = (1 - frac) x[i - whole] + frac x[i - whole - 1]
+            const float* x  = window(whole + 1, frames);
+            float4       w0 = float4::broadcast(frac);
+            float4       w1 = float4::broadcast(1.0f - frac);
+            for ( ; i + 4 <= frames; i += 4 )
+                float4::mul_add(w0, float4::load(x + i), w1 * float4::load(x + i + 1)).store(out + i);
+            for ( ; i < frames; i++ )
+                out[i] = frac * x[i] + (1.0f - frac) * x[i + 1];
+            return;
+        }
+
+        // Points x[i - whole - 2 .. i - whole + 1], at 1 - frac past the second
+        const float* x = window(whole + 2, frames);
+        float w[4];
+        hermite_weights(1.0f - frac, w);
+        float4 h0 = float4::broadcast(w[0]), h1 = float4::broadcast(w[1]);
+        float4 h2 = float4::broadcast(w[2]), h3 = float4::broadcast(w[3]);
+        for ( ; i + 4 <= frames; i += 4 ) {
+            float4 a = float4::mul_add(h0, float4::load(x + i), h1 * float4::load(x + i + 1));
+            float4 b = float4::mul_add(h2, float4::load(x + i + 2), h3 * float4::load(x + i + 3));
+            (a + b).store(out + i);
+        }
+        for ( ; i < frames; i++ )
+            out[i] = w[0] * x[i] + w[1] * x[i + 1] + w[2] * x[i + 2] + w[3] * x[i + 3];
+    }
+
+    void read_whole(size_t delay, float* out, size_t frames) const {
+        check(frames);
+        const float* x = window(std::min(delay, longest), frames);
+        std::copy(x, x + frames, out);
+    }
+
+    void read_modulated(const float* delays, float* out, size_t frames, Interpolation interpolation) const {
+        check(frames);
+        float        lowest = interpolation == HERMITE ? 1.0f : 0.0f;
+        float        top    = static_cast<float>(longest);
+        const float* base   = buf.data();
+        size_t       start  = pos - frames; // unmasked; indices are masked below
+
+        // Point to the 4 points of output j, returning the fraction past the second
+        auto locate = [&](size_t j, const float*& x) {
+            float d     = std::min(std::max(delays[j], lowest), top);
+            int   whole = static_cast<int>(d); // cheaper than converting to size_t
+            x = base + ((start + j - whole - 2) & mask);
+            return 1.0f - (d - whole);
+        };
+
+        for ( size_t i = 0; i < frames; i += 4 ) {
+            // Spare lanes of the last vector repeat the last output
+            size_t       n = std::min<size_t>(4, frames - i);
+            const float *p0, *p1, *p2, *p3;
+            float u0 = locate(i, p0);
+            float u1 = locate(i + std::min<size_t>(1, n - 1), p1);
+            float u2 = locate(i + std::min<size_t>(2, n - 1), p2);
+            float u3 = locate(i + std::min<size_t>(3, n - 1), p3);
+
+            // Each lane loads its 4 points in one go, contiguous thanks to
+            // the mirror, and a transpose turns them into one vector per point
+            float4 x0 = float4::load(p0), x1 = float4::load(p1);
+            float4 x2 = float4::load(p2), x3 = float4::load(p3);
+            transpose4(x0, x1, x2, x3);
+
+            float4 uu = float4::set(u0, u1, u2, u3);
+            float4 y;
+            if ( interpolation == LINEAR ) {
+                // Between x[-1 - whole] and x[-whole], u from the earlier
+                y = float4::mul_add(uu, x2 - x1, x1);
+            } else {
+                float4 half = float4::broadcast(0.5f);
+                float4 c1 = half * (x2 - x0);
+                float4 c2 = x0 - float4::broadcast(2.5f) * x1 + float4::broadcast(2.0f) * x2 - half * x3;
+                float4 c3 = half * (x3 - x0) + float4::broadcast(1.5f) * (x1 - x2);
+                y = float4::mul_add(float4::mul_add(float4::mul_add(c3, uu, c2), uu, c1), uu, x1);
+            }
+
+            if ( n == 4 ) {
+                y.store(out + i);
+            } else {
+                float lanes[4];
+                y.store(lanes);
+                std::copy(lanes, lanes + n, out + i);
+            }
+        }
+    }
+
+    void read_thiran(float delay, float* out, size_t frames, ThiranState& state) const {
+        check(frames);
+        float d = std::min(std::max(delay, 0.5f), static_cast<float>(longest));
+
+        // Integer delay plus an allpass delay in [0.5, 1.5), where the
+        // first-order Thiran is accurate and stable
+        size_t whole = static_cast<size_t>(d - 0.5f);
+        float  frac  = d - whole;
+        float  a     = (1.0f - frac) / (1.0f + frac);
+
+        // s[i] = x[i - whole]; u[i] = a s[i] + s[i - 1]; y[i] = u[i] - a y[i - 1]
+        const float* s = window(whole + 1, frames); // s[i] is at s + i + 1
+        float4 va  = float4::broadcast(a);
+        float4 na  = float4::broadcast(-a);
+        float4 a2  = float4::broadcast(a * a);
+        float4 pow = float4::set(-a, a * a, -a * a * a, a * a * a * a);
+        float4 y   = float4::broadcast(state.y);
+
+        size_t i = 0;
+        for ( ; i + 4 <= frames; i += 4 ) {
+            float4 u = float4::mul_add(va, float4::load(s + i + 1), float4::load(s + i));
+            // Prefix scan of the recursion over 4 lanes, then the carry-in
+            u = float4::mul_add(na, u.shift1(), u);
+            u = float4::mul_add(a2, u.shift2(), u);
+            y = float4::mul_add(pow, y.dup_last(), u);
+            y.store(out + i);
+        }
+        float last = i ? out[i - 1] : state.y;
+        for ( ; i < frames; i++ )
+            out[i] = last = a * s[i + 1] + s[i] - a * last;
+        state.y = last;
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- DelayLine Class Methods --- -------------------------------------
+DelayLine::DelayLine(size_t max_delay): DelayLine(max_delay, Options()) {}
+
+DelayLine::DelayLine(size_t max_delay, const Options& options): pimpl(new Impl(max_delay, options)) {}
+
+DelayLine::~DelayLine() = default;
+
+size_t DelayLine::max_delay() const {
+    return pimpl->longest;
+}
+
+size_t DelayLine::max_block() const {
+    return pimpl->block;
+}
+
+void DelayLine::write(const float* in, size_t frames) {
+    pimpl->write(in, frames);
+}
+
+void DelayLine::read(float delay, float* out, size_t frames, Interpolation interpolation) const {
+    pimpl->read_fixed(delay, out, frames, interpolation);
+}
+
+void DelayLine::read(const float* delays, float* out, size_t frames, Interpolation interpolation) const {
+    pimpl->read_modulated(delays, out, frames, interpolation);
+}
+
+void DelayLine::read_whole(size_t delay, float* out, size_t frames) const {
+    pimpl->read_whole(delay, out, frames);
+}
+
+void DelayLine::read_thiran(float delay, float* out, size_t frames, ThiranState& state) const {
+    pimpl->read_thiran(delay, out, frames, state);
+}
+
+void DelayLine::reset() {
+    pimpl->buf.zero();
+    pimpl->pos = 0;
+}
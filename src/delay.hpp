@@ -0,0 +1,138 @@
+/**
+ * @file delay.hpp
+ * @brief Provides @b DelayLine, fractional-sample delays with interpolation
+ */
+#ifndef SIMPLY_DELAY_HPP_
+#define SIMPLY_DELAY_HPP_
+
+#include <string>
+#include <exception>
+#include <memory>
+#include <cstddef>
+
+/**
+ * @class DelayException
+ * @brief This is the base class of all exceptions thrown by @b DelayLine
+ */
+class DelayException: public std::exception {
+    protected:
+        std::string msg;
+        explicit DelayException(const std::string& msg): msg(msg) {}
+
+    public:
+        /// @brief Get a message describing the error
+        /// @return NULL-terminated c-string
+        const char* what() const noexcept override { return msg.c_str(); }
+};
+
+/**
+ * @class DelayUserError
+ * @brief This means a block was larger than the line was created for
+ */
+class DelayUserError: public DelayException {
+    public:
+        explicit DelayUserError(const std::string& msg): DelayException("DelayUserError: " + msg) {}
+};
+
+/**
+ * @class DelayLine
+ * @brief One channel of history, read back at fractional delays
+ *
+ * The history is kept in a power-of-two buffer whose first
+ * @b Options::max_block + 3 samples are mirrored past its end, so any
+ * window a block can read is contiguous in memory: reads never wrap
+ * (or branch on wrapping) inside a block, and are vectorized across it.
+ *
+ * Blocks are added with @b write, and each read produces output aligned
+ * with the last @p frames samples written, delayed by @p delay samples
+ * (a delay of 0 returns the input). Delays are clamped to what the
+ * interpolation can reach: 0 (linear), 1 (Hermite) or 0.5 (Thiran) up to
+ * @b max_delay.
+ *
+ * - @b LINEAR and @b HERMITE (4-point, 3rd order) reads of a fixed delay
+ *   run as a short FIR over the block; modulated reads take one delay per
+ *   sample, for chorus, flanging and Doppler.
+ * - @b read_whole copies the samples at a whole delay, exactly, e.g. for
+ *   latency compensation.
+ * - @b read_thiran uses a first-order Thiran allpass, which has a flat
+ *   magnitude response (no high-frequency loss), suited to fixed or
+ *   slowly changing delays such as latency alignment and tuned feedback
+ *   delays. Its recursion is solved 4 samples at a time.
+ */
+class DelayLine {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /**
+         * @enum Interpolation
+         * @brief How samples between the stored ones are estimated
+         */
+        enum Interpolation {
+            /// Between the 2 nearest samples
+            LINEAR,
+            /// Cubic Hermite (Catmull-Rom) through the 4 nearest samples
+            HERMITE
+        };
+
+        /**
+         * @struct Options
+         * @brief Buffering
+         */
+        struct Options {
+            /// Largest block written or read at a time
+            size_t max_block = 1024;
+        };
+
+        /**
+         * @struct ThiranState
+         * @brief State of one Thiran-interpolated read, kept between blocks
+         */
+        struct ThiranState {
+            float y = 0.0f;
+        };
+
+        /// @brief Line able to delay by up to @p max_delay samples
+        explicit DelayLine(size_t max_delay);
+
+        /// @brief Create with @p options
+        DelayLine(size_t max_delay, const Options& options);
+
+        ~DelayLine();
+
+        DelayLine(const DelayLine&) = delete;
+        DelayLine& operator=(const DelayLine&) = delete;
+
+        /// @brief Longest delay in samples
+        size_t max_delay() const;
+
+        /// @brief Largest block in frames
+        size_t max_block() const;
+
+        /// @brief Append @p frames samples
+        /// @throws DelayUserError if @p frames exceeds @b Options::max_block
+        void write(const float* in, size_t frames);
+
+        /// @brief Read the last @p frames samples written, delayed by @p delay samples
+        /// @throws DelayUserError if @p frames exceeds @b Options::max_block
+        void read(float delay, float* out, size_t frames, Interpolation interpolation=HERMITE) const;
+
+        /// @brief Read the last @p frames samples written, each delayed by its own @p delays[i]
+        /// @throws DelayUserError if @p frames exceeds @b Options::max_block
+        void read(const float* delays, float* out, size_t frames, Interpolation interpolation=HERMITE) const;
+
+        /// @brief Read the last @p frames samples written, delayed by exactly @p delay samples (a plain copy)
+        /// @throws DelayUserError if @p frames exceeds @b Options::max_block
+        void read_whole(size_t delay, float* out, size_t frames) const;
+
+        /// @brief Read the last @p frames samples written through a Thiran allpass
+        /// @param state State of this tap, e.g. a member of the effect reading it
+        /// @throws DelayUserError if @p frames exceeds @b Options::max_block
+        void read_thiran(float delay, float* out, size_t frames, ThiranState& state) const;
+
+        /// @brief Clear the history
+        void reset();
+};
+
+#endif // SIMPLY_DELAY_HPP_
@@ -0,0 +1,289 @@
+#include "fft.hpp"
+#include "memory.hpp"
+#include "simd.hpp"
+
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// ---------------------------------------------------------------------
+// --- Helpers --- -----------------------------------------------------
+static const double PI = 3.14159265358979323846;
+
+// Complex values are interleaved (re, im) float pairs throughout
+struct Complex {
+    float re, im;
+};
+
+// Multiplies two interleaved complex values by two twiddles, given as
+// wr = (c0, c0, c1, c1) and wi = (-d0, d0, -d1, d1)
+static inline float4 cmul(float4 x, float4 wr, float4 wi) {
+    return float4::mul_add(x, wr, x.swap_pairs() * wi);
+}
+
+// ====== FftPlan Implementation ======
+struct FftPlan::Impl {
+    // One radix-4 pass, combining 4 transforms of length len
+    struct Stage {
+        size_t len;
+        size_t offset; // into twiddles, 8 * len floats per direction
+    };
+
+    size_t                n;    // real samples
+    size_t                half; // complex points, n / 2
+    bool                  radix2_first;
+
+    std::vector<uint32_t> reversed;
+    std::vector<Stage>    stages;
+
+    // Per stage and direction: w2 re, w2 im, w4 re, w4 im, each 2 * len
+    // floats in the layout cmul() expects
+    AlignedBuffer<float>  twiddles;
+
+    // W_n^k for k = 0 .. half / 2, used to split/merge the real spectrum
+    std::vector<Complex>  split;
+
+    explicit Impl(size_t size): n(size), half(size / 2) {
+        if ( n < 4 || (n & (n - 1)) )
+            throw FftUserError("Size " + std::to_string(n) + " is not a power of two of at least 4!");
+
+        unsigned bits = 0;
+        while ( (static_cast<size_t>(1) << bits) < half )
+            bits++;
+
+        reversed.resize(half);
+        for ( size_t i = 0; i < half; i++ ) {
+            size_t r = 0;
+            for ( unsigned b = 0; b < bits; b++ )
+                r |= ((i >> b) & 1) << (bits - 1 - b);
+            reversed[i] = static_cast<uint32_t>(r);
+        }
+
+        // An odd number of radix-2 levels starts with a radix-2 pass,
+        // then every radix-4 pass after the first (len 1) uses SIMD
+        radix2_first = bits & 1;
+        size_t total = 0;
+        for ( size_t len = radix2_first ? 2 : 1; len * 4 <= half; len *= 4 ) {
+            stages.push_back({ len, total });
+            total += 16 * len;
+        }
+
+        twiddles.allocate(total);
+        for ( const Stage& stage : stages ) {
+            for ( int dir = 0; dir < 2; dir++ ) {
+                double sign = dir == 0 ? -1.0 : 1.0;
+                float* w    = twiddles.data() + stage.offset + dir * 8 * stage.len;
+                for ( size_t k = 0; k < stage.len; k++ ) {
+                    double a2 = sign * 2.0 * PI * k / (2.0 * stage.len);
+                    double a4 = sign * 2.0 * PI * k / (4.0 * stage.len);
+                    float* w2r = w;
+                    float* w2i = w + 2 * stage.len;
+                    float* w4r = w + 4 * stage.len;
+                    float* w4i = w + 6 * stage.len;
+                    w2r[2 * k] = w2r[2 * k + 1] = static_cast<float>(std::cos(a2));
+                    w4r[2 * k] = w4r[2 * k + 1] = static_cast<float>(std::cos(a4));
+                    w2i[2 * k]     = static_cast<float>(-std::sin(a2));
+                    w2i[2 * k + 1] = static_cast<float>(std::sin(a2));
+                    w4i[2 * k]     = static_cast<float>(-std::sin(a4));
+                    w4i[2 * k + 1] = static_cast<float>(std::sin(a4));
+                }
+            }
+        }
+
+        split.resize(half / 2 + 1);
+        for ( size_t k = 0; k <= half / 2; k++ ) {
+            double a = -2.0 * PI * k / n;
+            split[k] = { static_cast<float>(std::cos(a)), static_cast<float>(std::sin(a)) };
+        }
+    }
+
+    // --- Complex FFT --- -------------------------------------------------
+    void permute(const float* in, float* out) const {
+        const Complex* src = reinterpret_cast<const Complex*>(in);
+        Complex*       dst = reinterpret_cast<Complex*>(out);
+        if ( in != out ) {
+            for ( size_t i = 0; i < half; i++ )
+                dst[reversed[i]] = src[i];
+            return;
+        }
+        for ( size_t i = 0; i < half; i++ ) {
+            size_t r = reversed[i];
+            if ( i < r )
+                std::swap(dst[i], dst[r]);
+        }
+    }
+
+    void radix2(float* data) const {
+        for ( size_t i = 0; i < 2 * half; i += 4 ) {
+            float ar = data[i],     ai = data[i + 1];
+            float br = data[i + 2], bi = data[i + 3];
+            data[i]     = ar + br;
+            data[i + 1] = ai + bi;
+            data[i + 2] = ar - br;
+            data[i + 3] = ai - bi;
+        }
+    }
+
+    // First radix-4 pass, where every twiddle is 1 or -/+i
+    void radix4_first(float* data, bool inverse) const {
+        Complex* z = reinterpret_cast<Complex*>(data);
+        for ( size_t i = 0; i < half; i += 4 ) {
+            Complex a0 = { z[i].re + z[i + 1].re,     z[i].im + z[i + 1].im };
+            Complex a1 = { z[i].re - z[i + 1].re,     z[i].im - z[i + 1].im };
+            Complex b0 = { z[i + 2].re + z[i + 3].re, z[i + 2].im + z[i + 3].im };
+            Complex b1 = { z[i + 2].re - z[i + 3].re, z[i + 2].im - z[i + 3].im };
+            // b1 * -i (forward) or * +i (inverse)
+            Complex r = inverse ? Complex{ -b1.im, b1.re } : Complex{ b1.im, -b1.re };
+            z[i]     = { a0.re + b0.re, a0.im + b0.im };
+            z[i + 2] = { a0.re - b0.re, a0.im - b0.im };
+            z[i + 1] = { a1.re + r.re,  a1.im + r.im };
+            z[i + 3] = { a1.re - r.re,  a1.im - r.im };
+        }
+    }
+
+    // Radix-2^2 butterflies, two complex values (one float4) at a time:
+    //   A = b0 +/- w2 b1,  B = b2 +/- w2 b3,  X = A +/- w4 B (times -/+i for odd outputs)
+    void radix4(float* data, const Stage& stage, bool inverse) const {
+        size_t       len = stage.len;
+        const float* w   = twiddles.data() + stage.offset + (inverse ? 8 * len : 0);
+        const float* w2r = w;
+        const float* w2i = w + 2 * len;
+        const float* w4r = w + 4 * len;
+        const float* w4i = w + 6 * len;
+        float4       rot = inverse ? float4::set(-1.0f, 1.0f, -1.0f, 1.0f) : float4::set(1.0f, -1.0f, 1.0f, -1.0f);
+
+        for ( size_t base = 0; base < half; base += 4 * len ) {
+            float* p0 = data + 2 * base;
+            float* p1 = p0 + 2 * len;
+            float* p2 = p1 + 2 * len;
+            float* p3 = p2 + 2 * len;
+            for ( size_t j = 0; j < 2 * len; j += 4 ) {
+                float4 tw2r = float4::load_aligned(w2r + j), tw2i = float4::load_aligned(w2i + j);
+                float4 tw4r = float4::load_aligned(w4r + j), tw4i = float4::load_aligned(w4i + j);
+
+                float4 b0 = float4::load(p0 + j);
+                float4 b1 = cmul(float4::load(p1 + j), tw2r, tw2i);
+                float4 b2 = float4::load(p2 + j);
+                float4 b3 = cmul(float4::load(p3 + j), tw2r, tw2i);
+
+                float4 a0 = b0 + b1, a1 = b0 - b1;
+                float4 c0 = cmul(b2 + b3, tw4r, tw4i);
+                float4 c1 = cmul(b2 - b3, tw4r, tw4i).swap_pairs() * rot;
+
+                (a0 + c0).store(p0 + j);
+                (a1 + c1).store(p1 + j);
+                (a0 - c0).store(p2 + j);
+                (a1 - c1).store(p3 + j);
+            }
+        }
+    }
+
+    void complex_fft(const float* in, float* out, bool inverse) const {
+        permute(in, out);
+        size_t first = 0;
+        if ( radix2_first ) {
+            radix2(out);
+        } else {
+            radix4_first(out, inverse);
+            first = 1;
+        }
+        for ( size_t s = first; s < stages.size(); s++ )
+            radix4(out, stages[s], inverse);
+    }
+
+    // --- Real Transforms --- ---------------------------------------------
+    void forward(const float* in, float* out) const {
+        complex_fft(in, out, false);
+
+        Complex* z = reinterpret_cast<Complex*>(out);
+        float dc = z[0].re + z[0].im;
+        float ny = z[0].re - z[0].im;
+        z[0] = { dc, ny };
+
+        // X[k] = E + W^k O and X[half-k] = conj(E - W^k O), where
+        // E = (Z[k] + conj Z[half-k]) / 2 and O = (Z[k] - conj Z[half-k]) / 2i
+        for ( size_t k = 1; k <= half / 2; k++ ) {
+            Complex zk = z[k], zm = z[half - k];
+            Complex e  = { 0.5f * (zk.re + zm.re), 0.5f * (zk.im - zm.im) };
+            Complex o  = { 0.5f * (zk.im + zm.im), -0.5f * (zk.re - zm.re) };
+            Complex w  = split[k];
+            Complex t  = { w.re * o.re - w.im * o.im, w.re * o.im + w.im * o.re };
+            z[half - k] = { e.re - t.re, -(e.im - t.im) };
+            z[k]        = { e.re + t.re, e.im + t.im };
+        }
+    }
+
+    void inverse(const float* in, float* out) const {
+        const Complex* x = reinterpret_cast<const Complex*>(in);
+        Complex*       z = reinterpret_cast<Complex*>(out);
+
+        // Undo the split (doubled, which the half-size inverse makes n * x)
+        Complex first = { x[0].re + x[0].im, x[0].re - x[0].im };
+        for ( size_t k = 1; k <= half / 2; k++ ) {
+            Complex xk = x[k], xm = x[half - k];
+            Complex e  = { xk.re + xm.re, xk.im - xm.im };
+            Complex d  = { xk.re - xm.re, xk.im + xm.im };
+            Complex w  = split[k];
+            Complex o  = { d.re * w.re + d.im * w.im, d.im * w.re - d.re * w.im }; // d * conj(W^k)
+            z[k]        = { e.re - o.im, e.im + o.re };
+            z[half - k] = { e.re + o.im, -e.im + o.re };
+        }
+        z[0] = first;
+
+        complex_fft(out, out, true);
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- FftPlan Class Methods --- ---------------------------------------
+std::shared_ptr<const FftPlan> FftPlan::get(size_t n) {
+    static std::mutex                                       lock;
+    static std::map<size_t, std::shared_ptr<const FftPlan>> plans;
+
+    std::lock_guard<std::mutex> guard(lock);
+    std::shared_ptr<const FftPlan>& plan = plans[n];
+    if ( !plan ) {
+        try {
+            plan = std::make_shared<const FftPlan>(n);
+        } catch ( ... ) {
+            plans.erase(n);
+            throw;
+        }
+    }
+    return plan;
+}
+
+FftPlan::FftPlan(size_t n): pimpl(new Impl(n)) {}
+
+FftPlan::~FftPlan() = default;
+
+size_t FftPlan::size() const {
+    return pimpl->n;
+}
+
+void FftPlan::forward(const float* in, float* out) const {
+    pimpl->forward(in, out);
+}
+
+void FftPlan::forward(float* data) const {
+    pimpl->forward(data, data);
+}
+
+void FftPlan::inverse(const float* in, float* out) const {
+    pimpl->inverse(in, out);
+}
+
+void FftPlan::inverse(float* data) const {
+    pimpl->inverse(data, data);
+}
+
+void FftPlan::forward(const float* const* in, float* const* out, size_t count) const {
+    for ( size_t i = 0; i < count; i++ )
+        pimpl->forward(in[i], out[i]);
+}
+
+void FftPlan::inverse(const float* const* in, float* const* out, size_t count) const {
+    for ( size_t i = 0; i < count; i++ )
+        pimpl->inverse(in[i], out[i]);
+}
@@ -0,0 +1,100 @@
+/**
+ * @file fft.hpp
+ * @brief Provides @b FftPlan, a real-input FFT with cached plans
+ */
+#ifndef SIMPLY_FFT_HPP_
+#define SIMPLY_FFT_HPP_
+
+#include <string>
+#include <exception>
+#include <memory>
+#include <cstddef>
+
+/**
+ * @class FftException
+ * @brief This is the base class of all exceptions thrown by @b FftPlan
+ */
+class FftException: public std::exception {
+    protected:
+        std::string msg;
+        explicit FftException(const std::string& msg): msg(msg) {}
+
+    public:
+        /// @brief Get a message describing the error
+        /// @return NULL-terminated c-string
+        const char* what() const noexcept override { return msg.c_str(); }
+};
+
+/**
+ * @class FftUserError
+ * @brief This means an unsupported transform size was requested
+ */
+class FftUserError: public FftException {
+    public:
+        explicit FftUserError(const std::string& msg): FftException("FftUserError: " + msg) {}
+};
+
+/**
+ * @class FftPlan
+ * @brief Real-input FFT of a fixed power-of-two size
+ *
+ * A real transform of size N is computed as a complex FFT of size N/2
+ * (even samples as real parts, odd samples as imaginary parts) followed
+ * by a split into the real spectrum. The complex FFT uses radix-4
+ * (radix-2^2) stages with SIMD butterflies, and all twiddles and the
+ * bit-reversal permutation are precomputed by the plan.
+ *
+ * Spectra are packed into N floats:
+ * `[ X[0].re, X[N/2].re, X[1].re, X[1].im, ..., X[N/2-1].re, X[N/2-1].im ]`
+ * (the DC and Nyquist bins have no imaginary part).
+ *
+ * Transforms never allocate and don't modify the plan, so one plan may
+ * be used by many threads at once, including real-time ones.
+ *
+ * @note Transforms are unscaled: @b inverse(@b forward(x)) is N * x
+ */
+class FftPlan {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /// @brief Shared plan for size @p n, created on first use
+        /// Safe to call from several threads, but may allocate: call while setting up
+        /// @throws FftUserError if @p n is not a power of two of at least 4
+        static std::shared_ptr<const FftPlan> get(size_t n);
+
+        /// @brief Plan a transform of @p n real samples
+        /// @throws FftUserError if @p n is not a power of two of at least 4
+        explicit FftPlan(size_t n);
+
+        ~FftPlan();
+
+        FftPlan(const FftPlan&) = delete;
+        FftPlan& operator=(const FftPlan&) = delete;
+
+        /// @brief Number of real samples transformed
+        size_t size() const;
+
+        /// @brief Transform @p n samples from @p in into a packed spectrum in @p out
+        /// @p in and @p out may be the same buffer
+        void forward(const float* in, float* out) const;
+
+        /// @brief Transform @p data in place
+        void forward(float* data) const;
+
+        /// @brief Transform a packed spectrum from @p in into @p n samples in @p out
+        /// @p in and @p out may be the same buffer
+        void inverse(const float* in, float* out) const;
+
+        /// @brief Inverse transform @p data in place
+        void inverse(float* data) const;
+
+        /// @brief @b forward for @p count buffers, e.g. one per channel
+        void forward(const float* const* in, float* const* out, size_t count) const;
+
+        /// @brief @b inverse for @p count buffers, e.g. one per channel
+        void inverse(const float* const* in, float* const* out, size_t count) const;
+};
+
+#endif // SIMPLY_FFT_HPP_
@@ -0,0 +1,267 @@
+#include "file.hpp"
+
+#ifdef _WIN32
+extern "C" {
+    #include <windows.h>
+}
+
+using file_t = HANDLE;
+static const file_t NO_FILE = INVALID_HANDLE_VALUE;
+
+#else
+extern "C" {
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+}
+
+using file_t = int;
+static const file_t NO_FILE = -1;
+#endif
+
+// ====== RawFile Implementation ======
+struct RawFile::Impl {
+    file_t file = NO_FILE;
+
+    bool is_open() const {
+        return file != NO_FILE;
+    }
+
+    #ifdef _WIN32
+    void open(const std::string& path, Mode mode) {
+        DWORD access      = GENERIC_READ;
+        DWORD disposition = OPEN_EXISTING;
+        if ( mode == WRITE ) {
+            access      = GENERIC_READ | GENERIC_WRITE;
+            disposition = CREATE_ALWAYS;
+        } else if ( mode == UPDATE ) {
+            access = GENERIC_READ | GENERIC_WRITE;
+        }
+        file = CreateFileA(
+            path.c_str(),          // path
+            access,                // access
+            FILE_SHARE_READ,       // others may read while recording
+            nullptr,               // security
+            disposition,           // create/open
+            FILE_ATTRIBUTE_NORMAL, // flags
+            nullptr                // template
+        );
+        if ( file == NO_FILE )
+            throw FileRuntimeError("Failed to open '" + path + "'!");
+    }
+
+    void close() {
+        if ( is_open() )
+            CloseHandle(file);
+        file = NO_FILE;
+    }
+
+    void write_at(uint64_t offset, const void* data, size_t bytes) {
+        const char* src = static_cast<const char*>(data);
+        while ( bytes > 0 ) {
+            OVERLAPPED ov = {};
+            ov.Offset     = static_cast<DWORD>(offset);
+            ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            DWORD chunk   = bytes > 0x40000000 ? 0x40000000 : static_cast<DWORD>(bytes);
+            DWORD written = 0;
+            if ( !WriteFile(file, src, chunk, &written, &ov) || written == 0 )
+                throw FileRuntimeError("Failed to write!");
+            src    += written;
+            offset += written;
+            bytes  -= written;
+        }
+    }
+
+    size_t read_at(uint64_t offset, void* data, size_t bytes) {
+        char*  dst   = static_cast<char*>(data);
+        size_t total = 0;
+        while ( bytes > 0 ) {
+            OVERLAPPED ov = {};
+            ov.Offset     = static_cast<DWORD>(offset);
+            ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            DWORD chunk   = bytes > 0x40000000 ? 0x40000000 : static_cast<DWORD>(bytes);
+            DWORD got     = 0;
+            if ( !ReadFile(file, dst, chunk, &got, &ov) ) {
+                if ( GetLastError() == ERROR_HANDLE_EOF )
+                    break;
+                throw FileRuntimeError("Failed to read!");
+            }
+            if ( got == 0 )
+                break;
+            dst    += got;
+            offset += got;
+            bytes  -= got;
+            total  += got;
+        }
+        return total;
+    }
+
+    uint64_t size() const {
+        LARGE_INTEGER sz;
+        if ( !GetFileSizeEx(file, &sz) )
+            throw FileRuntimeError("Failed to get file size!");
+        return static_cast<uint64_t>(sz.QuadPart);
+    }
+
+    void preallocate(uint64_t bytes) {
+        FILE_ALLOCATION_INFO info;
+        info.AllocationSize.QuadPart = static_cast<LONGLONG>(bytes);
+        SetFileInformationByHandle(file, FileAllocationInfo, &info, sizeof(info));
+    }
+
+    void truncate(uint64_t bytes) {
+        LARGE_INTEGER pos;
+        pos.QuadPart = static_cast<LONGLONG>(bytes);
+        if ( !SetFilePointerEx(file, pos, nullptr, FILE_BEGIN) || !SetEndOfFile(file) )
+            throw FileRuntimeError("Failed to truncate!");
+    }
+
+    void flush() {
+        if ( !FlushFileBuffers(file) )
+            throw FileRuntimeError("Failed to flush!");
+    }
+    #else
+    void open(const std::string& path, Mode mode) {
+        int flags = O_RDONLY;
+        if ( mode == WRITE )
+            flags = O_RDWR | O_CREAT | O_TRUNC;
+        else if ( mode == UPDATE )
+            flags = O_RDWR;
+        file = ::open(path.c_str(), flags, 0644);
+        if ( file == NO_FILE )
+            throw FileRuntimeError("Failed to open '" + path + "'!");
+    }
+
+    void close() {
+        if ( is_open() )
+            ::close(file);
+        file = NO_FILE;
+    }
+
+    void write_at(uint64_t offset, const void* data, size_t bytes) {
+        const char* src = static_cast<const char*>(data);
+        while ( bytes > 0 ) {
+            ssize_t written = ::pwrite(file, src, bytes, static_cast<off_t>(offset));
+            if ( written <= 0 )
+                throw FileRuntimeError("Failed to write!");
+            src    += written;
+            offset += written;
+            bytes  -= written;
+        }
+    }
+
+    size_t read_at(uint64_t offset, void* data, size_t bytes) {
+        char*  dst   = static_cast<char*>(data);
+        size_t total = 0;
+        while ( bytes > 0 ) {
+            ssize_t got = ::pread(file, dst, bytes, static_cast<off_t>(offset));
+            if ( got < 0 )
+                throw FileRuntimeError("Failed to read!");
+            if ( got == 0 )
+                break;
+            dst    += got;
+            offset += got;
+            bytes  -= got;
+            total  += got;
+        }
+        return total;
+    }
+
+    uint64_t size() const {
+        struct stat st;
+        if ( ::fstat(file, &st) != 0 )
+            throw FileRuntimeError("Failed to get file size!");
+        return static_cast<uint64_t>(st.st_size);
+    }
+
+    void preallocate(uint64_t bytes) {
+        #ifdef __linux__
+        ::fallocate(file, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(bytes));
+        #else
+        (void) bytes;
+        #endif
+    }
+
+    void truncate(uint64_t bytes) {
+        if ( ::ftruncate(file, static_cast<off_t>(bytes)) != 0 )
+            throw FileRuntimeError("Failed to truncate!");
+    }
+
+    void flush() {
+        if ( ::fsync(file) != 0 )
+            throw FileRuntimeError("Failed to flush!");
+    }
+    #endif // _WIN32
+
+    ~Impl() {
+        close();
+    }
+};
+
+// ====== RawFile Class Methods ======
+RawFile::RawFile() = default;
+
+RawFile::RawFile(const std::string& path, Mode mode) {
+    open(path, mode);
+}
+
+RawFile::~RawFile() = default;
+
+RawFile::RawFile(RawFile&& o) {
+    pimpl = std::move(o.pimpl);
+}
+
+RawFile& RawFile::operator=(RawFile&& o) {
+    pimpl = std::move(o.pimpl);
+    return *this;
+}
+
+void RawFile::open(const std::string& path, Mode mode) {
+    auto impl = std::make_unique<Impl>();
+    impl->open(path, mode);
+    pimpl = std::move(impl);
+}
+
+void RawFile::close() {
+    pimpl = nullptr;
+}
+
+bool RawFile::is_open() const {
+    return pimpl && pimpl->is_open();
+}
+
+void RawFile::write_at(uint64_t offset, const void* data, size_t bytes) {
+    if ( !is_open() )
+        throw FileUserError("Cannot write without a file!");
+    pimpl->write_at(offset, data, bytes);
+}
+
+size_t RawFile::read_at(uint64_t offset, void* data, size_t bytes) {
+    if ( !is_open() )
+        throw FileUserError("Cannot read without a file!");
+    return pimpl->read_at(offset, data, bytes);
+}
+
+uint64_t RawFile::size() const {
+    if ( !is_open() )
+        throw FileUserError("No file!");
+    return pimpl->size();
+}
+
+void RawFile::preallocate(uint64_t bytes) {
+    if ( !is_open() )
+        throw FileUserError("Cannot preallocate without a file!");
+    pimpl->preallocate(bytes);
+}
+
+void RawFile::truncate(uint64_t bytes) {
+    if ( !is_open() )
+        throw FileUserError("Cannot truncate without a file!");
+    pimpl->truncate(bytes);
+}
+
+void RawFile::flush() {
+    if ( !is_open() )
+        throw FileUserError("Cannot flush without a file!");
+    pimpl->flush();
+}
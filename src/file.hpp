@@ -0,0 +1,122 @@
+/**
+ * @file file.hpp
+ * @brief Provides @b RawFile, positional file IO used by the audio file formats
+ */
+#ifndef SIMPLY_FILE_HPP_
+#define SIMPLY_FILE_HPP_
+
+#include <string>
+#include <exception>
+#include <memory>
+#include <cstdint>
+
+/**
+ * @class FileException
+ * @brief This is the base class of all exceptions thrown by @b RawFile
+ */
+class FileException: public std::exception {
+    protected:
+        std::string msg;
+        explicit FileException(const std::string& msg): msg(msg) {}
+
+    public:
+        /// @brief Get a message describing the error
+        /// @return NULL-terminated c-string
+        const char* what() const noexcept override { return msg.c_str(); }
+};
+
+/**
+ * @class FileUserError
+ * @brief This means some @b RawFile operations were used in incorrect order/combination
+ */
+class FileUserError: public FileException {
+    public:
+        explicit FileUserError(const std::string& msg): FileException("FileUserError: " + msg) {}
+};
+
+/**
+ * @class FileRuntimeError
+ * @brief This means that your system failed to handle a valid file operation
+ */
+class FileRuntimeError: public FileException {
+    public:
+        explicit FileRuntimeError(const std::string& msg): FileException("FileRuntimeError: " + msg) {}
+};
+
+/**
+ * @class RawFile
+ * @brief Unbuffered file with positional reads/writes
+ *
+ * All reads and writes take an explicit offset, so headers can be
+ * patched while data keeps streaming to the end of the file without
+ * any seek bookkeeping.
+ */
+class RawFile {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /**
+         * @enum Mode
+         * @brief How the file is opened
+         */
+        enum Mode {
+            /// Open an existing file for reading
+            READ,
+            /// Create (or truncate) a file for writing
+            WRITE,
+            /// Open an existing file for reading and writing
+            UPDATE
+        };
+
+        /// @brief Construct an instance without a file
+        RawFile();
+
+        /// @brief Open @p path
+        /// @throws FileRuntimeError if the file can't be opened
+        RawFile(const std::string& path, Mode mode);
+
+        /// @brief Closes the file if still open
+        ~RawFile();
+
+        RawFile(const RawFile&) = delete;
+        RawFile& operator=(const RawFile&) = delete;
+
+        /// @brief Move constructor
+        RawFile(RawFile&& o);
+
+        /// @brief Move operator, closing any currently open file
+        RawFile& operator=(RawFile&& o);
+
+        /// @brief Open @p path, closing any currently open file
+        void open(const std::string& path, Mode mode);
+
+        /// @brief Close the file
+        void close();
+
+        /// @brief Check if a file is open
+        bool is_open() const;
+
+        /// @brief Write all of @p bytes at @p offset
+        void write_at(uint64_t offset, const void* data, size_t bytes);
+
+        /// @brief Read up to @p bytes from @p offset
+        /// @return Number of bytes read, less than @p bytes only at end of file
+        size_t read_at(uint64_t offset, void* data, size_t bytes);
+
+        /// @brief Current size of the file in bytes
+        uint64_t size() const;
+
+        /// @brief Reserve disk space for @p bytes without changing the file size
+        /// Best-effort: on systems without support this does nothing
+        void preallocate(uint64_t bytes);
+
+        /// @brief Set the file size to @p bytes
+        void truncate(uint64_t bytes);
+
+        /// @brief Flush written data to the disk
+        void flush();
+};
+
+#endif // SIMPLY_FILE_HPP_
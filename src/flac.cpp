@@ -0,0 +1,718 @@
+#include "flac.hpp"
+#include "flac_common.hpp"
+#include "file.hpp"
+#include "memory.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// ---------------------------------------------------------------------
+// --- Bit Reader --- --------------------------------------------------
+// MSB-first reader over a byte range, caching up to 64 bits at a time.
+// Reads past the end return zero bits and are caught by overrun()
+class FlacBitReader {
+    private:
+        const uint8_t* data;
+        size_t         len;
+        size_t         pos   = 0; // Next byte to load into the cache
+        uint64_t       cache = 0; // Unread bits, left-aligned
+        unsigned       bits  = 0; // Number of valid bits in cache
+
+        void refill() {
+            if ( pos + 8 <= len ) {
+                uint64_t v = 0;
+                for ( int i = 0; i < 8; i++ )
+                    v = (v << 8) | data[pos + i];
+                unsigned n = (64 - bits) >> 3;
+                v &= ~0ull << (64 - n * 8);
+                cache |= v >> bits;
+                bits  += n * 8;
+                pos   += n;
+                return;
+            }
+            while ( bits <= 56 ) {
+                uint64_t byte = pos < len ? data[pos] : 0;
+                cache |= byte << (56 - bits);
+                bits  += 8;
+                pos   += 1;
+            }
+        }
+
+    public:
+        FlacBitReader(const uint8_t* data, size_t len): data(data), len(len) {}
+
+        // n must be in [0, 32]
+        uint32_t read(unsigned n) {
+            if ( n == 0 )
+                return 0;
+            if ( bits < n )
+                refill();
+            uint32_t v = static_cast<uint32_t>(cache >> (64 - n));
+            cache <<= n;
+            bits   -= n;
+            return v;
+        }
+
+        int32_t read_signed(unsigned n) {
+            return n ? static_cast<int32_t>(flac_sign_extend(read(n), n)) : 0;
+        }
+
+        // Counts the 0 bits before the next 1 bit, using count-leading-
+        // zeros on the whole cache instead of testing bit by bit
+        uint32_t read_unary() {
+            uint32_t q = 0;
+            while ( true ) {
+                if ( cache != 0 ) {
+                    unsigned z = static_cast<unsigned>(flac_clz64(cache));
+                    if ( z < bits ) {
+                        cache <<= z;
+                        cache <<= 1;
+                        bits   -= z + 1;
+                        return q + z;
+                    }
+                }
+                q    += bits;
+                cache = 0;
+                bits  = 0;
+                if ( overrun() )
+                    throw FlacRuntimeError("Truncated frame!");
+                refill();
+            }
+        }
+
+        // Decodes @p count zig-zag Rice codes with parameter @p k
+        void read_rice(int32_t* dst, size_t count, unsigned k) {
+            for ( size_t i = 0; i < count; i++ ) {
+                // Two statements: the order of operands within one expression is unspecified
+                uint32_t q = read_unary();
+                uint32_t u = (q << k) | read(k);
+                dst[i] = static_cast<int32_t>(u >> 1) ^ -static_cast<int32_t>(u & 1);
+            }
+        }
+
+        void align() {
+            unsigned drop = bits & 7;
+            cache <<= drop;
+            bits   -= drop;
+        }
+
+        // Bytes consumed so far, only exact when aligned
+        size_t byte_pos() const {
+            return pos - bits / 8;
+        }
+
+        bool overrun() const {
+            return byte_pos() > len;
+        }
+};
+
+// ---------------------------------------------------------------------
+// --- Frame Header --- ------------------------------------------------
+struct FlacFrameHeader {
+    uint32_t block_size   = 0;
+    unsigned assignment   = 0; // Channel assignment code
+    unsigned channels     = 0;
+    unsigned bps          = 0;
+    uint64_t first_sample = 0;
+    size_t   header_bytes = 0;
+};
+
+// Parses and CRC-8 checks the frame header at @p p
+// @return false if there is no valid frame header at @p p
+static bool parse_frame_header(const uint8_t* p, size_t avail, const FlacInfo& info, FlacFrameHeader& h) {
+    if ( avail < 6 || p[0] != 0xFF || (p[1] & 0xFE) != 0xF8 )
+        return false;
+    bool     variable = p[1] & 1;
+    unsigned bs_code  = p[2] >> 4;
+    unsigned sr_code  = p[2] & 15;
+    unsigned ch_code  = p[3] >> 4;
+    unsigned ss_code  = (p[3] >> 1) & 7;
+    if ( bs_code == 0 || sr_code == 15 || ch_code > FLAC_MID_SIDE || ss_code == 3 || (p[3] & 1) )
+        return false;
+
+    // UTF-8 style coded frame/sample number
+    size_t   i     = 4;
+    uint64_t coded = p[i++];
+    if ( coded & 0x80 ) {
+        unsigned extra = 0;
+        while ( extra < 7 && (coded & (0x40 >> extra)) )
+            extra++;
+        if ( extra == 0 || extra > 6 || i + extra > avail )
+            return false;
+        coded &= 0x3F >> extra;
+        for ( unsigned e = 0; e < extra; e++, i++ ) {
+            if ( (p[i] & 0xC0) != 0x80 )
+                return false;
+            coded = (coded << 6) | (p[i] & 0x3F);
+        }
+    }
+
+    if ( i + 5 > avail )
+        return false;
+    if ( bs_code == 1 )
+        h.block_size = 192;
+    else if ( bs_code <= 5 )
+        h.block_size = 576u << (bs_code - 2);
+    else if ( bs_code == 6 )
+        h.block_size = p[i++] + 1u;
+    else if ( bs_code == 7 ) {
+        h.block_size = ((p[i] << 8) | p[i + 1]) + 1u;
+        i += 2;
+    } else
+        h.block_size = 256u << (bs_code - 8);
+
+    // The rate itself isn't needed, only its length in the header
+    if ( sr_code == 12 )
+        i += 1;
+    else if ( sr_code == 13 || sr_code == 14 )
+        i += 2;
+
+    if ( i >= avail || flac_crc8(p, i) != p[i] )
+        return false;
+    h.header_bytes = i + 1;
+
+    h.assignment = ch_code;
+    h.channels   = ch_code < FLAC_LEFT_SIDE ? ch_code + 1 : 2;
+    h.bps        = ss_code ? FLAC_SAMPLE_SIZES[ss_code] : info.bits_per_sample;
+    if ( variable ) {
+        h.first_sample = coded;
+    } else {
+        // Fixed-blocksize streams number frames instead of samples
+        uint32_t fixed = info.min_block == info.max_block ? info.max_block : h.block_size;
+        h.first_sample = coded * fixed;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------
+// --- Prediction --- --------------------------------------------------
+// Both restore in place: on entry out[order..n) holds the residual
+static void restore_fixed(int32_t* out, size_t n, unsigned order) {
+    switch ( order ) {
+        case 0:
+            break;
+        case 1:
+            for ( size_t i = 1; i < n; i++ )
+                out[i] += out[i - 1];
+            break;
+        case 2:
+            for ( size_t i = 2; i < n; i++ )
+                out[i] += 2 * out[i - 1] - out[i - 2];
+            break;
+        case 3:
+            for ( size_t i = 3; i < n; i++ )
+                out[i] += 3 * out[i - 1] - 3 * out[i - 2] + out[i - 3];
+            break;
+        case 4:
+            for ( size_t i = 4; i < n; i++ )
+                out[i] += 4 * out[i - 1] - 6 * out[i - 2] + 4 * out[i - 3] - out[i - 4];
+            break;
+    }
+}
+
+// The coefficients are stored reversed so the history is walked
+// forwards in memory; this keeps the inner product a plain contiguous
+// multiply-accumulate, which the compiler turns into vector code
+template <typename Acc>
+static void restore_lpc_impl(int32_t* out, size_t n, const int32_t* rev, unsigned order, int shift) {
+    for ( size_t i = order; i < n; i++ ) {
+        const int32_t* hist = out + i - order;
+        Acc sum = 0;
+        for ( unsigned j = 0; j < order; j++ )
+            sum += static_cast<Acc>(rev[j]) * hist[j];
+        out[i] += static_cast<int32_t>(sum >> shift);
+    }
+}
+
+static void restore_lpc(int32_t* out, size_t n, const int32_t* coefs, unsigned order,
+                        int shift, unsigned bps, unsigned precision) {
+    int32_t rev[32];
+    for ( unsigned j = 0; j < order; j++ )
+        rev[j] = coefs[order - 1 - j];
+    unsigned log2_order = 0;
+    while ( (1u << log2_order) < order )
+        log2_order++;
+    // Only widen the accumulator when the sum could overflow 32 bits
+    if ( bps + precision + log2_order <= 32 )
+        restore_lpc_impl<int32_t>(out, n, rev, order, shift);
+    else
+        restore_lpc_impl<int64_t>(out, n, rev, order, shift);
+}
+
+// ---------------------------------------------------------------------
+// --- FlacDecoder Implementation --- ----------------------------------
+struct FlacIndexEntry {
+    uint64_t sample;
+    uint64_t offset;
+};
+
+// Persisted index layout, all little-endian:
+//   "SFIX" | version u32 | file size u64 | total frames u64 | count u64
+//   followed by count * (sample u64, offset u64)
+static const uint32_t INDEX_VERSION = 1;
+static const size_t   INDEX_HEADER  = 32;
+
+static void put_le64(uint8_t* p, uint64_t v) {
+    for ( int i = 0; i < 8; i++ )
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+static uint64_t get_le64(const uint8_t* p) {
+    uint64_t v = 0;
+    for ( int i = 7; i >= 0; i-- )
+        v = (v << 8) | p[i];
+    return v;
+}
+
+struct FlacDecoder::Impl {
+    std::string path;
+    Options     opts;
+    RawFile     file;
+    FlacInfo    info;
+    uint64_t    file_size          = 0;
+    uint64_t    first_frame_offset = 0;
+
+    // Window of the file that frames are decoded from
+    AlignedBuffer<uint8_t> window;
+    uint64_t               window_offset = 0;
+    size_t                 window_len    = 0;
+    size_t                 frame_need    = 0; // Bytes that always hold a whole frame
+
+    std::vector<FlacIndexEntry> index;
+    uint64_t                    total = 0;
+
+    // The most recently decoded frame, kept as separate channels
+    AlignedBuffer<int32_t> chan[8];
+    FlacFrameHeader        cur;
+    size_t                 cur_used    = 0;
+    uint64_t               next_offset = 0;
+    uint64_t               position    = 0;
+
+    Impl(const std::string& p, const Options& o): path(p), opts(o) {
+        try {
+            file.open(path, RawFile::READ);
+            file_size = file.size();
+            parse_metadata();
+
+            frame_need = info.max_frame_bytes
+                ? info.max_frame_bytes + 64
+                : static_cast<size_t>(info.max_block) * info.channels * 4 + 1024;
+            window.allocate(std::max<size_t>(1 << 20, frame_need * 2));
+            for ( unsigned c = 0; c < info.channels; c++ )
+                chan[c].allocate(info.max_block);
+
+            if ( !(opts.persist_index && load_index()) ) {
+                build_index();
+                if ( opts.persist_index )
+                    save_index();
+            }
+        } catch ( const FileException& e ) {
+            throw FlacRuntimeError(e.what());
+        }
+        next_offset = first_frame_offset;
+    }
+
+    // Make the window cover at least @p need bytes from @p offset (or up
+    // to the end of the file)
+    const uint8_t* ensure(uint64_t offset, size_t need, size_t& avail) {
+        uint64_t window_end = window_offset + window_len;
+        bool     covered    = offset >= window_offset &&
+                              (offset + need <= window_end || window_end == file_size);
+        if ( !covered ) {
+            window_offset = offset;
+            window_len    = file.read_at(offset, window.data(), window.size());
+            window_end    = window_offset + window_len;
+        }
+        avail = offset < window_end ? static_cast<size_t>(window_end - offset) : 0;
+        return window.data() + (offset - window_offset);
+    }
+
+    void parse_metadata() {
+        uint8_t  hdr[10];
+        uint64_t offset = 0;
+        // Skip a leading ID3v2 tag, which some taggers add
+        if ( file.read_at(0, hdr, 10) == 10 && std::memcmp(hdr, "ID3", 3) == 0 ) {
+            offset = 10 + ((hdr[6] & 0x7F) << 21 | (hdr[7] & 0x7F) << 14 |
+                           (hdr[8] & 0x7F) << 7  | (hdr[9] & 0x7F));
+            if ( hdr[5] & 0x10 )
+                offset += 10;
+        }
+        if ( file.read_at(offset, hdr, 4) != 4 || std::memcmp(hdr, "fLaC", 4) != 0 )
+            throw FlacRuntimeError("'" + path + "' is not a FLAC file!");
+        offset += 4;
+
+        bool have_info = false;
+        bool last      = false;
+        while ( !last ) {
+            if ( file.read_at(offset, hdr, 4) != 4 )
+                throw FlacRuntimeError("Truncated metadata!");
+            last          = hdr[0] & 0x80;
+            unsigned type = hdr[0] & 0x7F;
+            uint32_t len  = (hdr[1] << 16) | (hdr[2] << 8) | hdr[3];
+            if ( type == 0 ) {
+                uint8_t b[34];
+                if ( len < 34 || file.read_at(offset + 4, b, 34) != 34 )
+                    throw FlacRuntimeError("Truncated STREAMINFO!");
+                info.min_block       = static_cast<uint16_t>((b[0] << 8) | b[1]);
+                info.max_block       = static_cast<uint16_t>((b[2] << 8) | b[3]);
+                info.max_frame_bytes = (b[7] << 16) | (b[8] << 8) | b[9];
+                info.sample_rate     = (b[10] << 12) | (b[11] << 4) | (b[12] >> 4);
+                info.channels        = static_cast<uint16_t>(((b[12] >> 1) & 7) + 1);
+                info.bits_per_sample = static_cast<uint16_t>((((b[12] & 1) << 4) | (b[13] >> 4)) + 1);
+                info.total_frames    = (static_cast<uint64_t>(b[13] & 15) << 32) |
+                                       (static_cast<uint64_t>(b[14]) << 24) |
+                                       (b[15] << 16) | (b[16] << 8) | b[17];
+                std::memcpy(info.md5, b + 18, 16);
+                have_info = true;
+            }
+            offset += 4 + len;
+        }
+        if ( !have_info )
+            throw FlacRuntimeError("Missing STREAMINFO!");
+        if ( info.max_block < 16 || info.bits_per_sample < 4 )
+            throw FlacRuntimeError("Invalid STREAMINFO!");
+        first_frame_offset = offset;
+    }
+
+    // ====== Seek Index ======
+    // Walks the file from frame header to frame header. The next header
+    // is found by searching for the sync code, and only accepted if its
+    // CRC-8 holds and it starts exactly where the previous frame ended,
+    // which rules out sync codes that happen to appear in the audio
+    void build_index() {
+        index.clear();
+        uint64_t offset   = first_frame_offset;
+        uint64_t expected = 0;
+        while ( offset < file_size ) {
+            size_t          avail;
+            const uint8_t*  p = ensure(offset, 32, avail);
+            FlacFrameHeader h;
+            if ( !parse_frame_header(p, avail, info, h) || h.first_sample != expected ) {
+                if ( index.empty() )
+                    throw FlacRuntimeError("No frame at the end of the metadata!");
+                break;
+            }
+            index.push_back({expected, offset});
+            expected += h.block_size;
+
+            uint64_t search = offset + h.header_bytes;
+            offset = file_size;
+            while ( search + 1 < file_size ) {
+                p = ensure(search, 1 << 16, avail);
+                if ( avail < 2 )
+                    break;
+                const uint8_t* hit = static_cast<const uint8_t*>(std::memchr(p, 0xFF, avail - 1));
+                if ( !hit ) {
+                    search += avail - 1;
+                    continue;
+                }
+                size_t i = static_cast<size_t>(hit - p);
+                if ( (p[i + 1] & 0xFE) == 0xF8 ) {
+                    // Move the window up if the header might be cut off
+                    if ( avail - i < 32 && search + avail < file_size ) {
+                        search += i;
+                        ensure(search, 1 << 16, avail);
+                        continue;
+                    }
+                    FlacFrameHeader next;
+                    if ( parse_frame_header(p + i, avail - i, info, next) && next.first_sample == expected ) {
+                        offset = search + i;
+                        break;
+                    }
+                }
+                search += i + 1;
+            }
+        }
+        total = expected;
+    }
+
+    std::string index_path() const {
+        return path + ".sfidx";
+    }
+
+    bool load_index() {
+        try {
+            RawFile f(index_path(), RawFile::READ);
+            uint8_t hdr[INDEX_HEADER];
+            if ( f.read_at(0, hdr, INDEX_HEADER) != INDEX_HEADER || std::memcmp(hdr, "SFIX", 4) != 0 )
+                return false;
+            uint32_t version = hdr[4] | (hdr[5] << 8) | (hdr[6] << 16) | (static_cast<uint32_t>(hdr[7]) << 24);
+            uint64_t count   = get_le64(hdr + 24);
+            // A changed file invalidates the index
+            if ( version != INDEX_VERSION || get_le64(hdr + 8) != file_size || count == 0 ||
+                 f.size() != INDEX_HEADER + count * 16 )
+                return false;
+            std::vector<uint8_t> raw(static_cast<size_t>(count * 16));
+            if ( f.read_at(INDEX_HEADER, raw.data(), raw.size()) != raw.size() )
+                return false;
+            index.resize(static_cast<size_t>(count));
+            for ( size_t i = 0; i < index.size(); i++ ) {
+                index[i].sample = get_le64(&raw[i * 16]);
+                index[i].offset = get_le64(&raw[i * 16 + 8]);
+            }
+            total = get_le64(hdr + 16);
+            return true;
+        } catch ( const FileException& ) {
+            return false;
+        }
+    }
+
+    // Best-effort: a read-only directory just means no saved index
+    void save_index() {
+        std::vector<uint8_t> raw(INDEX_HEADER + index.size() * 16);
+        std::memcpy(raw.data(), "SFIX", 4);
+        raw[4] = static_cast<uint8_t>(INDEX_VERSION);
+        put_le64(&raw[8], file_size);
+        put_le64(&raw[16], total);
+        put_le64(&raw[24], index.size());
+        for ( size_t i = 0; i < index.size(); i++ ) {
+            put_le64(&raw[INDEX_HEADER + i * 16], index[i].sample);
+            put_le64(&raw[INDEX_HEADER + i * 16 + 8], index[i].offset);
+        }
+        try {
+            RawFile f(index_path(), RawFile::WRITE);
+            f.write_at(0, raw.data(), raw.size());
+        } catch ( const FileException& ) { ; }
+    }
+
+    // ====== Frame Decoding ======
+    void decode_residual(FlacBitReader& br, int32_t* out, size_t n, unsigned order) {
+        unsigned method = br.read(2);
+        if ( method > 1 )
+            throw FlacRuntimeError("Reserved residual coding method!");
+        unsigned param_bits = method ? 5 : 4;
+        unsigned escape     = method ? 31 : 15;
+        unsigned porder     = br.read(4);
+        size_t   part_size  = n >> porder;
+        if ( (part_size << porder) != n || part_size < order )
+            throw FlacRuntimeError("Invalid residual partition order!");
+
+        size_t i = order;
+        for ( size_t part = 0; part < (size_t(1) << porder); part++ ) {
+            size_t   count = part == 0 ? part_size - order : part_size;
+            unsigned k     = br.read(param_bits);
+            if ( k == escape ) {
+                unsigned raw = br.read(5);
+                for ( size_t j = 0; j < count; j++ )
+                    out[i + j] = br.read_signed(raw);
+            } else {
+                br.read_rice(out + i, count, k);
+            }
+            i += count;
+        }
+    }
+
+    void decode_subframe(FlacBitReader& br, int32_t* out, size_t n, unsigned bps) {
+        if ( br.read(1) )
+            throw FlacRuntimeError("Corrupt subframe header!");
+        unsigned type   = br.read(6);
+        unsigned wasted = 0;
+        if ( br.read(1) ) {
+            wasted = br.read_unary() + 1;
+            if ( wasted >= bps )
+                throw FlacRuntimeError("Invalid wasted bits!");
+            bps -= wasted;
+        }
+
+        if ( type == 0 ) {
+            int32_t v = br.read_signed(bps);
+            std::fill(out, out + n, v);
+        } else if ( type == 1 ) {
+            for ( size_t i = 0; i < n; i++ )
+                out[i] = br.read_signed(bps);
+        } else if ( type >= 8 && type <= 12 ) {
+            unsigned order = type - 8;
+            if ( order > n )
+                throw FlacRuntimeError("Predictor order exceeds block size!");
+            for ( unsigned i = 0; i < order; i++ )
+                out[i] = br.read_signed(bps);
+            decode_residual(br, out, n, order);
+            restore_fixed(out, n, order);
+        } else if ( type >= 32 ) {
+            unsigned order = type - 31;
+            if ( order > n )
+                throw FlacRuntimeError("Predictor order exceeds block size!");
+            for ( unsigned i = 0; i < order; i++ )
+                out[i] = br.read_signed(bps);
+            unsigned precision = br.read(4) + 1;
+            if ( precision == 16 )
+                throw FlacRuntimeError("Invalid LPC precision!");
+            int shift = br.read_signed(5);
+            if ( shift < 0 )
+                throw FlacRuntimeError("Negative LPC shift!");
+            int32_t coefs[32];
+            for ( unsigned i = 0; i < order; i++ )
+                coefs[i] = br.read_signed(precision);
+            decode_residual(br, out, n, order);
+            restore_lpc(out, n, coefs, order, shift, bps, precision);
+        } else {
+            throw FlacRuntimeError("Reserved subframe type!");
+        }
+
+        if ( wasted )
+            for ( size_t i = 0; i < n; i++ )
+                out[i] = static_cast<int32_t>(static_cast<uint32_t>(out[i]) << wasted);
+    }
+
+    // Decodes the frame at next_offset into chan
+    // @return false at the end of the stream
+    bool decode_frame() {
+        if ( next_offset >= file_size )
+            return false;
+        size_t         avail;
+        const uint8_t* p = ensure(next_offset, frame_need, avail);
+        FlacFrameHeader h;
+        if ( !parse_frame_header(p, avail, info, h) ) {
+            // Trailing junk (such as an ID3v1 tag) after the last frame
+            if ( position >= total )
+                return false;
+            throw FlacRuntimeError("Lost frame sync!");
+        }
+        if ( h.channels != info.channels || h.block_size > info.max_block )
+            throw FlacRuntimeError("Frame doesn't match STREAMINFO!");
+        if ( h.assignment >= FLAC_LEFT_SIDE && h.bps >= 32 )
+            throw FlacRuntimeError("Unsupported 33-bit side channel!");
+
+        FlacBitReader br(p + h.header_bytes, avail - h.header_bytes);
+        for ( unsigned c = 0; c < h.channels; c++ ) {
+            bool side = (h.assignment == FLAC_LEFT_SIDE  && c == 1) ||
+                        (h.assignment == FLAC_RIGHT_SIDE && c == 0) ||
+                        (h.assignment == FLAC_MID_SIDE   && c == 1);
+            decode_subframe(br, chan[c].data(), h.block_size, h.bps + (side ? 1 : 0));
+        }
+        br.align();
+        size_t   body = h.header_bytes + br.byte_pos();
+        uint16_t crc  = static_cast<uint16_t>(br.read(16));
+        if ( br.overrun() || flac_crc16(p, body) != crc )
+            throw FlacRuntimeError("Frame CRC mismatch!");
+
+        cur          = h;
+        cur_used     = 0;
+        next_offset += body + 2;
+        return true;
+    }
+
+    // Writes @p count frames of the current block from @p from onwards,
+    // undoing the stereo decorrelation on the way out
+    template <typename T, typename Convert>
+    void emit(T* dst, size_t from, size_t count, Convert conv) {
+        const int32_t* a  = chan[0].data() + from;
+        const int32_t* b  = chan[1].data() + from;
+        unsigned       nc = cur.channels;
+        switch ( cur.assignment ) {
+            case FLAC_LEFT_SIDE:
+                for ( size_t i = 0; i < count; i++ ) {
+                    dst[2 * i]     = conv(a[i]);
+                    dst[2 * i + 1] = conv(a[i] - b[i]);
+                }
+                break;
+
+            case FLAC_RIGHT_SIDE:
+                for ( size_t i = 0; i < count; i++ ) {
+                    dst[2 * i]     = conv(a[i] + b[i]);
+                    dst[2 * i + 1] = conv(b[i]);
+                }
+                break;
+
+            case FLAC_MID_SIDE:
+                for ( size_t i = 0; i < count; i++ ) {
+                    int32_t mid = static_cast<int32_t>(static_cast<uint32_t>(a[i]) << 1) | (b[i] & 1);
+                    dst[2 * i]     = conv((mid + b[i]) >> 1);
+                    dst[2 * i + 1] = conv((mid - b[i]) >> 1);
+                }
+                break;
+
+            default:
+                for ( unsigned c = 0; c < nc; c++ ) {
+                    const int32_t* src = chan[c].data() + from;
+                    for ( size_t i = 0; i < count; i++ )
+                        dst[i * nc + c] = conv(src[i]);
+                }
+                break;
+        }
+    }
+
+    template <typename T, typename Convert>
+    size_t read(T* dst, size_t frames, Convert conv) {
+        size_t done = 0;
+        try {
+            while ( done < frames ) {
+                if ( cur_used == cur.block_size && !decode_frame() )
+                    break;
+                size_t n = std::min<size_t>(frames - done, cur.block_size - cur_used);
+                emit(dst + done * info.channels, cur_used, n, conv);
+                cur_used += n;
+                done     += n;
+                position += n;
+            }
+        } catch ( const FileException& e ) {
+            throw FlacRuntimeError(e.what());
+        }
+        return done;
+    }
+
+    void seek(uint64_t frame) {
+        if ( frame > total )
+            frame = total;
+        if ( frame == total || index.empty() ) {
+            next_offset = file_size;
+            cur_used    = cur.block_size;
+            position    = total;
+            return;
+        }
+        auto it = std::upper_bound(index.begin(), index.end(), frame,
+            [](uint64_t f, const FlacIndexEntry& e) { return f < e.sample; });
+        --it;
+        next_offset = it->offset;
+        position    = it->sample;
+        try {
+            if ( !decode_frame() )
+                throw FlacRuntimeError("Seek index points past the end of the file!");
+        } catch ( const FileException& e ) {
+            throw FlacRuntimeError(e.what());
+        }
+        cur_used = static_cast<size_t>(frame - it->sample);
+        position = frame;
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- FlacDecoder Class Methods --- -----------------------------------
+FlacDecoder::FlacDecoder(const std::string& path):
+    FlacDecoder(path, Options()) {}
+
+FlacDecoder::FlacDecoder(const std::string& path, const Options& options) {
+    pimpl = std::make_unique<Impl>(path, options);
+}
+
+FlacDecoder::~FlacDecoder() = default;
+
+const FlacInfo& FlacDecoder::info() const {
+    return pimpl->info;
+}
+
+uint64_t FlacDecoder::frames() const {
+    return pimpl->total;
+}
+
+uint64_t FlacDecoder::tell() const {
+    return pimpl->position;
+}
+
+void FlacDecoder::seek(uint64_t frame) {
+    pimpl->seek(frame);
+}
+
+size_t FlacDecoder::read(int32_t* data, size_t frames) {
+    return pimpl->read(data, frames, [](int32_t v) { return v; });
+}
+
+size_t FlacDecoder::read(float* data, size_t frames) {
+    float scale = 1.0f / static_cast<float>(1ull << (pimpl->info.bits_per_sample - 1));
+    return pimpl->read(data, frames, [scale](int32_t v) { return static_cast<float>(v) * scale; });
+}
+
+size_t FlacDecoder::index_size() const {
+    return pimpl->index.size();
+}
@@ -0,0 +1,208 @@
+/**
+ * @file flac.hpp
+ * @brief Provides @b FlacDecoder and @b FlacEncoder for streaming FLAC files
+ */
+#ifndef SIMPLY_FLAC_HPP_
+#define SIMPLY_FLAC_HPP_
+
+#include "threads.hpp"
+
+#include <string>
+#include <exception>
+#include <memory>
+#include <cstdint>
+
+/**
+ * @class FlacException
+ * @brief This is the base class of all exceptions thrown by the FLAC classes
+ */
+class FlacException: public std::exception {
+    protected:
+        std::string msg;
+        explicit FlacException(const std::string& msg): msg(msg) {}
+
+    public:
+        /// @brief Get a message describing the error
+        /// @return NULL-terminated c-string
+        const char* what() const noexcept override { return msg.c_str(); }
+};
+
+/**
+ * @class FlacUserError
+ * @brief This means some FLAC operations were used in incorrect order/combination
+ */
+class FlacUserError: public FlacException {
+    public:
+        explicit FlacUserError(const std::string& msg): FlacException("FlacUserError: " + msg) {}
+};
+
+/**
+ * @class FlacRuntimeError
+ * @brief This means the file is corrupt/unsupported or your system failed to handle a valid operation
+ */
+class FlacRuntimeError: public FlacException {
+    public:
+        explicit FlacRuntimeError(const std::string& msg): FlacException("FlacRuntimeError: " + msg) {}
+};
+
+/**
+ * @struct FlacInfo
+ * @brief The stream properties from a FLAC file's STREAMINFO block
+ */
+struct FlacInfo {
+    /// Frames per second
+    uint32_t sample_rate     = 0;
+    /// Number of interleaved channels, 1 to 8
+    uint16_t channels        = 0;
+    /// Bits per sample, 4 to 32
+    uint16_t bits_per_sample = 0;
+    /// Total frames in the stream, 0 if unknown
+    uint64_t total_frames    = 0;
+    /// Smallest block size in frames
+    uint16_t min_block       = 0;
+    /// Largest block size in frames
+    uint16_t max_block       = 0;
+    /// Largest encoded frame in bytes, 0 if unknown
+    uint32_t max_frame_bytes = 0;
+    /// MD5 of the decoded samples, all zero if unknown
+    uint8_t  md5[16]         = {};
+};
+
+/**
+ * @class FlacDecoder
+ * @brief Decodes a FLAC file into interleaved samples
+ *
+ * When opened, the file is scanned once for frame boundaries to build a
+ * seek index, so @b seek is a binary search followed by decoding a
+ * single frame. The index can be saved next to the file (as
+ * `<path>.sfidx`) and is then reused when the file is opened again.
+ *
+ * Stereo decorrelation (left/side, right/side, mid/side) is undone
+ * while the samples are written out, rather than as a separate pass.
+ */
+class FlacDecoder {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /**
+         * @struct Options
+         * @brief Controls how the seek index is kept
+         */
+        struct Options {
+            /// Load the seek index from, and save it to, `<path>.sfidx`
+            bool persist_index = false;
+        };
+
+        /// @brief Open @p path and build (or load) its seek index
+        /// @throws FlacRuntimeError if the file can't be read or isn't a supported FLAC file
+        explicit FlacDecoder(const std::string& path);
+
+        /// @brief Open @p path with @p options
+        FlacDecoder(const std::string& path, const Options& options);
+
+        ~FlacDecoder();
+
+        FlacDecoder(const FlacDecoder&) = delete;
+        FlacDecoder& operator=(const FlacDecoder&) = delete;
+
+        /// @brief Stream properties
+        const FlacInfo& info() const;
+
+        /// @brief Total frames in the file, counted while indexing
+        uint64_t frames() const;
+
+        /// @brief Frame the next @b read starts at
+        uint64_t tell() const;
+
+        /// @brief Move to @p frame, clamped to the end of the file
+        /// @throws FlacRuntimeError if the frame at that position is corrupt
+        void seek(uint64_t frame);
+
+        /// @brief Decode up to @p frames interleaved frames as right-justified integers
+        /// @return Number of frames decoded, 0 at the end of the file
+        /// @throws FlacRuntimeError if a corrupt frame is found
+        size_t read(int32_t* data, size_t frames);
+
+        /// @brief Decode up to @p frames interleaved frames as floats in [-1, 1)
+        /// @return Number of frames decoded, 0 at the end of the file
+        /// @throws FlacRuntimeError if a corrupt frame is found
+        size_t read(float* data, size_t frames);
+
+        /// @brief Number of entries in the seek index (one per FLAC frame)
+        size_t index_size() const;
+};
+
+/**
+ * @class FlacEncoder
+ * @brief Encodes interleaved samples to a FLAC file on a pool of worker threads
+ *
+ * The input is cut into fixed-size blocks which are encoded as
+ * independent FLAC frames, each on whichever worker @b Thread is free
+ * (LPC analysis, predictor order search and Rice partitioning included).
+ * Finished frames wait in a reorder buffer and are written to the file
+ * in order by the thread calling @b write / @b close.
+ *
+ * Each frame only depends on its own samples and the @b Options, so the
+ * output is byte-identical for any number of threads.
+ *
+ * @note The STREAMINFO MD5 is left as zero ("unknown")
+ */
+class FlacEncoder {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /**
+         * @struct Options
+         * @brief Compression settings and threading
+         */
+        struct Options {
+            /// Worker threads, 0 to encode on the calling thread
+            unsigned         threads              = 4;
+            /// Frames per FLAC frame, 16 to 65535
+            uint32_t         block_size           = 4096;
+            /// Highest LPC order tried, 0 to only use fixed predictors (max 32)
+            unsigned         max_lpc_order        = 8;
+            /// Bits per quantized LPC coefficient, 5 to 15
+            unsigned         lpc_precision        = 15;
+            /// Highest Rice partition order tried, 0 to 8
+            unsigned         max_partition_order  = 6;
+            /// Try left/side, right/side and mid/side for stereo
+            bool             stereo_decorrelation = true;
+            /// Blocks that may be queued or waiting to be written, 0 for 4 per thread
+            size_t           max_pending          = 0;
+            /// Priority of the worker threads
+            Thread::Priority priority             = Thread::NORMAL;
+        };
+
+        /// @brief Create @p path for samples in the layout of @p info
+        /// Only @b sample_rate, @b channels and @b bits_per_sample of @p info are used
+        /// @throws FlacUserError if the layout or options are not supported
+        /// @throws FlacRuntimeError if the file can't be created
+        FlacEncoder(const std::string& path, const FlacInfo& info);
+
+        /// @brief Create @p path with @p options
+        /// @throws ThreadUserError or ThreadRuntimeError if a worker can't be set up; those already set up are joined first
+        FlacEncoder(const std::string& path, const FlacInfo& info, const Options& options);
+
+        /// @brief Closes the file, discarding any errors
+        ~FlacEncoder();
+
+        FlacEncoder(const FlacEncoder&) = delete;
+        FlacEncoder& operator=(const FlacEncoder&) = delete;
+
+        /// @brief Queue interleaved, right-justified samples for encoding
+        /// Blocks while the reorder buffer is full
+        void write(const int32_t* data, size_t frames);
+
+        /// @brief Encode the remaining samples, finalize STREAMINFO and close the file
+        void close();
+
+        /// @brief Number of frames passed to @b write so far
+        uint64_t frames_written() const;
+};
+
+#endif // SIMPLY_FLAC_HPP_
@@ -0,0 +1,94 @@
+// Helpers shared by the FLAC decoder and encoder
+//
+// Not part of the public interface, only include from flac*.cpp
+#ifndef SIMPLY_FLAC_COMMON_HPP_
+#define SIMPLY_FLAC_COMMON_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+// ---------------------------------------------------------------------
+// --- CRC --- ---------------------------------------------------------
+// CRC-8 (poly 0x07) protects frame headers, CRC-16 (poly 0x8005) whole
+// frames; both MSB-first with an initial value of 0
+struct FlacCrcTables {
+    uint8_t  crc8[256];
+    uint16_t crc16[256];
+
+    FlacCrcTables() {
+        for ( int i = 0; i < 256; i++ ) {
+            uint8_t c8 = static_cast<uint8_t>(i);
+            for ( int b = 0; b < 8; b++ )
+                c8 = static_cast<uint8_t>((c8 & 0x80) ? (c8 << 1) ^ 0x07 : c8 << 1);
+            crc8[i] = c8;
+
+            uint16_t c16 = static_cast<uint16_t>(i << 8);
+            for ( int b = 0; b < 8; b++ )
+                c16 = static_cast<uint16_t>((c16 & 0x8000) ? (c16 << 1) ^ 0x8005 : c16 << 1);
+            crc16[i] = c16;
+        }
+    }
+
+    static const FlacCrcTables& get() {
+        static const FlacCrcTables tables;
+        return tables;
+    }
+};
+
+inline uint8_t flac_crc8(const uint8_t* data, size_t len) {
+    const uint8_t* table = FlacCrcTables::get().crc8;
+    uint8_t crc = 0;
+    for ( size_t i = 0; i < len; i++ )
+        crc = table[crc ^ data[i]];
+    return crc;
+}
+
+inline uint16_t flac_crc16(const uint8_t* data, size_t len) {
+    const uint16_t* table = FlacCrcTables::get().crc16;
+    uint16_t crc = 0;
+    for ( size_t i = 0; i < len; i++ )
+        crc = static_cast<uint16_t>((crc << 8) ^ table[(crc >> 8) ^ data[i]]);
+    return crc;
+}
+
+// ---------------------------------------------------------------------
+// --- Bit Tricks --- --------------------------------------------------
+inline int flac_clz64(uint64_t v) {
+    // v must be non-zero
+    #if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(v);
+    #else
+    int n = 0;
+    while ( !(v & 0x8000000000000000ull) ) {
+        v <<= 1;
+        n++;
+    }
+    return n;
+    #endif
+}
+
+inline int64_t flac_sign_extend(uint64_t v, unsigned bits) {
+    uint64_t m = 1ull << (bits - 1);
+    return static_cast<int64_t>((v ^ m) - m);
+}
+
+// ---------------------------------------------------------------------
+// --- Frame Header Tables --- -----------------------------------------
+// Indexed by the 4-bit sample rate code, 0 means "see STREAMINFO"
+// and codes 12-14 are read from the end of the header
+static const uint32_t FLAC_SAMPLE_RATES[12] = {
+    0, 88200, 176400, 192000, 8000, 16000, 22050, 24000, 32000, 44100, 48000, 96000
+};
+
+// Indexed by the 3-bit sample size code, 0 means "see STREAMINFO"
+// and 3 is reserved
+static const uint8_t FLAC_SAMPLE_SIZES[8] = {
+    0, 8, 12, 0, 16, 20, 24, 32
+};
+
+// Channel assignments beyond independent channels (0-7)
+static const unsigned FLAC_LEFT_SIDE  = 8;
+static const unsigned FLAC_RIGHT_SIDE = 9;
+static const unsigned FLAC_MID_SIDE   = 10;
+
+#endif // SIMPLY_FLAC_COMMON_HPP_
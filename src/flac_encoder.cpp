@@ -0,0 +1,825 @@
+#include "flac.hpp"
+#include "flac_common.hpp"
+#include "file.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+// ---------------------------------------------------------------------
+// --- Bit Writer --- --------------------------------------------------
+// MSB-first writer appending to a byte vector
+class FlacBitWriter {
+    private:
+        std::vector<uint8_t>& out;
+        uint64_t              acc  = 0; // Pending bits, right-aligned
+        unsigned              bits = 0; // Number of pending bits
+
+    public:
+        explicit FlacBitWriter(std::vector<uint8_t>& out): out(out) {}
+
+        // n must be in [0, 32]
+        void write(uint32_t v, unsigned n) {
+            if ( n == 0 )
+                return;
+            acc   = (acc << n) | (v & (0xFFFFFFFFull >> (32 - n)));
+            bits += n;
+            while ( bits >= 8 ) {
+                bits -= 8;
+                out.push_back(static_cast<uint8_t>(acc >> bits));
+            }
+        }
+
+        void write_signed(int32_t v, unsigned n) {
+            write(static_cast<uint32_t>(v), n);
+        }
+
+        // @p q zero bits followed by a one
+        void write_unary(uint32_t q) {
+            while ( q >= 32 ) {
+                write(0, 32);
+                q -= 32;
+            }
+            write(1, q + 1);
+        }
+
+        void align() {
+            if ( bits & 7 )
+                write(0, 8 - (bits & 7));
+        }
+};
+
+// ---------------------------------------------------------------------
+// --- Frame Encoding --- ----------------------------------------------
+// One block of input and, once encoded, its FLAC frame
+struct FlacJob {
+    enum State { FREE, READY, DONE };
+
+    std::vector<int32_t> samples; // Planar, channels * block_size
+    uint32_t             frames = 0;
+    uint64_t             number = 0;
+    std::vector<uint8_t> bytes;
+    State                state  = FREE;
+};
+
+// How one channel of a block will be coded
+struct FlacSubframePlan {
+    enum Type { CONSTANT, VERBATIM, FIXED, LPC };
+
+    Type     type      = VERBATIM;
+    unsigned bps       = 0; // After removing wasted bits
+    unsigned wasted    = 0;
+    unsigned order     = 0;
+    unsigned precision = 0;
+    int      shift     = 0;
+    int32_t  coefs[32] = {};
+    unsigned method    = 0; // Rice parameter width: 0 -> 4 bits, 1 -> 5 bits
+    unsigned porder    = 0;
+    uint8_t  params[256];
+    uint64_t bits      = 0; // Estimated size of the subframe
+};
+
+static const double PI = 3.14159265358979323846;
+
+static uint32_t zigzag(int32_t r) {
+    return (static_cast<uint32_t>(r) << 1) ^ static_cast<uint32_t>(r >> 31);
+}
+
+// Stateless apart from scratch space: each worker owns one, and the
+// result only depends on the job's samples and the options
+class FlacFrameEncoder {
+    private:
+        const FlacInfo&              info;
+        const FlacEncoder::Options&  opts;
+
+        // Scratch, sized once for the block size
+        std::vector<int32_t>  shifted;    // Input without wasted bits
+        std::vector<int32_t>  trial;      // Residual being evaluated
+        std::vector<int32_t>  residual[4];
+        std::vector<int32_t>  stereo[2];  // Side and mid channels
+        std::vector<double>   window;
+        std::vector<double>   windowed;
+        std::vector<uint64_t> sums;
+        uint32_t              window_n = 0;
+        FlacSubframePlan      trial_plan;
+        FlacSubframePlan      plans[4];
+
+    public:
+        FlacFrameEncoder(const FlacInfo& info, const FlacEncoder::Options& opts): info(info), opts(opts) {
+            size_t n = opts.block_size;
+            shifted.resize(n);
+            trial.resize(n);
+            for ( auto& r : residual )
+                r.resize(n);
+            for ( auto& s : stereo )
+                s.resize(n);
+            windowed.resize(n);
+            sums.resize(size_t(1) << opts.max_partition_order);
+        }
+
+        void encode(FlacJob& job);
+
+    private:
+        // Tukey(0.5) window, the usual choice for FLAC's LPC analysis
+        void make_window(uint32_t n) {
+            if ( window_n == n )
+                return;
+            window.assign(n, 1.0);
+            size_t taper = n / 4;
+            for ( size_t i = 0; i < taper; i++ ) {
+                double w = 0.5 - 0.5 * std::cos(PI * static_cast<double>(i) / static_cast<double>(taper));
+                window[i]         = w;
+                window[n - 1 - i] = w;
+            }
+            window_n = n;
+        }
+
+        // Picks the Rice partition order and parameters for @p res
+        // @return Estimated bits for the whole residual section
+        uint64_t rice_search(const int32_t* res, uint32_t n, unsigned order, FlacSubframePlan& plan) {
+            unsigned max_po = opts.max_partition_order;
+            while ( max_po > 0 && ((n & ((1u << max_po) - 1)) || (n >> max_po) <= order) )
+                max_po--;
+
+            // Sums of the zig-zag values at the finest order, merged
+            // pairwise on the way down to coarser ones
+            size_t parts = size_t(1) << max_po;
+            size_t psize = n >> max_po;
+            for ( size_t p = 0; p < parts; p++ ) {
+                size_t   start = p == 0 ? order : p * psize;
+                uint64_t sum   = 0;
+                for ( size_t i = start; i < (p + 1) * psize; i++ )
+                    sum += zigzag(res[i]);
+                sums[p] = sum;
+            }
+
+            uint64_t best = ~0ull;
+            for ( int po = static_cast<int>(max_po); po >= 0; po-- ) {
+                size_t   np     = size_t(1) << po;
+                size_t   ps     = n >> po;
+                uint64_t cost   = 0;
+                unsigned max_k  = 0;
+                uint8_t  ks[256];
+                for ( size_t p = 0; p < np; p++ ) {
+                    uint64_t count = p == 0 ? ps - order : ps;
+                    unsigned k     = 0;
+                    while ( k < 30 && (count << (k + 1)) < sums[p] )
+                        k++;
+                    ks[p]  = static_cast<uint8_t>(k);
+                    max_k  = std::max(max_k, k);
+                    cost  += count * (k + 1) + (sums[p] >> k);
+                }
+                unsigned method = max_k > 14 ? 1 : 0;
+                cost += 6 + np * (method ? 5 : 4);
+                if ( cost < best ) {
+                    best        = cost;
+                    plan.method = method;
+                    plan.porder = static_cast<unsigned>(po);
+                    std::memcpy(plan.params, ks, np);
+                }
+                for ( size_t p = 0; p < np / 2; p++ )
+                    sums[p] = sums[2 * p] + sums[2 * p + 1];
+            }
+            return best;
+        }
+
+        // @return false if the residual doesn't fit the Rice coder
+        static bool fixed_residual(const int32_t* x, uint32_t n, unsigned order, int32_t* res) {
+            for ( uint32_t i = order; i < n; i++ ) {
+                int64_t r;
+                switch ( order ) {
+                    case 0:  r = x[i]; break;
+                    case 1:  r = int64_t(x[i]) - x[i - 1]; break;
+                    case 2:  r = int64_t(x[i]) - 2 * int64_t(x[i - 1]) + x[i - 2]; break;
+                    case 3:  r = int64_t(x[i]) - 3 * int64_t(x[i - 1]) + 3 * int64_t(x[i - 2]) - x[i - 3]; break;
+                    default: r = int64_t(x[i]) - 4 * int64_t(x[i - 1]) + 6 * int64_t(x[i - 2])
+                                 - 4 * int64_t(x[i - 3]) + x[i - 4]; break;
+                }
+                if ( r > 0x3FFFFFFF || r < -0x40000000 )
+                    return false;
+                res[i] = static_cast<int32_t>(r);
+            }
+            return true;
+        }
+
+        static bool lpc_residual(const int32_t* x, uint32_t n, const FlacSubframePlan& plan, int32_t* res) {
+            for ( uint32_t i = plan.order; i < n; i++ ) {
+                int64_t sum = 0;
+                for ( unsigned j = 0; j < plan.order; j++ )
+                    sum += int64_t(plan.coefs[j]) * x[i - 1 - j];
+                int64_t r = int64_t(x[i]) - (sum >> plan.shift);
+                if ( r > 0x3FFFFFFF || r < -0x40000000 )
+                    return false;
+                res[i] = static_cast<int32_t>(r);
+            }
+            return true;
+        }
+
+        // Quantizes @p lp to @p plan.precision bits, carrying the rounding
+        // error into the next coefficient
+        static bool quantize(const double* lp, unsigned order, FlacSubframePlan& plan) {
+            double cmax = 0;
+            for ( unsigned j = 0; j < order; j++ )
+                cmax = std::max(cmax, std::fabs(lp[j]));
+            if ( !(cmax > 0) )
+                return false;
+            int log2cmax;
+            std::frexp(cmax, &log2cmax);
+            int shift = static_cast<int>(plan.precision) - log2cmax - 1;
+            if ( shift < 0 )
+                return false;
+            shift = std::min(shift, 15);
+
+            int32_t qmax = (1 << (plan.precision - 1)) - 1;
+            double  err  = 0;
+            for ( unsigned j = 0; j < order; j++ ) {
+                err += lp[j] * (1 << shift);
+                long q = std::lround(err);
+                q = std::max<long>(-qmax - 1, std::min<long>(qmax, q));
+                err -= static_cast<double>(q);
+                plan.coefs[j] = static_cast<int32_t>(q);
+            }
+            plan.shift = shift;
+            return true;
+        }
+
+        // Chooses the cheapest coding of @p x, leaving its residual in @p res
+        void analyze(const int32_t* x, uint32_t n, unsigned bps, FlacSubframePlan& plan, int32_t* res);
+
+        void write_residual(FlacBitWriter& bw, const int32_t* res, uint32_t n, const FlacSubframePlan& plan);
+        void write_subframe(FlacBitWriter& bw, const int32_t* x, uint32_t n, const FlacSubframePlan& plan, const int32_t* res);
+};
+
+void FlacFrameEncoder::analyze(const int32_t* x, uint32_t n, unsigned bps, FlacSubframePlan& plan, int32_t* res) {
+    // Wasted bits: trailing zeros shared by every sample
+    uint32_t all = 0;
+    for ( uint32_t i = 0; i < n; i++ )
+        all |= static_cast<uint32_t>(x[i]);
+    unsigned wasted = 0;
+    if ( all == 0 ) {
+        plan.type   = FlacSubframePlan::CONSTANT;
+        plan.bps    = bps;
+        plan.wasted = 0;
+        plan.bits   = 8 + bps;
+        res[0]      = 0;
+        return;
+    }
+    while ( !(all & 1) && wasted + 1 < bps ) {
+        all >>= 1;
+        wasted++;
+    }
+    const int32_t* src = x;
+    if ( wasted ) {
+        for ( uint32_t i = 0; i < n; i++ )
+            shifted[i] = x[i] >> wasted;
+        src = shifted.data();
+    }
+    bps -= wasted;
+    uint64_t header = 8 + wasted;
+
+    plan.wasted = wasted;
+    plan.bps    = bps;
+
+    bool constant = true;
+    for ( uint32_t i = 1; i < n && constant; i++ )
+        constant = src[i] == src[0];
+    if ( constant ) {
+        plan.type = FlacSubframePlan::CONSTANT;
+        plan.bits = header + bps;
+        res[0]    = src[0];
+        return;
+    }
+
+    plan.type = FlacSubframePlan::VERBATIM;
+    plan.bits = header + uint64_t(n) * bps;
+
+    // Fixed predictors
+    for ( unsigned order = 0; order <= 4 && order < n; order++ ) {
+        if ( !fixed_residual(src, n, order, trial.data()) )
+            continue;
+        trial_plan.order = order;
+        uint64_t bits = header + order * bps + rice_search(trial.data(), n, order, trial_plan);
+        if ( bits < plan.bits ) {
+            trial_plan.type   = FlacSubframePlan::FIXED;
+            trial_plan.bps    = bps;
+            trial_plan.wasted = wasted;
+            trial_plan.bits   = bits;
+            plan = trial_plan;
+            std::copy(trial.begin() + order, trial.begin() + n, res + order);
+        }
+    }
+
+    // LPC: autocorrelation of the windowed block, Levinson-Durbin for
+    // every order, then an exact residual cost for each order
+    unsigned max_order = std::min<unsigned>(opts.max_lpc_order, n > 1 ? n - 1 : 0);
+    if ( max_order == 0 )
+        return;
+    make_window(n);
+    for ( uint32_t i = 0; i < n; i++ )
+        windowed[i] = src[i] * window[i];
+    double autoc[33];
+    for ( unsigned lag = 0; lag <= max_order; lag++ ) {
+        double sum = 0;
+        for ( uint32_t i = lag; i < n; i++ )
+            sum += windowed[i] * windowed[i - lag];
+        autoc[lag] = sum;
+    }
+    if ( autoc[0] <= 0 )
+        return;
+    autoc[0] *= 1.0 + 1e-9; // Keeps the recursion stable for pure tones
+
+    double lpc[32];
+    double lp[32][32];
+    double err = autoc[0];
+    for ( unsigned i = 0; i < max_order; i++ ) {
+        double r = -autoc[i + 1];
+        for ( unsigned j = 0; j < i; j++ )
+            r -= lpc[j] * autoc[i - j];
+        r /= err;
+        lpc[i] = r;
+        unsigned j = 0;
+        for ( ; j < (i >> 1); j++ ) {
+            double tmp      = lpc[j];
+            lpc[j]         += r * lpc[i - 1 - j];
+            lpc[i - 1 - j] += r * tmp;
+        }
+        if ( i & 1 )
+            lpc[j] += lpc[j] * r;
+        err *= 1.0 - r * r;
+        for ( j = 0; j <= i; j++ )
+            lp[i][j] = -lpc[j];
+        if ( err <= 0 ) {
+            max_order = i + 1;
+            break;
+        }
+    }
+
+    unsigned precision = opts.lpc_precision;
+    for ( unsigned order = 1; order <= max_order; order++ ) {
+        trial_plan.order     = order;
+        trial_plan.precision = precision;
+        if ( !quantize(lp[order - 1], order, trial_plan) || !lpc_residual(src, n, trial_plan, trial.data()) )
+            continue;
+        uint64_t bits = header + order * bps + 4 + 5 + order * precision +
+                        rice_search(trial.data(), n, order, trial_plan);
+        if ( bits < plan.bits ) {
+            trial_plan.type   = FlacSubframePlan::LPC;
+            trial_plan.bps    = bps;
+            trial_plan.wasted = wasted;
+            trial_plan.bits   = bits;
+            plan = trial_plan;
+            std::copy(trial.begin() + order, trial.begin() + n, res + order);
+        }
+    }
+}
+
+void FlacFrameEncoder::write_residual(FlacBitWriter& bw, const int32_t* res, uint32_t n, const FlacSubframePlan& plan) {
+    bw.write(plan.method, 2);
+    bw.write(plan.porder, 4);
+    unsigned param_bits = plan.method ? 5 : 4;
+    size_t   psize      = n >> plan.porder;
+    size_t   i          = plan.order;
+    for ( size_t p = 0; p < (size_t(1) << plan.porder); p++ ) {
+        unsigned k = plan.params[p];
+        bw.write(k, param_bits);
+        for ( size_t end = (p + 1) * psize; i < end; i++ ) {
+            uint32_t u = zigzag(res[i]);
+            bw.write_unary(u >> k);
+            bw.write(u, k);
+        }
+    }
+}
+
+void FlacFrameEncoder::write_subframe(FlacBitWriter& bw, const int32_t* x, uint32_t n,
+                                      const FlacSubframePlan& plan, const int32_t* res) {
+    unsigned type = 0;
+    switch ( plan.type ) {
+        case FlacSubframePlan::CONSTANT: type = 0; break;
+        case FlacSubframePlan::VERBATIM: type = 1; break;
+        case FlacSubframePlan::FIXED:    type = 8 + plan.order; break;
+        case FlacSubframePlan::LPC:      type = 31 + plan.order; break;
+    }
+    bw.write(type, 7); // Zero padding bit + type
+    if ( plan.wasted ) {
+        bw.write(1, 1);
+        bw.write_unary(plan.wasted - 1);
+    } else {
+        bw.write(0, 1);
+    }
+
+    if ( plan.type == FlacSubframePlan::CONSTANT ) {
+        bw.write_signed(res[0], plan.bps);
+        return;
+    }
+    for ( uint32_t i = 0; i < (plan.type == FlacSubframePlan::VERBATIM ? n : plan.order); i++ )
+        bw.write_signed(x[i] >> plan.wasted, plan.bps);
+    if ( plan.type == FlacSubframePlan::VERBATIM )
+        return;
+    if ( plan.type == FlacSubframePlan::LPC ) {
+        bw.write(plan.precision - 1, 4);
+        bw.write_signed(plan.shift, 5);
+        for ( unsigned j = 0; j < plan.order; j++ )
+            bw.write_signed(plan.coefs[j], plan.precision);
+    }
+    write_residual(bw, res, n, plan);
+}
+
+static void write_utf8(FlacBitWriter& bw, uint64_t v) {
+    if ( v < 0x80 ) {
+        bw.write(static_cast<uint32_t>(v), 8);
+        return;
+    }
+    unsigned extra = 1;
+    while ( extra < 6 && v >= (uint64_t(1) << (6 * extra + 6 - extra)) )
+        extra++;
+    uint32_t lead = (0xFF00u >> (extra + 1)) & 0xFF;
+    bw.write(lead | static_cast<uint32_t>(v >> (6 * extra)), 8);
+    for ( int e = static_cast<int>(extra) - 1; e >= 0; e-- )
+        bw.write(0x80 | ((v >> (6 * e)) & 0x3F), 8);
+}
+
+void FlacFrameEncoder::encode(FlacJob& job) {
+    uint32_t n  = job.frames;
+    unsigned nc = info.channels;
+    job.bytes.clear();
+    FlacBitWriter bw(job.bytes);
+
+    // Pick the channel coding first, it goes in the header
+    const int32_t* ch[2] = { job.samples.data(), job.samples.data() + opts.block_size };
+    unsigned assignment  = nc - 1;
+    unsigned bps         = info.bits_per_sample;
+    if ( nc == 2 && opts.stereo_decorrelation && bps < 32 ) {
+        for ( uint32_t i = 0; i < n; i++ ) {
+            stereo[0][i] = ch[0][i] - ch[1][i];        // Side
+            stereo[1][i] = (ch[0][i] + ch[1][i]) >> 1; // Mid
+        }
+        analyze(ch[0], n, bps, plans[0], residual[0].data());
+        analyze(ch[1], n, bps, plans[1], residual[1].data());
+        analyze(stereo[0].data(), n, bps + 1, plans[2], residual[2].data());
+        analyze(stereo[1].data(), n, bps, plans[3], residual[3].data());
+        uint64_t independent = plans[0].bits + plans[1].bits;
+        uint64_t left_side   = plans[0].bits + plans[2].bits;
+        uint64_t right_side  = plans[2].bits + plans[1].bits;
+        uint64_t mid_side    = plans[3].bits + plans[2].bits;
+        uint64_t best        = std::min({independent, left_side, right_side, mid_side});
+        if ( best == independent )
+            assignment = 1;
+        else if ( best == left_side )
+            assignment = FLAC_LEFT_SIDE;
+        else if ( best == right_side )
+            assignment = FLAC_RIGHT_SIDE;
+        else
+            assignment = FLAC_MID_SIDE;
+    }
+
+    // Frame header
+    unsigned bs_code = 0;
+    if ( n == 192 )
+        bs_code = 1;
+    for ( unsigned c = 2; c <= 5; c++ )
+        if ( n == (576u << (c - 2)) )
+            bs_code = c;
+    for ( unsigned c = 8; c <= 15; c++ )
+        if ( n == (256u << (c - 8)) )
+            bs_code = c;
+    if ( bs_code == 0 )
+        bs_code = n <= 256 ? 6 : 7;
+    unsigned sr_code = 0;
+    for ( unsigned c = 1; c < 12; c++ )
+        if ( FLAC_SAMPLE_RATES[c] == info.sample_rate )
+            sr_code = c;
+    unsigned ss_code = 0;
+    for ( unsigned c = 1; c < 8; c++ )
+        if ( c != 3 && FLAC_SAMPLE_SIZES[c] == bps )
+            ss_code = c;
+
+    bw.write(0xFFF8, 16); // Sync + fixed blocking strategy
+    bw.write(bs_code, 4);
+    bw.write(sr_code, 4);
+    bw.write(assignment, 4);
+    bw.write(ss_code, 3);
+    bw.write(0, 1);
+    write_utf8(bw, job.number);
+    if ( bs_code == 6 )
+        bw.write(n - 1, 8);
+    else if ( bs_code == 7 )
+        bw.write(n - 1, 16);
+    bw.write(flac_crc8(job.bytes.data(), job.bytes.size()), 8);
+
+    // Subframes
+    if ( nc == 2 && assignment != 1 ) {
+        static const int pick[3][2] = {
+            {0, 2}, // Left + side
+            {2, 1}, // Side + right
+            {3, 2}  // Mid + side
+        };
+        const int32_t* src[4] = { ch[0], ch[1], stereo[0].data(), stereo[1].data() };
+        const int*     p      = pick[assignment - FLAC_LEFT_SIDE];
+        for ( int c = 0; c < 2; c++ )
+            write_subframe(bw, src[p[c]], n, plans[p[c]], residual[p[c]].data());
+    } else if ( nc == 2 && opts.stereo_decorrelation && bps < 32 ) {
+        for ( int c = 0; c < 2; c++ )
+            write_subframe(bw, ch[c], n, plans[c], residual[c].data());
+    } else {
+        for ( unsigned c = 0; c < nc; c++ ) {
+            const int32_t* x = job.samples.data() + size_t(c) * opts.block_size;
+            analyze(x, n, bps, plans[0], residual[0].data());
+            write_subframe(bw, x, n, plans[0], residual[0].data());
+        }
+    }
+
+    bw.align();
+    uint16_t crc = flac_crc16(job.bytes.data(), job.bytes.size());
+    bw.write(crc, 16);
+}
+
+// ---------------------------------------------------------------------
+// --- FlacEncoder Implementation --- ----------------------------------
+static const uint64_t STREAMINFO_OFFSET = 8;
+
+struct FlacEncoder::Impl {
+    FlacInfo info;
+    Options  opts;
+    RawFile  file;
+    uint64_t file_offset = 0;
+
+    // Reorder buffer: job i lives in slot i % jobs.size(). Jobs are
+    // submitted and written in order, and encoded in any order
+    std::vector<FlacJob>          jobs;
+    uint64_t                      submitted = 0; // Jobs handed to the workers
+    uint64_t                      written   = 0; // Jobs written to the file
+    uint64_t                      next_job  = 0; // Next job a worker will take
+    std::mutex                    m;
+    std::condition_variable       cv_work;
+    std::condition_variable       cv_done;
+    bool                          stopping  = false;
+
+    std::vector<Thread>                            workers;
+    unsigned                                       created = 0; // Workers with a thread, started or not
+    std::vector<std::unique_ptr<FlacFrameEncoder>> encoders;
+    std::unique_ptr<FlacFrameEncoder>              inline_encoder;
+
+    uint64_t total       = 0;
+    uint32_t min_frame   = 0xFFFFFF;
+    uint32_t max_frame   = 0;
+    bool     open        = true;
+
+    Impl(const std::string& path, const FlacInfo& in, const Options& o): opts(o) {
+        if ( in.channels < 1 || in.channels > 8 )
+            throw FlacUserError("FLAC supports 1 to 8 channels!");
+        if ( in.bits_per_sample < 4 || in.bits_per_sample > 32 )
+            throw FlacUserError("FLAC supports 4 to 32 bits per sample!");
+        if ( in.sample_rate == 0 || in.sample_rate >= (1u << 20) )
+            throw FlacUserError("Unsupported sample rate!");
+        if ( opts.block_size < 16 || opts.block_size > 65535 )
+            throw FlacUserError("Block size must be in [16, 65535]!");
+        if ( opts.max_lpc_order > 32 || opts.lpc_precision < 5 || opts.lpc_precision > 15 ||
+             opts.max_partition_order > 8 )
+            throw FlacUserError("Invalid compression settings!");
+
+        info.sample_rate     = in.sample_rate;
+        info.channels        = in.channels;
+        info.bits_per_sample = in.bits_per_sample;
+        info.min_block       = static_cast<uint16_t>(opts.block_size);
+        info.max_block       = static_cast<uint16_t>(opts.block_size);
+
+        size_t pending = opts.max_pending ? opts.max_pending : std::max(1u, opts.threads) * 4;
+        jobs.resize(pending);
+        for ( auto& job : jobs )
+            job.samples.resize(size_t(opts.block_size) * info.channels);
+
+        try {
+            file.open(path, RawFile::WRITE);
+            uint8_t hdr[42];
+            build_streaminfo(hdr);
+            file.write_at(0, hdr, sizeof(hdr));
+            file_offset = sizeof(hdr);
+        } catch ( const FileException& e ) {
+            throw FlacRuntimeError(e.what());
+        }
+
+        if ( opts.threads == 0 ) {
+            inline_encoder = std::make_unique<FlacFrameEncoder>(info, opts);
+            return;
+        }
+        for ( unsigned t = 0; t < opts.threads; t++ )
+            encoders.push_back(std::make_unique<FlacFrameEncoder>(info, opts));
+        workers.resize(opts.threads);
+        try {
+            for ( unsigned t = 0; t < opts.threads; t++ ) {
+                workers[t].create(worker_main, this);
+                created++;
+                workers[t].set_priority(opts.priority);
+                workers[t].start();
+            }
+        } catch ( ... ) {
+            stop_workers(); // ~Impl won't run, and the started workers are waiting
+            throw;
+        }
+    }
+
+    ~Impl() {
+        stop_workers();
+    }
+
+    void build_streaminfo(uint8_t* p) {
+        std::memcpy(p, "fLaC", 4);
+        p[4] = 0x80; // Last metadata block, type STREAMINFO
+        p[5] = 0;
+        p[6] = 0;
+        p[7] = 34;
+        uint8_t* b = p + STREAMINFO_OFFSET;
+        uint32_t min_f = max_frame ? min_frame : 0;
+        b[0]  = static_cast<uint8_t>(info.min_block >> 8);
+        b[1]  = static_cast<uint8_t>(info.min_block);
+        b[2]  = static_cast<uint8_t>(info.max_block >> 8);
+        b[3]  = static_cast<uint8_t>(info.max_block);
+        b[4]  = static_cast<uint8_t>(min_f >> 16);
+        b[5]  = static_cast<uint8_t>(min_f >> 8);
+        b[6]  = static_cast<uint8_t>(min_f);
+        b[7]  = static_cast<uint8_t>(max_frame >> 16);
+        b[8]  = static_cast<uint8_t>(max_frame >> 8);
+        b[9]  = static_cast<uint8_t>(max_frame);
+        b[10] = static_cast<uint8_t>(info.sample_rate >> 12);
+        b[11] = static_cast<uint8_t>(info.sample_rate >> 4);
+        b[12] = static_cast<uint8_t>((info.sample_rate << 4) | ((info.channels - 1) << 1) |
+                                     ((info.bits_per_sample - 1) >> 4));
+        b[13] = static_cast<uint8_t>(((info.bits_per_sample - 1) << 4) | ((total >> 32) & 15));
+        b[14] = static_cast<uint8_t>(total >> 24);
+        b[15] = static_cast<uint8_t>(total >> 16);
+        b[16] = static_cast<uint8_t>(total >> 8);
+        b[17] = static_cast<uint8_t>(total);
+        std::memset(b + 18, 0, 16);
+    }
+
+    // ====== Workers ======
+    static int worker_main(void* data) {
+        Impl* self = static_cast<Impl*>(data);
+        // Each worker claims its own encoder by index
+        size_t id;
+        {
+            std::lock_guard<std::mutex> lock(self->m);
+            id = self->claimed_encoders++;
+        }
+        self->work(*self->encoders[id]);
+        return 0;
+    }
+
+    size_t claimed_encoders = 0;
+
+    void work(FlacFrameEncoder& encoder) {
+        std::unique_lock<std::mutex> lock(m);
+        while ( true ) {
+            cv_work.wait(lock, [this] { return stopping || next_job < submitted; });
+            if ( next_job == submitted )
+                return;
+            FlacJob& job = jobs[next_job++ % jobs.size()];
+            lock.unlock();
+            encoder.encode(job);
+            lock.lock();
+            job.state = FlacJob::DONE;
+            cv_done.notify_all();
+        }
+    }
+
+    // Workers a failed constructor created but never started are started
+    // here, only to see stopping and return, as they can't be joined before
+    void stop_workers() {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stopping = true;
+        }
+        cv_work.notify_all();
+        for ( unsigned t = 0; t < created; t++ ) {
+            try {
+                if ( !workers[t].started() )
+                    workers[t].start();
+                workers[t].join();
+            } catch ( ... ) { ; }
+        }
+        workers.clear();
+        created = 0;
+    }
+
+    // ====== Calling thread ======
+    // Writes finished jobs in order; waits for jobs until @p until have
+    // been written, and writes any that are already done after that
+    void write_done(uint64_t until) {
+        std::unique_lock<std::mutex> lock(m);
+        while ( written < submitted ) {
+            FlacJob& job = jobs[written % jobs.size()];
+            if ( job.state != FlacJob::DONE ) {
+                if ( written >= until )
+                    break;
+                cv_done.wait(lock, [&job] { return job.state == FlacJob::DONE; });
+            }
+            lock.unlock();
+            try {
+                file.write_at(file_offset, job.bytes.data(), job.bytes.size());
+            } catch ( const FileException& e ) {
+                throw FlacRuntimeError(e.what());
+            }
+            file_offset += job.bytes.size();
+            min_frame    = std::min<uint32_t>(min_frame, static_cast<uint32_t>(job.bytes.size()));
+            max_frame    = std::max<uint32_t>(max_frame, static_cast<uint32_t>(job.bytes.size()));
+            lock.lock();
+            job.state  = FlacJob::FREE;
+            job.frames = 0;
+            written++;
+        }
+    }
+
+    // The job being filled is always slot submitted % jobs.size()
+    FlacJob& filling() {
+        if ( submitted - written == jobs.size() )
+            write_done(written + 1);
+        return jobs[submitted % jobs.size()];
+    }
+
+    void submit(FlacJob& job) {
+        job.number = submitted;
+        if ( inline_encoder ) {
+            inline_encoder->encode(job);
+            job.state = FlacJob::DONE;
+            submitted++;
+        } else {
+            std::lock_guard<std::mutex> lock(m);
+            job.state = FlacJob::READY;
+            submitted++;
+            cv_work.notify_one();
+        }
+        write_done(0);
+    }
+
+    void write(const int32_t* data, size_t frames) {
+        unsigned nc = info.channels;
+        while ( frames > 0 ) {
+            FlacJob& job = filling();
+            size_t   n   = std::min<size_t>(frames, opts.block_size - job.frames);
+            for ( unsigned c = 0; c < nc; c++ ) {
+                int32_t* dst = job.samples.data() + size_t(c) * opts.block_size + job.frames;
+                for ( size_t i = 0; i < n; i++ )
+                    dst[i] = data[i * nc + c];
+            }
+            job.frames += static_cast<uint32_t>(n);
+            data       += n * nc;
+            frames     -= n;
+            total      += n;
+            if ( job.frames == opts.block_size )
+                submit(job);
+        }
+    }
+
+    void close() {
+        if ( !open )
+            return;
+        open = false;
+        FlacJob& last = filling();
+        if ( last.frames > 0 )
+            submit(last);
+        write_done(submitted);
+        stop_workers();
+        try {
+            uint8_t hdr[42];
+            build_streaminfo(hdr);
+            file.write_at(0, hdr, sizeof(hdr));
+            file.close();
+        } catch ( const FileException& e ) {
+            throw FlacRuntimeError(e.what());
+        }
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- FlacEncoder Class Methods --- -----------------------------------
+FlacEncoder::FlacEncoder(const std::string& path, const FlacInfo& info):
+    FlacEncoder(path, info, Options()) {}
+
+FlacEncoder::FlacEncoder(const std::string& path, const FlacInfo& info, const Options& options) {
+    pimpl = std::make_unique<Impl>(path, info, options);
+}
+
+FlacEncoder::~FlacEncoder() {
+    if ( pimpl )
+        try {
+            pimpl->close();
+        }
+        catch ( ... ) { ; }
+}
+
+void FlacEncoder::write(const int32_t* data, size_t frames) {
+    if ( !pimpl->open )
+        throw FlacUserError("Cannot write to a closed encoder!");
+    pimpl->write(data, frames);
+}
+
+void FlacEncoder::close() {
+    pimpl->close();
+}
+
+uint64_t FlacEncoder::frames_written() const {
+    return pimpl->total;
+}
@@ -0,0 +1,60 @@
+#include "futex.hpp"
+
+#if defined(_WIN32)
+extern "C" {
+    #include <windows.h>
+}
+
+#elif defined(__linux__)
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#else
+#include <thread>
+#endif
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "The OS waits on the atomic's address as a plain word");
+
+#if defined(_WIN32)
+void Futex::wait(uint32_t expected) const {
+    WaitOnAddress(const_cast<std::atomic<uint32_t>*>(&word), &expected, sizeof(expected), INFINITE);
+}
+
+void Futex::wake_one() {
+    WakeByAddressSingle(&word);
+}
+
+void Futex::wake_all() {
+    WakeByAddressAll(&word);
+}
+
+#elif defined(__linux__)
+static void futex(const std::atomic<uint32_t>* word, int op, uint32_t value) {
+    syscall(SYS_futex, const_cast<std::atomic<uint32_t>*>(word), op, value, nullptr, nullptr, 0);
+}
+
+void Futex::wait(uint32_t expected) const {
+    futex(&word, FUTEX_WAIT_PRIVATE, expected);
+}
+
+void Futex::wake_one() {
+    futex(&word, FUTEX_WAKE_PRIVATE, 1);
+}
+
+void Futex::wake_all() {
+    futex(&word, FUTEX_WAKE_PRIVATE, INT_MAX);
+}
+
+#else
+// No OS support: waiting degrades to yielding
+void Futex::wait(uint32_t expected) const {
+    if ( word.load() == expected )
+        std::this_thread::yield();
+}
+
+void Futex::wake_one() {}
+
+void Futex::wake_all() {}
+#endif
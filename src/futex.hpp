@@ -0,0 +1,62 @@
+/**
+ * @file futex.hpp
+ * @brief Provides @b Futex, an atomic word threads can sleep on
+ */
+#ifndef SIMPLY_FUTEX_HPP_
+#define SIMPLY_FUTEX_HPP_
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @class Futex
+ * @brief A 32-bit atomic that threads can block on until it changes
+ *
+ * Waiting and waking go straight to the OS (@b WaitOnAddress on Windows,
+ * @b futex on Linux): no mutex or condition variable is involved, and a
+ * wake with no sleepers is a single cheap call. All other operations are
+ * plain atomics and never enter the kernel.
+ *
+ * The usual pattern re-checks a condition around @b wait, since it may
+ * return spuriously:
+ * @code
+ * uint32_t seen = word.load();
+ * while ( !condition() ) {
+ *     word.wait(seen);
+ *     seen = word.load();
+ * }
+ * @endcode
+ */
+class Futex {
+    protected:
+        std::atomic<uint32_t> word;
+
+    public:
+        /// @brief Construct holding @p initial
+        explicit Futex(uint32_t initial=0): word(initial) {}
+
+        Futex(const Futex&) = delete;
+        Futex& operator=(const Futex&) = delete;
+
+        /// @brief Read the value
+        uint32_t load(std::memory_order order=std::memory_order_seq_cst) const { return word.load(order); }
+
+        /// @brief Set the value, without waking anyone
+        void store(uint32_t value, std::memory_order order=std::memory_order_seq_cst) { word.store(value, order); }
+
+        /// @brief Add to the value, without waking anyone
+        /// @return The previous value
+        uint32_t fetch_add(uint32_t value, std::memory_order order=std::memory_order_seq_cst) { return word.fetch_add(value, order); }
+
+        /// @brief Block while the value is @p expected
+        /// @note Returns at once if the value differs, and may return spuriously
+        void wait(uint32_t expected) const;
+
+        /// @brief Wake one thread blocked in @b wait
+        void wake_one();
+
+        /// @brief Wake all threads blocked in @b wait
+        void wake_all();
+};
+
+#endif // SIMPLY_FUTEX_HPP_
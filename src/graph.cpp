@@ -0,0 +1,723 @@
+#include "graph.hpp"
+#include "graph_common.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ---------------------------------------------------------------------
+// --- GraphPlan Class Methods --- -------------------------------------
+GraphPlan::GraphPlan(): pimpl(new Impl()) {}
+
+GraphPlan::~GraphPlan() = default;
+
+unsigned GraphPlan::inputs() const {
+    return pimpl->n_in;
+}
+
+unsigned GraphPlan::outputs() const {
+    return pimpl->n_out;
+}
+
+size_t GraphPlan::max_block() const {
+    return pimpl->block;
+}
+
+size_t GraphPlan::steps() const {
+    return pimpl->schedule.size();
+}
+
+size_t GraphPlan::slots() const {
+    return pimpl->nslots;
+}
+
+bool GraphPlan::parallel() const {
+    return pimpl->parallel;
+}
+
+size_t GraphPlan::latency() const {
+    return pimpl->total_latency;
+}
+
+static size_t schedule_latency(const std::vector<size_t>& lat, const std::vector<LatencyEdge>& edges,
+                               const std::vector<uint32_t>& order, std::vector<uint32_t>* delays);
+
+bool GraphPlan::update_latency() {
+    Impl& p = *pimpl;
+    std::vector<size_t> lat(p.by_id.size(), 0);
+    for ( uint32_t id : p.order )
+        lat[id] = p.by_id[id]->latency();
+
+    std::vector<uint32_t> delays;
+    size_t total = schedule_latency(lat, p.lat_edges, p.order, p.compensated ? &delays : nullptr);
+    if ( p.compensated ) {
+        // Every edge must keep its line and tap, and edges sharing a tap its delay
+        std::vector<std::vector<int64_t>> taps(p.comps.size());
+        for ( size_t c = 0; c < p.comps.size(); c++ )
+            taps[c].assign(p.comps[c]->num_outputs(), -1);
+        for ( size_t k = 0; k < delays.size(); k++ ) {
+            uint32_t c = p.edge_comp[k];
+            if ( c == NO_TAP ) {
+                if ( delays[k] )
+                    return false;
+                continue;
+            }
+            int64_t& d = taps[c][p.edge_tap[k]];
+            if ( (d >= 0 && d != delays[k]) || delays[k] > p.comps[c]->longest() )
+                return false;
+            d = delays[k];
+        }
+        for ( size_t c = 0; c < p.comps.size(); c++ )
+            for ( unsigned t = 0; t < taps[c].size(); t++ )
+                p.comps[c]->set_delay(t, static_cast<uint32_t>(taps[c][t]));
+    }
+    p.total_latency = total;
+    return true;
+}
+
+void GraphPlan::process(const float* const* in, float* const* out, size_t frames) {
+    pimpl->process(in, out, frames);
+}
+
+// ====== Graph Implementation ======
+struct GraphEdge {
+    Graph::NodeId src;
+    unsigned      src_port;
+    Graph::NodeId dst;
+    unsigned      dst_port;
+    bool          feedback = false; // read a block late, outside the sort
+
+    bool operator==(const GraphEdge& o) const {
+        return src == o.src && src_port == o.src_port && dst == o.dst && dst_port == o.dst_port;
+    }
+};
+
+struct Graph::Impl {
+    unsigned                                n_in;
+    unsigned                                n_out;
+    std::vector<std::shared_ptr<GraphNode>> nodes; // by id; INPUT and OUTPUT are empty
+    std::vector<GraphEdge>                  edges;
+
+    // What each node was last prepared for; nodes already prepared for a
+    // compile's settings are left alone, as an older plan may be running them
+    struct Prepared {
+        uint32_t sample_rate = 0;
+        size_t   max_block   = 0;
+    };
+    mutable std::vector<Prepared>           prepared;
+
+    // Compensation lines of the last compile, by (node, output port), kept
+    // for the next compile when their taps come out the same
+    mutable std::map<std::pair<NodeId, unsigned>, std::shared_ptr<CompensationDelay>> compensation;
+
+    Impl(unsigned inputs, unsigned outputs): n_in(inputs), n_out(outputs), nodes(2), prepared(2) {}
+
+    bool exists(NodeId id) const {
+        return id < nodes.size() && (id < 2 || nodes[id]);
+    }
+
+    void check(NodeId id) const {
+        if ( !exists(id) )
+            throw GraphUserError("Node " + std::to_string(id) + " doesn't exist!");
+    }
+
+    unsigned num_inputs(NodeId id) const {
+        return id == INPUT ? 0 : id == OUTPUT ? n_out : nodes[id]->num_inputs();
+    }
+
+    unsigned num_outputs(NodeId id) const {
+        return id == INPUT ? n_in : id == OUTPUT ? 0 : nodes[id]->num_outputs();
+    }
+
+    void connect(const GraphEdge& edge) {
+        check(edge.src);
+        check(edge.dst);
+        if ( edge.src_port >= num_outputs(edge.src) )
+            throw GraphUserError("Node " + std::to_string(edge.src) + " has no output " + std::to_string(edge.src_port) + "!");
+        if ( edge.dst_port >= num_inputs(edge.dst) )
+            throw GraphUserError("Node " + std::to_string(edge.dst) + " has no input " + std::to_string(edge.dst_port) + "!");
+        if ( std::find(edges.begin(), edges.end(), edge) != edges.end() )
+            throw GraphUserError("Connection already exists!");
+        edges.push_back(edge);
+    }
+
+    // Kahn's algorithm over the forward edges, taking the lowest ready id first so plans are reproducible
+    std::vector<NodeId> sort() const {
+        std::vector<uint32_t>            indegree(nodes.size(), 0);
+        std::vector<std::vector<NodeId>> next(nodes.size());
+        for ( const GraphEdge& e : edges ) {
+            if ( e.src == INPUT || e.dst == OUTPUT || e.feedback )
+                continue;
+            next[e.src].push_back(e.dst);
+            indegree[e.dst]++;
+        }
+
+        std::priority_queue<NodeId, std::vector<NodeId>, std::greater<NodeId>> ready;
+        size_t live = 0;
+        for ( NodeId id = 2; id < nodes.size(); id++ ) {
+            if ( !nodes[id] )
+                continue;
+            live++;
+            if ( !indegree[id] )
+                ready.push(id);
+        }
+
+        std::vector<NodeId> order;
+        while ( !ready.empty() ) {
+            NodeId id = ready.top();
+            ready.pop();
+            order.push_back(id);
+            for ( NodeId n : next[id] )
+                if ( !--indegree[n] )
+                    ready.push(n);
+        }
+        if ( order.size() != live )
+            throw GraphUserError("Graph has a cycle!");
+        return order;
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- Compilation --- -------------------------------------------------
+namespace {
+    // What a port of a step reads or writes, before slots are assigned
+    struct Ref {
+        enum Kind { SILENT, EXTERNAL, VALUE, FEEDBACK } kind;
+        uint32_t index; // channel if EXTERNAL, value if VALUE or FEEDBACK (its last block)
+    };
+
+    struct StepRefs {
+        GraphNode*       node;
+        std::vector<Ref> in;
+        std::vector<Ref> out;
+    };
+
+    // Minimum-cost flow by successive shortest paths, with Bellman-Ford
+    // (queue-based) as costs may be negative
+    struct FlowNetwork {
+        struct Arc {
+            uint32_t to;
+            int64_t  cap;
+            int64_t  cost;
+        };
+        std::vector<Arc>                   arcs; // arc a is undone by arc a ^ 1
+        std::vector<std::vector<uint32_t>> out;
+
+        static constexpr int64_t UNBOUNDED = INT64_MAX / 4;
+
+        explicit FlowNetwork(size_t nodes): out(nodes) {}
+
+        void add(uint32_t from, uint32_t to, int64_t cap, int64_t cost) {
+            out[from].push_back(static_cast<uint32_t>(arcs.size()));
+            arcs.push_back(Arc{to, cap, cost});
+            out[to].push_back(static_cast<uint32_t>(arcs.size()));
+            arcs.push_back(Arc{from, 0, -cost});
+        }
+
+        // Shortest distances over arcs with capacity left, among nodes below
+        // limit: from node @p from, or from all of them if it is not one;
+        // via[n] is the arc reaching n
+        std::vector<int64_t> distances(uint32_t from, uint32_t limit, std::vector<uint32_t>& via) const {
+            std::vector<int64_t> dist(limit, from < limit ? INT64_MAX : 0);
+            std::vector<char>    queued(limit, 0);
+            std::deque<uint32_t> queue;
+            via.assign(limit, UINT32_MAX);
+            for ( uint32_t n = 0; n < limit; n++ ) {
+                if ( from < limit && n != from )
+                    continue;
+                dist[n]   = 0;
+                queued[n] = 1;
+                queue.push_back(n);
+            }
+            while ( !queue.empty() ) {
+                uint32_t n = queue.front();
+                queue.pop_front();
+                queued[n] = 0;
+                for ( uint32_t a : out[n] ) {
+                    const Arc& arc = arcs[a];
+                    if ( arc.cap <= 0 || arc.to >= limit || dist[n] + arc.cost >= dist[arc.to] )
+                        continue;
+                    dist[arc.to] = dist[n] + arc.cost;
+                    via[arc.to]  = a;
+                    if ( !queued[arc.to] ) {
+                        queued[arc.to] = 1;
+                        queue.push_back(arc.to);
+                    }
+                }
+            }
+            return dist;
+        }
+
+        void flow(uint32_t source, uint32_t sink) {
+            const uint32_t limit = static_cast<uint32_t>(out.size());
+            std::vector<uint32_t> via;
+            for ( ;; ) {
+                if ( distances(source, limit, via)[sink] == INT64_MAX )
+                    return;
+                int64_t push = UNBOUNDED;
+                for ( uint32_t n = sink; n != source; n = arcs[via[n] ^ 1].to )
+                    push = std::min(push, arcs[via[n]].cap);
+                for ( uint32_t n = sink; n != source; n = arcs[via[n] ^ 1].to ) {
+                    arcs[via[n]].cap     -= push;
+                    arcs[via[n] ^ 1].cap += push;
+                }
+            }
+        }
+    };
+}
+
+// Latency of the longest path to the graph outputs and, if @p delays is
+// given, the compensating delay of every edge.
+//
+// With s(n) the time node n starts, an edge from port p of u to v needs
+// s(v) - s(u) - lat(u) >= 0 samples of delay, and the outputs start at
+// the longest path's latency. Port p needs a line as long as its longest
+// edge delay, so the starts minimise the sum over ports of
+//     m(p) - s(u) - lat(u), with m(p) >= s(v) for each edge of p.
+// Every constraint bounds a difference, so the dual of this program is a
+// minimum-cost flow; solving that, the starts are the (negated) shortest
+// path potentials left in the residual network.
+static size_t schedule_latency(const std::vector<size_t>& lat, const std::vector<LatencyEdge>& edges,
+                               const std::vector<uint32_t>& order, std::vector<uint32_t>* delays) {
+    const uint32_t n = static_cast<uint32_t>(lat.size());
+    std::vector<std::vector<uint32_t>> in_edges(n);
+    for ( uint32_t k = 0; k < edges.size(); k++ )
+        in_edges[edges[k].dst].push_back(k);
+
+    // Earliest starts, which give the latency
+    std::vector<int64_t> start(n, 0);
+    auto earliest = [&](uint32_t id) {
+        int64_t t = 0;
+        for ( uint32_t k : in_edges[id] )
+            t = std::max(t, start[edges[k].src] + static_cast<int64_t>(lat[edges[k].src]));
+        return t;
+    };
+    for ( uint32_t id : order )
+        start[id] = earliest(id);
+    const int64_t total = earliest(Graph::OUTPUT);
+    if ( !delays )
+        return static_cast<size_t>(total);
+
+    // Variables: node starts, then m(p) per delayed-from port
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> port_of;
+    std::vector<uint32_t> group(edges.size());
+    for ( uint32_t k = 0; k < edges.size(); k++ ) {
+        auto it = port_of.emplace(std::make_pair(edges[k].src, edges[k].src_port), n + static_cast<uint32_t>(port_of.size()));
+        group[k] = it.first->second;
+    }
+    const uint32_t vars   = n + static_cast<uint32_t>(port_of.size());
+    const uint32_t source = vars, sink = vars + 1;
+
+    // A constraint x(j) - x(i) >= w is an arc i -> j of cost -w; a
+    // variable's objective coefficient is its demand in the flow
+    FlowNetwork net(vars + 2);
+    std::vector<int64_t> supply(n, 0);
+    for ( uint32_t k = 0; k < edges.size(); k++ ) {
+        net.add(edges[k].src, edges[k].dst, FlowNetwork::UNBOUNDED, -static_cast<int64_t>(lat[edges[k].src]));
+        net.add(edges[k].dst, group[k], FlowNetwork::UNBOUNDED, 0);
+    }
+    for ( const auto& port : port_of ) {
+        supply[port.first.first]++;
+        net.add(port.second, sink, 1, 0);
+    }
+    for ( uint32_t id = 0; id < n; id++ )
+        if ( supply[id] )
+            net.add(source, id, supply[id], 0);
+    net.add(Graph::INPUT, Graph::OUTPUT, FlowNetwork::UNBOUNDED, -total);
+    net.add(Graph::OUTPUT, Graph::INPUT, FlowNetwork::UNBOUNDED, total);
+    net.flow(source, sink);
+
+    std::vector<uint32_t> via;
+    std::vector<int64_t>  potential = net.distances(UINT32_MAX, vars, via);
+    delays->resize(edges.size());
+    for ( uint32_t k = 0; k < edges.size(); k++ ) {
+        const LatencyEdge& e = edges[k];
+        (*delays)[k] = static_cast<uint32_t>(potential[e.src] - potential[e.dst] - static_cast<int64_t>(lat[e.src]));
+    }
+    return static_cast<size_t>(total);
+}
+
+std::unique_ptr<GraphPlan> Graph::compile(uint32_t sample_rate, size_t max_block) const {
+    return compile(sample_rate, max_block, CompileOptions());
+}
+
+std::unique_ptr<GraphPlan> Graph::compile(uint32_t sample_rate, size_t max_block, const CompileOptions& options) const {
+    const Impl& g = *pimpl;
+    if ( !max_block )
+        throw GraphUserError("max_block must be at least 1!");
+
+    std::vector<NodeId> order = g.sort();
+
+    // Each node output port is one value; sums add values of their own
+    std::vector<uint32_t> first_value(g.nodes.size(), 0);
+    uint32_t values = 0;
+    for ( NodeId id : order ) {
+        first_value[id] = values;
+        values         += g.num_outputs(id);
+    }
+    auto ref_of = [&](NodeId src, unsigned port) {
+        return src == INPUT ? Ref{Ref::EXTERNAL, port} : Ref{Ref::VALUE, first_value[src] + port};
+    };
+
+    // Latency compensation: one tapped line per delayed output port, one
+    // tap per distinct delay; each tap is a value. Feedback edges are
+    // left out, their delay being a block whatever the latencies
+    std::vector<size_t> lat(g.nodes.size(), 0);
+    for ( NodeId id : order )
+        lat[id] = g.nodes[id]->latency();
+    std::vector<const GraphEdge*> forward;
+    std::vector<LatencyEdge>      lat_edges;
+    for ( const GraphEdge& e : g.edges ) {
+        if ( e.feedback )
+            continue;
+        forward.push_back(&e);
+        lat_edges.push_back(LatencyEdge{e.src, e.src_port, e.dst});
+    }
+    std::vector<uint32_t> delays;
+    size_t total = schedule_latency(lat, lat_edges, order, options.compensate ? &delays : nullptr);
+    delays.resize(forward.size(), 0);
+
+    struct Line {
+        NodeId                             src;
+        unsigned                           port;
+        std::vector<uint32_t>              taps;  // ascending
+        uint32_t                           first_value;
+        std::shared_ptr<CompensationDelay> node;
+    };
+    std::vector<Line>     lines;
+    std::vector<uint32_t> edge_comp(forward.size(), NO_TAP);
+    std::vector<uint32_t> edge_tap(forward.size(), 0);
+    for ( size_t k = 0; k < forward.size(); k++ ) {
+        if ( !delays[k] )
+            continue;
+        const GraphEdge& e = *forward[k];
+        size_t c = 0;
+        while ( c < lines.size() && (lines[c].src != e.src || lines[c].port != e.src_port) )
+            c++;
+        if ( c == lines.size() )
+            lines.push_back(Line{e.src, e.src_port, {}, 0, nullptr});
+        lines[c].taps.push_back(delays[k]);
+        edge_comp[k] = static_cast<uint32_t>(c);
+    }
+    std::map<std::pair<NodeId, unsigned>, std::shared_ptr<CompensationDelay>> kept;
+    for ( Line& line : lines ) {
+        std::sort(line.taps.begin(), line.taps.end());
+        line.taps.erase(std::unique(line.taps.begin(), line.taps.end()), line.taps.end());
+        line.first_value = values;
+        values          += static_cast<uint32_t>(line.taps.size());
+
+        // A line with the same taps carries on with what it holds
+        std::shared_ptr<CompensationDelay>& old = g.compensation[std::make_pair(line.src, line.port)];
+        line.node = old && old->matches(line.taps, max_block) ? old : std::make_shared<CompensationDelay>(line.taps, max_block);
+        kept[std::make_pair(line.src, line.port)] = line.node;
+    }
+    g.compensation.swap(kept);
+    for ( size_t k = 0; k < forward.size(); k++ ) {
+        if ( edge_comp[k] == NO_TAP )
+            continue;
+        const std::vector<uint32_t>& taps = lines[edge_comp[k]].taps;
+        edge_tap[k] = static_cast<uint32_t>(std::lower_bound(taps.begin(), taps.end(), delays[k]) - taps.begin());
+    }
+
+    // Sources of every input port
+    std::vector<std::vector<std::vector<Ref>>> sources(g.nodes.size());
+    for ( NodeId id = 0; id < g.nodes.size(); id++ )
+        if ( g.exists(id) )
+            sources[id].resize(g.num_inputs(id));
+    for ( size_t k = 0; k < forward.size(); k++ ) {
+        const GraphEdge& e = *forward[k];
+        Ref src = edge_comp[k] == NO_TAP ? ref_of(e.src, e.src_port)
+                                         : Ref{Ref::VALUE, lines[edge_comp[k]].first_value + edge_tap[k]};
+        sources[e.dst][e.dst_port].push_back(src);
+    }
+    for ( const GraphEdge& e : g.edges )
+        if ( e.feedback )
+            sources[e.dst][e.dst_port].push_back(Ref{Ref::FEEDBACK, ref_of(e.src, e.src_port).index});
+
+    // Schedule: per node, a sum for each port with several sources, then
+    // the node, then the lines delaying its outputs
+    std::vector<StepRefs> steps;
+    auto delay_outputs = [&](NodeId id) {
+        for ( const Line& line : lines ) {
+            if ( line.src != id )
+                continue;
+            StepRefs step{line.node.get(), {ref_of(line.src, line.port)}, {}};
+            for ( uint32_t t = 0; t < line.taps.size(); t++ )
+                step.out.push_back(Ref{Ref::VALUE, line.first_value + t});
+            steps.push_back(step);
+        }
+    };
+    delay_outputs(INPUT);
+    for ( NodeId id : order ) {
+        StepRefs node_step{g.nodes[id].get(), {}, {}};
+        for ( std::vector<Ref>& srcs : sources[id] ) {
+            if ( srcs.empty() ) {
+                node_step.in.push_back(Ref{Ref::SILENT, 0});
+            } else if ( srcs.size() == 1 ) {
+                node_step.in.push_back(srcs[0]);
+            } else {
+                Ref sum{Ref::VALUE, values++};
+                steps.push_back(StepRefs{nullptr, srcs, {sum}});
+                node_step.in.push_back(sum);
+            }
+        }
+        for ( unsigned p = 0; p < g.num_outputs(id); p++ )
+            node_step.out.push_back(Ref{Ref::VALUE, first_value[id] + p});
+        steps.push_back(node_step);
+        delay_outputs(id);
+    }
+    for ( unsigned ch = 0; ch < g.n_out; ch++ )
+        steps.push_back(StepRefs{nullptr, sources[OUTPUT][ch], {Ref{Ref::EXTERNAL, ch}}});
+
+    // Liveness: the last step reading each value (its producer if none)
+    std::vector<uint32_t> last_use(values, 0);
+    for ( uint32_t s = 0; s < steps.size(); s++ ) {
+        for ( const Ref& r : steps[s].out )
+            if ( r.kind == Ref::VALUE )
+                last_use[r.index] = s;
+        for ( const Ref& r : steps[s].in )
+            if ( r.kind == Ref::VALUE )
+                last_use[r.index] = s;
+    }
+
+    // Slots: outputs are taken before inputs are released, so a step
+    // never writes into a buffer it reads. A reused slot orders its new
+    // writer after every step that used it before; parallel plans only
+    // reuse slots whose users are already ancestors of the writer
+    std::unique_ptr<GraphPlan> plan(new GraphPlan());
+    GraphPlan::Impl& p = *plan->pimpl;
+
+    const size_t nsteps = steps.size();
+    const size_t words  = (nsteps + 63) / 64;
+    std::vector<uint64_t>              ancestors(nsteps * words, 0);
+    std::vector<std::vector<uint32_t>> preds(nsteps);
+    std::vector<uint32_t>              producer(values, 0);
+    auto is_ancestor = [&](uint32_t a, uint32_t s) {
+        return (ancestors[s * words + a / 64] >> (a % 64)) & 1;
+    };
+    auto add_pred = [&](uint32_t a, uint32_t s) {
+        if ( is_ancestor(a, s) )
+            return;
+        preds[s].push_back(a);
+        uint64_t* dst = &ancestors[s * words];
+        const uint64_t* src = &ancestors[a * words];
+        for ( size_t w = 0; w < words; w++ )
+            dst[w] |= src[w];
+        dst[a / 64] |= uint64_t(1) << (a % 64);
+    };
+
+    std::vector<uint32_t>              slot_of(values, 0);
+    std::vector<std::vector<uint32_t>> users(1);   // per slot, steps that wrote or read it since it was last taken
+    std::vector<uint32_t>              free_slots; // ascending
+    std::vector<uint32_t>              in_slots, out_slots;
+
+    // Values read by feedback edges keep a pair of slots of their own:
+    // each block writes one half while the feedback reads the other,
+    // which the last block wrote, and the halves swap between blocks
+    std::vector<char> pinned(values, 0);
+    for ( const GraphEdge& e : g.edges ) {
+        uint32_t v = ref_of(e.src, e.src_port).index;
+        if ( e.feedback && !pinned[v] ) {
+            pinned[v]  = 1;
+            slot_of[v] = static_cast<uint32_t>(p.nslots + 1);
+            p.nslots  += 2;
+            users.resize(p.nslots + 1);
+        }
+    }
+    auto flip = [&](const Ref& r, bool out, uint32_t entry) {
+        if ( r.kind == Ref::FEEDBACK || (r.kind == Ref::VALUE && pinned[r.index]) )
+            p.flips.push_back(PlanFlip{entry, slot_of[r.index], out, r.kind == Ref::FEEDBACK});
+    };
+
+    auto release = [&](const Ref& r, uint32_t s) {
+        if ( r.kind == Ref::VALUE && last_use[r.index] == s && slot_of[r.index] && !pinned[r.index] ) {
+            uint32_t slot = slot_of[r.index];
+            free_slots.insert(std::lower_bound(free_slots.begin(), free_slots.end(), slot), slot);
+            slot_of[r.index] = 0;
+        }
+    };
+    auto take = [&](uint32_t s) {
+        for ( size_t k = 0; k < free_slots.size(); k++ ) {
+            uint32_t slot = free_slots[k];
+            if ( options.parallel ) {
+                bool ordered = true;
+                for ( uint32_t u : users[slot] )
+                    ordered = ordered && is_ancestor(u, s);
+                if ( !ordered )
+                    continue;
+            }
+            for ( uint32_t u : users[slot] )
+                add_pred(u, s);
+            free_slots.erase(free_slots.begin() + k);
+            return slot;
+        }
+        users.emplace_back();
+        return static_cast<uint32_t>(++p.nslots);
+    };
+
+    for ( uint32_t s = 0; s < nsteps; s++ ) {
+        for ( const Ref& r : steps[s].in )
+            if ( r.kind == Ref::VALUE )
+                add_pred(producer[r.index], s);
+
+        for ( const Ref& r : steps[s].out ) {
+            if ( r.kind != Ref::VALUE )
+                continue;
+            producer[r.index] = s;
+            if ( pinned[r.index] )
+                continue;
+            uint32_t slot    = take(s);
+            slot_of[r.index] = slot;
+            users[slot].clear();
+        }
+
+        // Table entries, as slot numbers while the slots of this step are known
+        PlanStep step{steps[s].node, static_cast<uint32_t>(in_slots.size()), static_cast<uint32_t>(steps[s].in.size()),
+                      static_cast<uint32_t>(out_slots.size()), static_cast<uint32_t>(steps[s].out.size())};
+        for ( const Ref& r : steps[s].in ) {
+            if ( r.kind == Ref::EXTERNAL )
+                p.in_patches.push_back(PlanPatch{static_cast<uint32_t>(in_slots.size()), r.index});
+            if ( r.kind == Ref::VALUE )
+                users[slot_of[r.index]].push_back(s);
+            flip(r, false, static_cast<uint32_t>(in_slots.size()));
+            in_slots.push_back(r.kind == Ref::VALUE || r.kind == Ref::FEEDBACK ? slot_of[r.index] : 0);
+        }
+        for ( const Ref& r : steps[s].out ) {
+            if ( r.kind == Ref::EXTERNAL )
+                p.out_patches.push_back(PlanPatch{static_cast<uint32_t>(out_slots.size()), r.index});
+            if ( r.kind == Ref::VALUE )
+                users[slot_of[r.index]].push_back(s);
+            flip(r, true, static_cast<uint32_t>(out_slots.size()));
+            out_slots.push_back(r.kind == Ref::VALUE ? slot_of[r.index] : 0);
+        }
+        p.schedule.push_back(step);
+
+        for ( const Ref& r : steps[s].in )
+            release(r, s);
+        for ( const Ref& r : steps[s].out )
+            release(r, s);
+    }
+
+    // Dependencies as counts and successor lists, for runners
+    p.deps.resize(nsteps);
+    p.first_next.assign(nsteps + 1, 0);
+    for ( uint32_t s = 0; s < nsteps; s++ ) {
+        p.deps[s] = static_cast<uint32_t>(preds[s].size());
+        if ( preds[s].empty() )
+            p.roots.push_back(s);
+        for ( uint32_t a : preds[s] )
+            p.first_next[a + 1]++;
+    }
+    for ( size_t s = 0; s < nsteps; s++ )
+        p.first_next[s + 1] += p.first_next[s];
+    p.next.resize(p.first_next[nsteps]);
+    std::vector<uint32_t> fill(p.first_next.begin(), p.first_next.end() - 1);
+    for ( uint32_t s = 0; s < nsteps; s++ )
+        for ( uint32_t a : preds[s] )
+            p.next[fill[a]++] = s;
+    p.pending.reset(new std::atomic<uint32_t>[nsteps]);
+    p.ready.reset(new std::atomic<uint32_t>[nsteps]);
+    p.parallel = options.parallel;
+
+    // Slot numbers become addresses now the pool size is known
+    p.n_in   = g.n_in;
+    p.n_out  = g.n_out;
+    p.block  = max_block;
+    p.stride = (max_block + 15) & ~static_cast<size_t>(15);
+    p.pool.allocate((p.nslots + 1) * p.stride);
+    for ( uint32_t slot : in_slots )
+        p.ins.push_back(p.pool.data() + slot * p.stride);
+    for ( uint32_t slot : out_slots )
+        p.outs.push_back(p.pool.data() + slot * p.stride);
+
+    for ( NodeId id : order ) {
+        p.nodes.push_back(g.nodes[id]);
+        Impl::Prepared& done = g.prepared[id];
+        if ( done.sample_rate != sample_rate || done.max_block != max_block ) {
+            g.nodes[id]->prepare(sample_rate, max_block);
+            done.sample_rate = sample_rate;
+            done.max_block   = max_block;
+        }
+    }
+
+    for ( const Line& line : lines ) {
+        p.nodes.push_back(line.node);
+        p.comps.push_back(line.node.get());
+    }
+
+    // Latency model, for update_latency
+    p.total_latency = total;
+    p.compensated   = options.compensate;
+    p.by_id.assign(g.nodes.size(), nullptr);
+    for ( NodeId id : order )
+        p.by_id[id] = g.nodes[id].get();
+    p.order     = order;
+    p.lat_edges = std::move(lat_edges);
+    p.edge_comp = std::move(edge_comp);
+    p.edge_tap  = std::move(edge_tap);
+
+    return plan;
+}
+
+// ---------------------------------------------------------------------
+// --- Graph Class Methods --- -----------------------------------------
+Graph::Graph(unsigned inputs, unsigned outputs): pimpl(new Impl(inputs, outputs)) {}
+
+Graph::~Graph() = default;
+
+unsigned Graph::inputs() const {
+    return pimpl->n_in;
+}
+
+unsigned Graph::outputs() const {
+    return pimpl->n_out;
+}
+
+Graph::NodeId Graph::add_node(std::shared_ptr<GraphNode> node) {
+    if ( !node )
+        throw GraphUserError("Can't add a null node!");
+    pimpl->nodes.push_back(std::move(node));
+    pimpl->prepared.emplace_back();
+    return static_cast<NodeId>(pimpl->nodes.size() - 1);
+}
+
+void Graph::remove_node(NodeId id) {
+    if ( id < 2 )
+        throw GraphUserError("The INPUT and OUTPUT nodes can't be removed!");
+    pimpl->check(id);
+    pimpl->nodes[id].reset();
+    std::vector<GraphEdge>& edges = pimpl->edges;
+    edges.erase(std::remove_if(edges.begin(), edges.end(),
+                               [id](const GraphEdge& e) { return e.src == id || e.dst == id; }),
+                edges.end());
+}
+
+std::shared_ptr<GraphNode> Graph::node(NodeId id) const {
+    pimpl->check(id);
+    return pimpl->nodes[id];
+}
+
+void Graph::connect(NodeId src, unsigned src_port, NodeId dst, unsigned dst_port) {
+    pimpl->connect(GraphEdge{src, src_port, dst, dst_port, false});
+}
+
+void Graph::connect_feedback(NodeId src, unsigned src_port, NodeId dst, unsigned dst_port) {
+    if ( src == INPUT )
+        throw GraphUserError("Feedback must come from a node, not the graph inputs!");
+    pimpl->connect(GraphEdge{src, src_port, dst, dst_port, true});
+}
+
+bool Graph::disconnect(NodeId src, unsigned src_port, NodeId dst, unsigned dst_port) {
+    std::vector<GraphEdge>& edges = pimpl->edges;
+    auto it = std::find(edges.begin(), edges.end(), GraphEdge{src, src_port, dst, dst_port});
+    if ( it == edges.end() )
+        return false;
+    edges.erase(it);
+    return true;
+}
@@ -0,0 +1,245 @@
+/**
+ * @file graph.hpp
+ * @brief Provides @b Graph, a processing graph compiled into a flat @b GraphPlan
+ */
+#ifndef SIMPLY_GRAPH_HPP_
+#define SIMPLY_GRAPH_HPP_
+
+#include <string>
+#include <exception>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class GraphException
+ * @brief This is the base class of all exceptions thrown by @b Graph and @b GraphPlan
+ */
+class GraphException: public std::exception {
+    protected:
+        std::string msg;
+        explicit GraphException(const std::string& msg): msg(msg) {}
+
+    public:
+        /// @brief Get a message describing the error
+        /// @return NULL-terminated c-string
+        const char* what() const noexcept override { return msg.c_str(); }
+};
+
+/**
+ * @class GraphUserError
+ * @brief This means a node, port or connection was invalid, or the graph has a cycle
+ */
+class GraphUserError: public GraphException {
+    public:
+        explicit GraphUserError(const std::string& msg): GraphException("GraphUserError: " + msg) {}
+};
+
+/**
+ * @class GraphNode
+ * @brief Interface of one processor in a @b Graph
+ *
+ * Every port carries one channel of audio. @b process gets one buffer per
+ * input and one per output; the inputs are read-only and may be shared
+ * with other nodes, and the outputs must be written in full.
+ */
+class GraphNode {
+    public:
+        virtual ~GraphNode() = default;
+
+        /// @brief Number of input ports
+        virtual unsigned num_inputs() const = 0;
+
+        /// @brief Number of output ports
+        virtual unsigned num_outputs() const = 0;
+
+        /// @brief Called on the control thread when first compiled into a plan, before any @b process
+        /// @note Called again only when a graph is compiled for another sample rate or block size,
+        ///       so a node kept across recompiles keeps its state
+        virtual void prepare(uint32_t sample_rate, size_t max_block) { (void) sample_rate; (void) max_block; }
+
+        /// @brief Process @p frames frames, at most the @p max_block given to @b prepare
+        virtual void process(const float* const* in, float* const* out, size_t frames) = 0;
+
+        /// @brief Delay in frames from the inputs to the outputs
+        virtual size_t latency() const { return 0; }
+};
+
+class GraphPlan;
+
+/**
+ * @class Graph
+ * @brief Nodes and connections, declared on the control thread
+ *
+ * The graph's own inputs and outputs are the output ports of the
+ * @b INPUT node and the input ports of the @b OUTPUT node. An input port
+ * connected to several outputs receives their sum; one left unconnected
+ * receives silence. An output port may feed any number of inputs.
+ *
+ * Connections must not form cycles, except through feedback connections
+ * (@b connect_feedback), which deliver the previous block's output. They
+ * are left out of the sort, so a graph with loops still compiles to the
+ * same flat schedule, and can run in parallel.
+ *
+ * @b compile turns the graph into a @b GraphPlan for the audio thread.
+ *
+ * Paths of different latency are realigned by delay lines the compiler
+ * inserts (plugin delay compensation), so every node input and every
+ * graph output lines up with the slowest path into it. The lines are
+ * placed to need the least delay memory: one tapped line per delayed
+ * output port, as long as its longest tap, with each node started
+ * wherever in its slack the lines around it come out shortest.
+ */
+class Graph {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /// @typedef NodeId
+        /// @brief Identifies a node within its graph
+        typedef uint32_t NodeId;
+
+        /// @brief The graph inputs, as a node with one output port per channel
+        static const NodeId INPUT  = 0;
+        /// @brief The graph outputs, as a node with one input port per channel
+        static const NodeId OUTPUT = 1;
+
+        /**
+         * @struct CompileOptions
+         * @brief How a plan is laid out
+         */
+        struct CompileOptions {
+            /// Only reuse a buffer slot where the dependencies already order
+            /// the steps, so independent branches can run concurrently on a
+            /// @b ParallelGraphRunner; costs more slots than a serial plan
+            bool parallel   = false;
+            /// Delay the shorter paths into every node and output to match
+            /// the longest, so they line up in time
+            bool compensate = true;
+        };
+
+        /// @brief Graph with @p inputs input and @p outputs output channels
+        Graph(unsigned inputs, unsigned outputs);
+
+        ~Graph();
+
+        Graph(const Graph&) = delete;
+        Graph& operator=(const Graph&) = delete;
+
+        /// @brief Number of graph input channels
+        unsigned inputs() const;
+
+        /// @brief Number of graph output channels
+        unsigned outputs() const;
+
+        /// @brief Add @p node, which may not be added again
+        /// @throws GraphUserError if @p node is null
+        NodeId add_node(std::shared_ptr<GraphNode> node);
+
+        /// @brief Remove @p id and all its connections
+        /// @throws GraphUserError if @p id is not a node of this graph
+        void remove_node(NodeId id);
+
+        /// @brief Get the node behind @p id
+        std::shared_ptr<GraphNode> node(NodeId id) const;
+
+        /// @brief Feed output @p src_port of @p src into input @p dst_port of @p dst
+        /// @throws GraphUserError if a node or port doesn't exist, or the connection already does
+        void connect(NodeId src, unsigned src_port, NodeId dst, unsigned dst_port);
+
+        /// @brief Feed output @p src_port of @p src into input @p dst_port of @p dst one block late
+        ///
+        /// Closes a loop, e.g. for a delay network or a sidechain from a
+        /// later node. The value is double-buffered: each block writes one
+        /// half while the feedback reads the other, which the block before
+        /// wrote, and the halves swap between blocks. Nothing is copied; with
+        /// blocks of a constant size the delay is exactly one block. The first
+        /// block reads silence. Feedback is not counted in latencies nor compensated.
+        ///
+        /// As the delay is the block size, a loop sounds different at another
+        /// one: an @b OfflineRenderer must run the live block size to match.
+        /// @throws GraphUserError if a node or port doesn't exist, @p src is @b INPUT, or the connection already does
+        void connect_feedback(NodeId src, unsigned src_port, NodeId dst, unsigned dst_port);
+
+        /// @brief Remove a connection made with @b connect or @b connect_feedback
+        /// @return `false` if there was no such connection
+        bool disconnect(NodeId src, unsigned src_port, NodeId dst, unsigned dst_port);
+
+        /// @brief Sort, allocate buffers and prepare new nodes for blocks of up to @p max_block frames
+        /// @throws GraphUserError if the graph has a cycle other than through feedback connections
+        std::unique_ptr<GraphPlan> compile(uint32_t sample_rate, size_t max_block) const;
+
+        /// @brief Compile with @p options
+        /// @throws GraphUserError if the graph has a cycle
+        std::unique_ptr<GraphPlan> compile(uint32_t sample_rate, size_t max_block, const CompileOptions& options) const;
+};
+
+/**
+ * @class GraphPlan
+ * @brief A compiled @b Graph: a flat schedule the audio thread walks
+ *
+ * Nodes are sorted topologically and every port is resolved at compile
+ * time to a buffer slot, so @b process just walks an array of steps with
+ * ready-made pointer tables: it never allocates, looks anything up or
+ * follows the graph structure.
+ *
+ * Slots are assigned by liveness: a slot is reused as soon as the last
+ * step reading it has run, so the number of buffers follows the widest
+ * point of the graph rather than its size.
+ *
+ * The plan also records which steps each step waits for, through values
+ * and through reused slots, which lets a @b ParallelGraphRunner run it.
+ *
+ * @note Holds the graph's nodes by shared pointer, so it stays valid after the @b Graph changes or is destroyed
+ */
+class GraphPlan {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+        GraphPlan();
+        friend class Graph;
+        friend class ParallelGraphRunner;
+
+    public:
+        ~GraphPlan();
+
+        GraphPlan(const GraphPlan&) = delete;
+        GraphPlan& operator=(const GraphPlan&) = delete;
+
+        /// @brief Number of input channels
+        unsigned inputs() const;
+
+        /// @brief Number of output channels
+        unsigned outputs() const;
+
+        /// @brief Largest block in frames
+        size_t max_block() const;
+
+        /// @brief Number of steps (nodes and sums) in the schedule
+        size_t steps() const;
+
+        /// @brief Number of buffer slots, besides the shared silent one
+        size_t slots() const;
+
+        /// @brief Check if compiled with @b Graph::CompileOptions::parallel
+        bool parallel() const;
+
+        /// @brief Longest delay from any input to any output, summing node latencies
+        size_t latency() const;
+
+        /// @brief Retune the compensation after a node's @b GraphNode::latency changed
+        ///
+        /// Call from the control thread; the plan may be running. Delays
+        /// are adjusted in place, keeping the lines' contents, when the
+        /// new ones fit the lines laid out at compile time.
+        /// @return `false` if they don't, and the graph must be compiled again
+        bool update_latency();
+
+        /// @brief Run the graph on @p frames frames
+        /// @throws GraphUserError if @p frames exceeds @b max_block
+        void process(const float* const* in, float* const* out, size_t frames);
+};
+
+#endif // SIMPLY_GRAPH_HPP_
@@ -0,0 +1,213 @@
+// Layout of a compiled GraphPlan, shared by the graph compiler and the
+// runners that execute plans
+//
+// Not part of the public interface, only include from graph*.cpp
+#ifndef SIMPLY_GRAPH_COMMON_HPP_
+#define SIMPLY_GRAPH_COMMON_HPP_
+
+#include "graph.hpp"
+#include "delay.hpp"
+#include "memory.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// ---------------------------------------------------------------------
+// --- Plan Layout --- -------------------------------------------------
+// One entry of the schedule; its ports are ranges of the flat pointer tables
+struct PlanStep {
+    GraphNode* node;   // nullptr to write the sum of the inputs to the single output
+    uint32_t   in;     // first entry in the input table
+    uint32_t   n_in;
+    uint32_t   out;    // first entry in the output table
+    uint32_t   n_out;
+};
+
+// A table entry that points at a caller's buffer, filled in per block
+struct PlanPatch {
+    uint32_t entry;
+    uint32_t channel;
+};
+
+// A table entry on a feedback value's pair of slots, pointed at the other
+// half every block
+struct PlanFlip {
+    uint32_t entry;
+    uint32_t slot;     // first of the pair
+    bool     out;      // in the output table
+    bool     previous; // the half the last block wrote
+};
+
+// out = sum of n buffers (silence if n is 0)
+inline void sum_buffers(const float* const* in, uint32_t n, float* out, size_t frames) {
+    if ( !n ) {
+        std::fill(out, out + frames, 0.0f);
+        return;
+    }
+    if ( in[0] != out )
+        std::copy(in[0], in[0] + frames, out);
+    for ( uint32_t k = 1; k < n; k++ ) {
+        const float* src = in[k];
+        size_t i = 0;
+        for ( ; i + 4 <= frames; i += 4 )
+            (float4::load(out + i) + float4::load(src + i)).store(out + i);
+        for ( ; i < frames; i++ )
+            out[i] += src[i];
+    }
+}
+
+// ---------------------------------------------------------------------
+// --- Latency Compensation --- ----------------------------------------
+// Delays one output port of a node by a few amounts at once, one tap
+// (output port) per amount. Inserted by the compiler; tap delays are
+// atomic so a plan can be retuned while it runs
+class CompensationDelay: public GraphNode {
+    protected:
+        DelayLine                                line;
+        unsigned                                 ntaps;
+        std::unique_ptr<std::atomic<uint32_t>[]> taps;
+
+        // A DelayLine's buffer is a power of two; size the line to the
+        // longest delay that fits in it anyway, as headroom for retuning
+        static size_t room(const std::vector<uint32_t>& delays, size_t max_block) {
+            size_t longest = delays.empty() ? 0 : *std::max_element(delays.begin(), delays.end());
+            size_t length  = 1;
+            while ( length < longest + max_block + 4 )
+                length <<= 1;
+            return length - max_block - 4;
+        }
+
+    public:
+        CompensationDelay(const std::vector<uint32_t>& delays, size_t max_block):
+            line(room(delays, max_block), DelayLine::Options{max_block}),
+            ntaps(static_cast<unsigned>(delays.size())), taps(new std::atomic<uint32_t>[delays.size()]) {
+            for ( unsigned t = 0; t < ntaps; t++ )
+                taps[t].store(delays[t], std::memory_order_relaxed);
+        }
+
+        unsigned num_inputs() const override { return 1; }
+
+        unsigned num_outputs() const override { return ntaps; }
+
+        void process(const float* const* in, float* const* out, size_t frames) override {
+            line.write(in[0], frames);
+            for ( unsigned t = 0; t < ntaps; t++ )
+                line.read_whole(taps[t].load(std::memory_order_relaxed), out[t], frames);
+        }
+
+        size_t longest() const { return line.max_delay(); }
+
+        void set_delay(unsigned tap, uint32_t delay) { taps[tap].store(delay, std::memory_order_relaxed); }
+
+        // Whether this line already delays by exactly @p delays, for blocks of @p max_block
+        bool matches(const std::vector<uint32_t>& delays, size_t max_block) const {
+            if ( delays.size() != ntaps || line.max_block() != max_block )
+                return false;
+            for ( unsigned t = 0; t < ntaps; t++ )
+                if ( taps[t].load(std::memory_order_relaxed) != delays[t] )
+                    return false;
+            return true;
+        }
+};
+
+// A connection, as seen by latency compensation
+struct LatencyEdge {
+    uint32_t src;
+    uint32_t src_port;
+    uint32_t dst;
+};
+
+static const uint32_t NO_TAP = UINT32_MAX;
+
+// ====== GraphPlan Implementation ======
+struct GraphPlan::Impl {
+    unsigned                                n_in  = 0;
+    unsigned                                n_out = 0;
+    size_t                                  block = 0;
+    size_t                                  stride = 0;  // floats per slot
+    size_t                                  nslots = 0;
+    size_t                                  total_latency = 0;
+    bool                                    parallel = false;
+    std::vector<std::shared_ptr<GraphNode>> nodes;       // keeps the nodes alive
+    std::vector<PlanStep>                   schedule;
+    std::vector<const float*>               ins;
+    std::vector<float*>                     outs;
+    std::vector<PlanPatch>                  in_patches;
+    std::vector<PlanPatch>                  out_patches;
+    AlignedBuffer<float>                    pool;        // slot 0 is the silent one
+    std::vector<PlanFlip>                   flips;
+    uint32_t                                parity = 0;  // half of each pair written this block
+
+    // Dependencies between steps, through values and through reused slots:
+    // step s waits for deps[s] steps, and unblocks next[first_next[s] ..
+    // first_next[s + 1]) when done
+    std::vector<uint32_t>                   deps;
+    std::vector<uint32_t>                   first_next;
+    std::vector<uint32_t>                   next;
+    std::vector<uint32_t>                   roots;       // steps without dependencies
+
+    // Latency model, to retune the compensation when node latencies change:
+    // the graph's nodes by id, its edges, and the compensation tap of each
+    bool                                    compensated = false;
+    std::vector<GraphNode*>                 by_id;
+    std::vector<uint32_t>                   order;       // node ids, topologically
+    std::vector<LatencyEdge>                lat_edges;
+    std::vector<uint32_t>                   edge_comp;   // NO_TAP if not delayed
+    std::vector<uint32_t>                   edge_tap;
+    std::vector<CompensationDelay*>         comps;
+
+    // Scratch of the runner executing the plan in parallel
+    std::unique_ptr<std::atomic<uint32_t>[]> pending;    // per step, dependencies left
+    std::unique_ptr<std::atomic<uint32_t>[]> ready;      // steps in the order they became ready
+
+    void check(size_t frames) const {
+        if ( frames > block )
+            throw GraphUserError("Block is larger than the plan's max_block!");
+    }
+
+    void patch(const float* const* in, float* const* out) {
+        for ( const PlanPatch& p : in_patches )
+            ins[p.entry] = in[p.channel];
+        for ( const PlanPatch& p : out_patches )
+            outs[p.entry] = out[p.channel];
+        if ( flips.empty() )
+            return;
+        parity ^= 1;
+        for ( const PlanFlip& f : flips ) {
+            float* half = pool.data() + (f.slot + (parity ^ f.previous)) * stride;
+            if ( f.out )
+                outs[f.entry] = half;
+            else
+                ins[f.entry] = half;
+        }
+    }
+
+    void run(uint32_t step, size_t frames) {
+        const PlanStep& s = schedule[step];
+        if ( s.node )
+            s.node->process(ins.data() + s.in, outs.data() + s.out, frames);
+        else
+            sum_buffers(ins.data() + s.in, s.n_in, outs[s.out], frames);
+    }
+
+    void process(const float* const* in, float* const* out, size_t frames) {
+        check(frames);
+        patch(in, out);
+
+        const float* const* i = ins.data();
+        float* const*       o = outs.data();
+        for ( const PlanStep& s : schedule ) {
+            if ( s.node )
+                s.node->process(i + s.in, o + s.out, frames);
+            else
+                sum_buffers(i + s.in, s.n_in, o[s.out], frames);
+        }
+    }
+};
+
+#endif // SIMPLY_GRAPH_COMMON_HPP_
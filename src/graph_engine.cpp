@@ -0,0 +1,139 @@
+#include "graph_engine.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+static const uint64_t IDLE = UINT64_MAX; // the audio thread is between blocks
+
+// ====== GraphEngine Implementation ======
+// A plan retired at epoch E is unreachable once the audio thread is idle
+// or has started a block at an epoch of at least E: the exchange came
+// before the epoch was bumped, and a block reads the epoch before loading
+// the plan. All of these operations are sequentially consistent.
+struct GraphEngine::Impl {
+    unsigned                n_in;
+    unsigned                n_out;
+    std::atomic<GraphPlan*> current{nullptr};
+    std::atomic<uint64_t>   epoch{0};
+    std::atomic<uint64_t>   reader{IDLE}; // epoch the running block started in
+
+    struct Retired {
+        uint64_t                   epoch;
+        std::unique_ptr<GraphPlan> plan;
+    };
+    mutable std::mutex   lock;    // for the control side only
+    std::vector<Retired> retired;
+
+    Impl(unsigned inputs, unsigned outputs): n_in(inputs), n_out(outputs) {}
+
+    ~Impl() {
+        delete current.load();
+    }
+
+    void publish(std::unique_ptr<GraphPlan> plan) {
+        if ( !plan )
+            throw GraphUserError("Can't publish a null plan!");
+        if ( plan->inputs() != n_in || plan->outputs() != n_out )
+            throw GraphUserError("Plan channels don't match the engine's!");
+
+        std::lock_guard<std::mutex> guard(lock);
+        retired.reserve(retired.size() + 1); // so retiring below can't throw
+        GraphPlan* old = current.exchange(plan.release());
+        uint64_t   e   = epoch.fetch_add(1) + 1;
+        if ( old )
+            retired.push_back(Retired{e, std::unique_ptr<GraphPlan>(old)});
+    }
+
+    size_t collect() {
+        std::vector<std::unique_ptr<GraphPlan>> done;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            uint64_t r = reader.load();
+            auto keep = std::partition(retired.begin(), retired.end(),
+                                       [r](const Retired& x) { return r != IDLE && r < x.epoch; });
+            for ( auto it = keep; it != retired.end(); ++it )
+                done.push_back(std::move(it->plan));
+            retired.erase(keep, retired.end());
+        }
+        return done.size(); // plans are freed here, outside the lock
+    }
+
+    // Pin the current plan for one block
+    GraphPlan* enter() {
+        reader.store(epoch.load());
+        return current.load();
+    }
+
+    void leave() {
+        reader.store(IDLE);
+    }
+
+    void silence(float* const* out, size_t frames) {
+        for ( unsigned ch = 0; ch < n_out; ch++ )
+            std::fill(out[ch], out[ch] + frames, 0.0f);
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- GraphEngine Class Methods --- -----------------------------------
+GraphEngine::GraphEngine(unsigned inputs, unsigned outputs): pimpl(new Impl(inputs, outputs)) {}
+
+GraphEngine::~GraphEngine() = default;
+
+unsigned GraphEngine::inputs() const {
+    return pimpl->n_in;
+}
+
+unsigned GraphEngine::outputs() const {
+    return pimpl->n_out;
+}
+
+void GraphEngine::publish(std::unique_ptr<GraphPlan> plan) {
+    pimpl->publish(std::move(plan));
+}
+
+size_t GraphEngine::collect() {
+    return pimpl->collect();
+}
+
+size_t GraphEngine::retired() const {
+    std::lock_guard<std::mutex> guard(pimpl->lock);
+    return pimpl->retired.size();
+}
+
+bool GraphEngine::update_latency() {
+    std::lock_guard<std::mutex> guard(pimpl->lock);
+    GraphPlan* plan = pimpl->current.load();
+    return !plan || plan->update_latency();
+}
+
+void GraphEngine::process(const float* const* in, float* const* out, size_t frames) {
+    GraphPlan* plan = pimpl->enter();
+    try {
+        if ( plan )
+            plan->process(in, out, frames);
+        else
+            pimpl->silence(out, frames);
+    } catch ( ... ) {
+        pimpl->leave();
+        throw;
+    }
+    pimpl->leave();
+}
+
+void GraphEngine::process(ParallelGraphRunner& runner, const float* const* in, float* const* out, size_t frames) {
+    GraphPlan* plan = pimpl->enter();
+    try {
+        if ( plan )
+            runner.process(*plan, in, out, frames);
+        else
+            pimpl->silence(out, frames);
+    } catch ( ... ) {
+        pimpl->leave();
+        throw;
+    }
+    pimpl->leave();
+}
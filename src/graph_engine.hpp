@@ -0,0 +1,77 @@
+/**
+ * @file graph_engine.hpp
+ * @brief Provides @b GraphEngine, which swaps compiled graphs under a running audio thread
+ */
+#ifndef SIMPLY_GRAPH_ENGINE_HPP_
+#define SIMPLY_GRAPH_ENGINE_HPP_
+
+#include "graph.hpp"
+#include "graph_runner.hpp"
+
+#include <memory>
+#include <cstddef>
+
+/**
+ * @class GraphEngine
+ * @brief Runs the current @b GraphPlan, which the control thread may replace at any time
+ *
+ * @b publish installs a new plan with one atomic pointer exchange; the
+ * audio thread picks it up at the start of its next block, so a change of
+ * topology never stops or blocks it. Nodes kept from one plan to the next
+ * are the same objects, so their state (delay lines, filter memories and
+ * so on) carries over; @b Graph::compile only prepares nodes new to it.
+ *
+ * Replaced plans are retired rather than freed: each is stamped with a
+ * new epoch, and @b process records the epoch it started each block in.
+ * @b collect, called on any non-real-time thread, frees the plans that
+ * the audio thread can no longer be running, so the audio thread never
+ * frees memory or takes a lock.
+ *
+ * @note @b process must only be called from one thread at a time
+ */
+class GraphEngine {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /// @brief Engine with @p inputs input and @p outputs output channels, outputting silence until a plan is published
+        GraphEngine(unsigned inputs, unsigned outputs);
+
+        /// @brief Frees every plan; the audio thread must have stopped calling @b process
+        ~GraphEngine();
+
+        GraphEngine(const GraphEngine&) = delete;
+        GraphEngine& operator=(const GraphEngine&) = delete;
+
+        /// @brief Number of input channels
+        unsigned inputs() const;
+
+        /// @brief Number of output channels
+        unsigned outputs() const;
+
+        /// @brief Make @p plan the one run from the next block on, retiring the current one
+        /// @throws GraphUserError if @p plan is null or its channel counts differ from the engine's
+        void publish(std::unique_ptr<GraphPlan> plan);
+
+        /// @brief Free the retired plans the audio thread is done with, from a non-real-time thread
+        /// @return Number of plans freed
+        size_t collect();
+
+        /// @brief Number of retired plans not freed yet
+        size_t retired() const;
+
+        /// @brief Retune the current plan's latency compensation, see @b GraphPlan::update_latency
+        /// @return `false` if the graph must be compiled and published again
+        bool update_latency();
+
+        /// @brief Run the current plan on @p frames frames (silence if there is none)
+        /// @throws GraphUserError if @p frames exceeds the plan's @b max_block
+        void process(const float* const* in, float* const* out, size_t frames);
+
+        /// @brief Run the current plan on @p runner
+        /// @throws GraphUserError if @p frames exceeds the plan's @b max_block
+        void process(ParallelGraphRunner& runner, const float* const* in, float* const* out, size_t frames);
+};
+
+#endif // SIMPLY_GRAPH_ENGINE_HPP_
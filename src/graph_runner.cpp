@@ -0,0 +1,197 @@
+#include "graph_runner.hpp"
+#include "graph_common.hpp"
+#include "futex.hpp"
+
+#include <atomic>
+
+static const uint32_t EMPTY = UINT32_MAX; // ready entry not filled in yet
+
+// ====== ParallelGraphRunner Implementation ======
+// Per block, the caller resets the plan's counters and publishes them
+// with running; helpers only touch a block's state while counted in busy,
+// and only after seeing running, so the caller can reset it safely once
+// busy drops to 0
+struct ParallelGraphRunner::Impl {
+    Options             opts;
+    std::vector<Thread> team;
+    unsigned            created = 0; // team members with a thread, started or not
+
+    // State of the current block
+    GraphPlan::Impl*    plan   = nullptr;
+    uint32_t            nsteps = 0;
+    size_t              frames = 0;
+
+    alignas(64) std::atomic<uint32_t> head{0}; // next ready entry to claim
+    alignas(64) std::atomic<uint32_t> tail{0}; // next ready entry to fill
+    alignas(64) std::atomic<uint32_t> done{0}; // steps run
+    alignas(64) std::atomic<uint32_t> busy{0}; // helpers inside a block
+    std::atomic<uint32_t>             sleepers{0};
+    std::atomic<bool>                 running{false};
+    std::atomic<bool>                 stopping{false};
+    Futex                             cycle;   // bumped to start a block
+    Futex                             signal;  // bumped whenever a waited-for condition may have changed
+
+    Impl(unsigned helpers, const Options& options): opts(options) {
+        for ( unsigned core : opts.cores )
+            if ( core >= 64 )
+                throw GraphUserError("Core " + std::to_string(core) + " is out of range, only cores 0 to 63 can be selected!");
+
+        // Set every thread up before starting any, so a failure leaves
+        // nothing running
+        team.resize(helpers);
+        try {
+            for ( unsigned i = 0; i < helpers; i++ ) {
+                team[i].create(helper, this);
+                created++;
+                team[i].set_priority(opts.priority);
+                if ( !opts.cores.empty() )
+                    team[i].set_affinity(uint64_t(1) << opts.cores[i % opts.cores.size()]);
+            }
+            for ( Thread& t : team )
+                t.start();
+        } catch ( ... ) {
+            stop();
+            throw;
+        }
+    }
+
+    ~Impl() {
+        stop();
+    }
+
+    // Threads a failed constructor created but never started are started
+    // here, only to see stopping and return, as they can't be joined before
+    void stop() {
+        stopping.store(true);
+        cycle.fetch_add(1);
+        cycle.wake_all();
+        for ( unsigned i = 0; i < created; i++ ) {
+            try {
+                if ( !team[i].started() )
+                    team[i].start();
+                team[i].join();
+            } catch ( ... ) { ; }
+        }
+        team.clear();
+        created = 0;
+    }
+
+    void notify() {
+        signal.fetch_add(1);
+        if ( sleepers.load() )
+            signal.wake_all();
+    }
+
+    template <typename Condition>
+    void wait_until(Condition condition) {
+        for ( unsigned k = 0; k < opts.spin; k++ )
+            if ( condition() )
+                return;
+        while ( !condition() ) {
+            sleepers.fetch_add(1);
+            uint32_t seen = signal.load();
+            if ( !condition() )
+                signal.wait(seen);
+            sleepers.fetch_sub(1);
+        }
+    }
+
+    // Claim and run steps until none are left to claim
+    void work() {
+        GraphPlan::Impl& p = *plan;
+        const uint32_t   n = nsteps;
+        for ( ;; ) {
+            uint32_t i = head.fetch_add(1, std::memory_order_relaxed);
+            if ( i >= n )
+                return;
+
+            uint32_t step = EMPTY;
+            wait_until([&] { return (step = p.ready[i].load(std::memory_order_acquire)) != EMPTY; });
+            p.run(step, frames);
+
+            bool wake = false;
+            for ( uint32_t k = p.first_next[step]; k < p.first_next[step + 1]; k++ ) {
+                uint32_t next = p.next[k];
+                if ( p.pending[next].fetch_sub(1, std::memory_order_acq_rel) == 1 ) {
+                    p.ready[tail.fetch_add(1, std::memory_order_relaxed)].store(next, std::memory_order_release);
+                    wake = true;
+                }
+            }
+            if ( done.fetch_add(1, std::memory_order_acq_rel) + 1 == n )
+                wake = true;
+            if ( wake )
+                notify();
+        }
+    }
+
+    static int helper(void* data) {
+        Impl*    r    = static_cast<Impl*>(data);
+        uint32_t seen = 0;
+        for ( ;; ) {
+            uint32_t c;
+            while ( (c = r->cycle.load(std::memory_order_acquire)) == seen )
+                r->cycle.wait(seen);
+            seen = c;
+            if ( r->stopping.load() )
+                return 0;
+
+            r->busy.fetch_add(1);
+            if ( r->running.load() )
+                r->work();
+            if ( r->busy.fetch_sub(1) == 1 )
+                r->notify();
+        }
+    }
+
+    void process(GraphPlan::Impl& p, const float* const* in, float* const* out, size_t n_frames) {
+        p.check(n_frames);
+        p.patch(in, out);
+        const uint32_t n = static_cast<uint32_t>(p.schedule.size());
+        if ( team.empty() || n < 2 ) {
+            for ( uint32_t s = 0; s < n; s++ )
+                p.run(s, n_frames);
+            return;
+        }
+
+        // Helpers still leaving the last block may not see the reset
+        wait_until([&] { return busy.load() == 0; });
+        for ( uint32_t s = 0; s < n; s++ ) {
+            p.pending[s].store(p.deps[s], std::memory_order_relaxed);
+            p.ready[s].store(EMPTY, std::memory_order_relaxed);
+        }
+        uint32_t nroots = static_cast<uint32_t>(p.roots.size());
+        for ( uint32_t k = 0; k < nroots; k++ )
+            p.ready[k].store(p.roots[k], std::memory_order_relaxed);
+        tail.store(nroots, std::memory_order_relaxed);
+        head.store(0, std::memory_order_relaxed);
+        done.store(0, std::memory_order_relaxed);
+        plan   = &p;
+        nsteps = n;
+        frames = n_frames;
+
+        running.store(true);
+        cycle.fetch_add(1);
+        cycle.wake_all();
+
+        work();
+        wait_until([&] { return done.load(std::memory_order_acquire) == n; });
+        running.store(false);
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- ParallelGraphRunner Class Methods --- ---------------------------
+ParallelGraphRunner::ParallelGraphRunner(unsigned helpers): ParallelGraphRunner(helpers, Options()) {}
+
+ParallelGraphRunner::ParallelGraphRunner(unsigned helpers, const Options& options):
+    pimpl(new Impl(helpers, options)) {}
+
+ParallelGraphRunner::~ParallelGraphRunner() = default;
+
+unsigned ParallelGraphRunner::helpers() const {
+    return static_cast<unsigned>(pimpl->team.size());
+}
+
+void ParallelGraphRunner::process(GraphPlan& plan, const float* const* in, float* const* out, size_t frames) {
+    pimpl->process(*plan.pimpl, in, out, frames);
+}
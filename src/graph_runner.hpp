@@ -0,0 +1,79 @@
+/**
+ * @file graph_runner.hpp
+ * @brief Provides @b ParallelGraphRunner, to run a @b GraphPlan on a team of threads
+ */
+#ifndef SIMPLY_GRAPH_RUNNER_HPP_
+#define SIMPLY_GRAPH_RUNNER_HPP_
+
+#include "graph.hpp"
+#include "threads.hpp"
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+/**
+ * @class ParallelGraphRunner
+ * @brief Runs the independent branches of a @b GraphPlan concurrently
+ *
+ * A fixed team of helper threads, created up-front at
+ * @b Options::priority and optionally pinned to cores, joins the thread
+ * calling @b process (usually the audio callback) on every block. Each
+ * step of the plan holds an atomic count of the steps it waits for; the
+ * thread finishing the last of them appends it to a ready list, from
+ * which every thread claims the next step with a single atomic increment.
+ * @b process returns once all steps have run, so the block latency is
+ * unchanged.
+ *
+ * Between blocks the helpers sleep on a futex. Within a block, a thread
+ * with nothing to claim spins for @b Options::spin checks before sleeping.
+ *
+ * Plans compiled with @b Graph::CompileOptions::parallel run fastest, as
+ * their slots never order otherwise independent branches; other plans run
+ * correctly, only with less concurrency.
+ *
+ * @note A plan may only be run by one runner at a time, and nodes must not throw from @b GraphNode::process
+ */
+class ParallelGraphRunner {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /**
+         * @struct Options
+         * @brief The helper threads
+         */
+        struct Options {
+            /// Core of each helper thread (helper i gets cores[i % size]),
+            /// from 0 to 63; empty leaves them unpinned
+            std::vector<unsigned> cores;
+            /// Priority of the helper threads
+            Thread::Priority      priority = Thread::REAL_TIME;
+            /// Checks of a condition before sleeping on it
+            unsigned              spin     = 2000;
+        };
+
+        /// @brief Runner with @p helpers threads besides the caller of @b process
+        explicit ParallelGraphRunner(unsigned helpers);
+
+        /// @brief Create with @p options
+        /// @throws GraphUserError if a core is 64 or above
+        /// @throws ThreadUserError or ThreadRuntimeError if a thread can't be set up; those already set up are joined first
+        ParallelGraphRunner(unsigned helpers, const Options& options);
+
+        /// @brief Stops and joins the helper threads
+        ~ParallelGraphRunner();
+
+        ParallelGraphRunner(const ParallelGraphRunner&) = delete;
+        ParallelGraphRunner& operator=(const ParallelGraphRunner&) = delete;
+
+        /// @brief Number of helper threads
+        unsigned helpers() const;
+
+        /// @brief Run @p plan on @p frames frames, like @b GraphPlan::process
+        /// @throws GraphUserError if @p frames exceeds the plan's @b max_block
+        void process(GraphPlan& plan, const float* const* in, float* const* out, size_t frames);
+};
+
+#endif // SIMPLY_GRAPH_RUNNER_HPP_
@@ -0,0 +1,173 @@
+/**
+ * @file lockfree.hpp
+ * @brief Provides lock-free containers for passing data to/from real-time threads
+ */
+#ifndef SIMPLY_LOCKFREE_HPP_
+#define SIMPLY_LOCKFREE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @class SpscQueue
+ * @brief Fixed-capacity single-producer/single-consumer queue
+ *
+ * All slots are constructed up-front, so neither side ever allocates.
+ * Besides the copying @b try_push / @b try_pop, slots can be filled
+ * and drained in place, which avoids copying large elements (such as
+ * audio blocks) more than once.
+ *
+ * @note Exactly one thread may produce and exactly one thread may consume
+ */
+template <typename T>
+class SpscQueue {
+    private:
+        std::unique_ptr<T[]> slots;
+        size_t               mask;
+
+        // Kept on separate cache lines so producer and consumer don't
+        // invalidate each other on every operation
+        alignas(64) std::atomic<size_t> head{0}; // Next slot to write
+        alignas(64) std::atomic<size_t> tail{0}; // Next slot to read
+
+        static size_t round_up(size_t n) {
+            size_t p = 1;
+            while ( p < n )
+                p <<= 1;
+            return p;
+        }
+
+    public:
+        /// @brief Construct a queue holding at least @p capacity elements
+        /// @param capacity Rounded up to the next power of two
+        explicit SpscQueue(size_t capacity):
+            slots(new T[round_up(capacity)]),
+            mask(round_up(capacity) - 1) {}
+
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        /// @brief Number of elements the queue can hold
+        size_t capacity() const { return mask + 1; }
+
+        /// @brief Approximate number of queued elements
+        size_t size() const {
+            return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+        }
+
+        /// @brief Check if the queue is (approximately) empty
+        bool empty() const { return size() == 0; }
+
+        /// @brief Access slot @p i directly, e.g. to preallocate its contents
+        /// @warning Only valid before the queue is shared between threads
+        T& slot_at(size_t i) { return slots[i & mask]; }
+
+        // ====== Producer side ======
+        /// @brief Get the next free slot to fill in place
+        /// @return `nullptr` if the queue is full
+        T* write_slot() {
+            size_t h = head.load(std::memory_order_relaxed);
+            if ( h - tail.load(std::memory_order_acquire) > mask )
+                return nullptr;
+            return &slots[h & mask];
+        }
+
+        /// @brief Publish the slot returned by @b write_slot
+        void commit() {
+            head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        /// @brief Copy @p value into the queue
+        /// @return `false` if the queue is full
+        bool try_push(const T& value) {
+            T* slot = write_slot();
+            if ( !slot )
+                return false;
+            *slot = value;
+            commit();
+            return true;
+        }
+
+        // ====== Consumer side ======
+        /// @brief Get the oldest published slot to read in place
+        /// @return `nullptr` if the queue is empty
+        T* read_slot() {
+            size_t t = tail.load(std::memory_order_relaxed);
+            if ( t == head.load(std::memory_order_acquire) )
+                return nullptr;
+            return &slots[t & mask];
+        }
+
+        /// @brief Hand the slot returned by @b read_slot back to the producer
+        void release() {
+            tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        /// @brief Copy the oldest element out of the queue
+        /// @return `false` if the queue is empty
+        bool try_pop(T& value) {
+            T* slot = read_slot();
+            if ( !slot )
+                return false;
+            value = *slot;
+            release();
+            return true;
+        }
+};
+
+/**
+ * @class TripleBuffer
+ * @brief Hands the latest value from one thread to another without ever blocking
+ *
+ * The producer fills its back slot and publishes it by swapping it with
+ * the middle slot; the consumer picks up the middle slot by swapping it
+ * with its front slot. Neither side waits for the other, and the consumer
+ * always sees the most recent complete value (older ones are dropped),
+ * which suits meters and other state that is only ever read as "latest".
+ *
+ * @note Exactly one thread may produce and exactly one thread may consume
+ */
+template <typename T>
+class TripleBuffer {
+    private:
+        static constexpr uint8_t INDEX = 0x3;
+        static constexpr uint8_t FRESH = 0x4; // Middle slot holds an unread value
+
+        T slots[3];
+        alignas(64) std::atomic<uint8_t> middle{1};
+        alignas(64) uint8_t back  = 0; // Producer only
+        alignas(64) uint8_t front = 2; // Consumer only
+
+    public:
+        /// @brief Construct with every slot a copy of @p initial, e.g. presized vectors
+        explicit TripleBuffer(const T& initial=T()): slots{initial, initial, initial} {}
+
+        TripleBuffer(const TripleBuffer&) = delete;
+        TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+        // ====== Producer side ======
+        /// @brief Slot to fill with the next value
+        T& write_slot() { return slots[back]; }
+
+        /// @brief Publish the slot returned by @b write_slot
+        void publish() {
+            back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+        }
+
+        // ====== Consumer side ======
+        /// @brief Pick up the latest published value, if there is a new one
+        /// @return `false` if nothing was published since the last call
+        bool update() {
+            if ( !(middle.load(std::memory_order_relaxed) & FRESH) )
+                return false;
+            front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+            return true;
+        }
+
+        /// @brief Value picked up by the last @b update
+        const T& read_slot() const { return slots[front]; }
+};
+
+#endif // SIMPLY_LOCKFREE_HPP_
@@ -0,0 +1,361 @@
+#include "loudness.hpp"
+#include "biquad.hpp"
+#include "lockfree.hpp"
+#include "memory.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+static const double PI = 3.14159265358979323846;
+
+static const double   ABSOLUTE_GATE = -70.0; // LUFS, also the bottom of the histograms
+static const double   BIN_WIDTH     = 0.1;   // dB
+static const unsigned BINS          = 1000;  // -70 to +30 LUFS
+static const unsigned MOMENTARY     = 4;     // sub-blocks of 100 ms
+static const unsigned SHORT_TERM    = 30;
+
+static double loudness(double mean_square) {
+    if ( !(mean_square > 0.0) )
+        return -std::numeric_limits<double>::infinity();
+    return -0.691 + 10.0 * std::log10(mean_square);
+}
+
+// ---------------------------------------------------------------------
+// --- K-Weighting --- -------------------------------------------------
+// BS.1770 gives the coefficients at 48 kHz; these are the analog
+// prototypes behind them, so any sample rate gets the same response
+static BiquadCoeffs k_shelf(double sample_rate) {
+    const double f0 = 1681.974450955533;
+    const double g  = 3.999843853973347;
+    const double q  = 0.7071752369554196;
+    double k  = std::tan(PI * f0 / sample_rate);
+    double vh = std::pow(10.0, g / 20.0);
+    double vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    BiquadCoeffs c;
+    c.b0 = static_cast<float>((vh + vb * k / q + k * k) / a0);
+    c.b1 = static_cast<float>(2.0 * (k * k - vh) / a0);
+    c.b2 = static_cast<float>((vh - vb * k / q + k * k) / a0);
+    c.a1 = static_cast<float>(2.0 * (k * k - 1.0) / a0);
+    c.a2 = static_cast<float>((1.0 - k / q + k * k) / a0);
+    return c;
+}
+
+static BiquadCoeffs k_highpass(double sample_rate) {
+    const double f0 = 38.13547087602444;
+    const double q  = 0.5003270373238773;
+    double k  = std::tan(PI * f0 / sample_rate);
+    double a0 = 1.0 + k / q + k * k;
+    BiquadCoeffs c;
+    c.b0 = 1.0f;
+    c.b1 = -2.0f;
+    c.b2 = 1.0f;
+    c.a1 = static_cast<float>(2.0 * (k * k - 1.0) / a0);
+    c.a2 = static_cast<float>((1.0 - k / q + k * k) / a0);
+    return c;
+}
+
+// ---------------------------------------------------------------------
+// --- Gating Histogram --- --------------------------------------------
+// Counts blocks above the absolute gate in 0.1 dB bins, with the sum of
+// their mean squares per bin
+struct GateHistogram {
+    std::vector<uint64_t> count;
+    std::vector<double>   energy;
+
+    GateHistogram(): count(BINS), energy(BINS) {}
+
+    void clear() {
+        std::fill(count.begin(), count.end(), 0);
+        std::fill(energy.begin(), energy.end(), 0.0);
+    }
+
+    static size_t bin(double lufs) {
+        return std::min<size_t>(BINS - 1, static_cast<size_t>((lufs - ABSOLUTE_GATE) / BIN_WIDTH));
+    }
+
+    void add(double mean_square) {
+        double l = loudness(mean_square);
+        if ( l < ABSOLUTE_GATE )
+            return;
+        count[bin(l)]++;
+        energy[bin(l)] += mean_square;
+    }
+
+    // First bin passing the gate @p relative LU below the mean of all blocks,
+    // or BINS if there are no blocks
+    size_t relative_gate(double relative) const {
+        uint64_t n = 0;
+        double   e = 0.0;
+        for ( size_t b = 0; b < BINS; b++ ) {
+            n += count[b];
+            e += energy[b];
+        }
+        if ( !n )
+            return BINS;
+        double threshold = loudness(e / n) + relative;
+        return threshold < ABSOLUTE_GATE ? 0 : bin(threshold);
+    }
+};
+
+// ====== LoudnessMeter Implementation ======
+struct LoudnessMeter::Impl {
+    unsigned                      nchannels;
+    Options                       opts;
+    BiquadCascade                 filter;
+    std::vector<double>           weights;
+    AlignedBuffer<float>          scratch;   // planar, max_block per channel
+    std::vector<float*>           planes;
+    std::vector<const float*>     sources;
+
+    size_t                        sub_frames;    // frames per 100 ms sub-block
+    size_t                        sub_pos = 0;   // frames into the current sub-block
+    std::vector<double>           sums;          // per channel, of the current sub-block
+    double                        ring[SHORT_TERM]; // mean squares of the last sub-blocks
+    uint64_t                      subblocks = 0;
+    double                        momentary_ms  = 0.0;
+    double                        short_term_ms = 0.0;
+    uint64_t                      frames = 0;
+
+    GateHistogram                 integrated_hist;
+    GateHistogram                 range_hist;
+
+    TripleBuffer<LoudnessReading> readings;
+
+    static BiquadCascade::Options filter_options(const Options& options) {
+        BiquadCascade::Options o;
+        o.ramp_frames = 0;
+        o.max_block   = std::max<size_t>(options.max_block, 1);
+        return o;
+    }
+
+    Impl(unsigned channels, uint32_t sample_rate, const Options& options):
+        nchannels(channels), opts(options),
+        filter(channels ? channels : 1, 2, filter_options(options)) {
+        if ( !channels )
+            throw LoudnessUserError("A loudness meter needs at least one channel!");
+        if ( sample_rate < 8000 )
+            throw LoudnessUserError("Sample rate must be at least 8000 Hz!");
+        opts.max_block = std::max<size_t>(opts.max_block, 1);
+
+        filter.set(0, k_shelf(sample_rate), false);
+        filter.set(1, k_highpass(sample_rate), false);
+
+        // 5 channels are 5.0 (L R C Ls Rs), 6 or more start as 5.1 (L R C LFE Ls Rs)
+        weights.assign(nchannels, 1.0);
+        if ( nchannels == 5 ) {
+            weights[3] = 1.41;
+            weights[4] = 1.41;
+        } else if ( nchannels >= 6 ) {
+            weights[3] = 0.0;
+            weights[4] = 1.41;
+            weights[5] = 1.41;
+        }
+
+        size_t stride = (opts.max_block + 15) & ~static_cast<size_t>(15);
+        scratch.allocate(stride * nchannels);
+        for ( unsigned ch = 0; ch < nchannels; ch++ )
+            planes.push_back(scratch.data() + ch * stride);
+        sources.resize(nchannels);
+
+        sub_frames = (sample_rate + 5) / 10;
+        sums.resize(nchannels);
+        reset();
+    }
+
+    void reset() {
+        filter.reset();
+        std::fill(sums.begin(), sums.end(), 0.0);
+        std::fill(ring, ring + SHORT_TERM, 0.0);
+        sub_pos       = 0;
+        subblocks     = 0;
+        momentary_ms  = 0.0;
+        short_term_ms = 0.0;
+        frames        = 0;
+        integrated_hist.clear();
+        range_hist.clear();
+    }
+
+    double momentary() const {
+        return subblocks < MOMENTARY ? -std::numeric_limits<double>::infinity() : loudness(momentary_ms);
+    }
+
+    double short_term() const {
+        return subblocks < SHORT_TERM ? -std::numeric_limits<double>::infinity() : loudness(short_term_ms);
+    }
+
+    double integrated() const {
+        size_t   gate = integrated_hist.relative_gate(-10.0);
+        uint64_t n    = 0;
+        double   e    = 0.0;
+        for ( size_t b = gate; b < BINS; b++ ) {
+            n += integrated_hist.count[b];
+            e += integrated_hist.energy[b];
+        }
+        return n ? loudness(e / n) : -std::numeric_limits<double>::infinity();
+    }
+
+    double range() const {
+        size_t   gate = range_hist.relative_gate(-20.0);
+        uint64_t n    = 0;
+        for ( size_t b = gate; b < BINS; b++ )
+            n += range_hist.count[b];
+        if ( !n )
+            return -std::numeric_limits<double>::infinity();
+
+        // Bins holding the 10th and 95th percentile blocks
+        uint64_t low_rank  = static_cast<uint64_t>(0.10 * (n - 1));
+        uint64_t high_rank = static_cast<uint64_t>(0.95 * (n - 1));
+        size_t   low = BINS, high = BINS;
+        uint64_t seen = 0;
+        for ( size_t b = gate; b < BINS && high == BINS; b++ ) {
+            seen += range_hist.count[b];
+            if ( low == BINS && seen > low_rank )
+                low = b;
+            if ( seen > high_rank )
+                high = b;
+        }
+        return (high - low) * BIN_WIDTH;
+    }
+
+    void finish_subblock() {
+        double ms = 0.0;
+        for ( unsigned ch = 0; ch < nchannels; ch++ ) {
+            ms      += weights[ch] * sums[ch];
+            sums[ch] = 0.0;
+        }
+        ring[subblocks % SHORT_TERM] = ms / sub_frames;
+        subblocks++;
+        sub_pos = 0;
+
+        // Windows are short enough to re-sum rather than keep running totals
+        // that would drift
+        momentary_ms = 0.0;
+        for ( unsigned i = 1; i <= MOMENTARY; i++ )
+            momentary_ms += ring[(subblocks - i) % SHORT_TERM];
+        momentary_ms /= MOMENTARY;
+        short_term_ms = 0.0;
+        for ( unsigned i = 0; i < SHORT_TERM; i++ )
+            short_term_ms += ring[i];
+        short_term_ms /= SHORT_TERM;
+
+        if ( subblocks >= MOMENTARY )
+            integrated_hist.add(momentary_ms);
+        if ( subblocks >= SHORT_TERM )
+            range_hist.add(short_term_ms);
+
+        LoudnessReading& r = readings.write_slot();
+        r.momentary  = momentary();
+        r.short_term = short_term();
+        r.integrated = integrated();
+        r.range      = range();
+        r.frames     = frames;
+        readings.publish();
+    }
+
+    // Sum the squares of the K-weighted frames in planes, splitting at sub-blocks
+    void accumulate(size_t n) {
+        size_t done = 0;
+        while ( done < n ) {
+            size_t m = std::min(n - done, sub_frames - sub_pos);
+            for ( unsigned ch = 0; ch < nchannels; ch++ ) {
+                if ( weights[ch] == 0.0 )
+                    continue;
+                const float* x = planes[ch] + done;
+                sums[ch] += simd_dot(x, x, m);
+            }
+            sub_pos += m;
+            frames  += m;
+            done    += m;
+            if ( sub_pos == sub_frames )
+                finish_subblock();
+        }
+    }
+
+    void process(const float* in, size_t n_frames) {
+        while ( n_frames ) {
+            size_t n = std::min(n_frames, opts.max_block);
+            for ( unsigned ch = 0; ch < nchannels; ch++ ) {
+                float* dst = planes[ch];
+                for ( size_t i = 0; i < n; i++ )
+                    dst[i] = in[i * nchannels + ch];
+            }
+            filter.process(planes.data(), planes.data(), n);
+            accumulate(n);
+            in       += n * nchannels;
+            n_frames -= n;
+        }
+    }
+
+    void process(const float* const* in, size_t n_frames) {
+        size_t done = 0;
+        while ( done < n_frames ) {
+            size_t n = std::min(n_frames - done, opts.max_block);
+            for ( unsigned ch = 0; ch < nchannels; ch++ )
+                sources[ch] = in[ch] + done;
+            filter.process(sources.data(), planes.data(), n);
+            accumulate(n);
+            done += n;
+        }
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- LoudnessMeter Class Methods --- ---------------------------------
+LoudnessMeter::LoudnessMeter(unsigned channels, uint32_t sample_rate):
+    LoudnessMeter(channels, sample_rate, Options()) {}
+
+LoudnessMeter::LoudnessMeter(unsigned channels, uint32_t sample_rate, const Options& options):
+    pimpl(new Impl(channels, sample_rate, options)) {}
+
+LoudnessMeter::~LoudnessMeter() = default;
+
+unsigned LoudnessMeter::channels() const {
+    return pimpl->nchannels;
+}
+
+void LoudnessMeter::set_weight(unsigned channel, double weight) {
+    if ( channel >= pimpl->nchannels )
+        throw LoudnessUserError("Channel " + std::to_string(channel) + " doesn't exist!");
+    if ( !(weight >= 0.0) )
+        throw LoudnessUserError("Channel weights can't be negative!");
+    pimpl->weights[channel] = weight;
+}
+
+void LoudnessMeter::process(const float* in, size_t frames) {
+    pimpl->process(in, frames);
+}
+
+void LoudnessMeter::process(const float* const* in, size_t frames) {
+    pimpl->process(in, frames);
+}
+
+double LoudnessMeter::momentary() const {
+    return pimpl->momentary();
+}
+
+double LoudnessMeter::short_term() const {
+    return pimpl->short_term();
+}
+
+double LoudnessMeter::integrated() const {
+    return pimpl->integrated();
+}
+
+double LoudnessMeter::range() const {
+    return pimpl->range();
+}
+
+bool LoudnessMeter::read(LoudnessReading& reading) {
+    if ( !pimpl->readings.update() )
+        return false;
+    reading = pimpl->readings.read_slot();
+    return true;
+}
+
+void LoudnessMeter::reset() {
+    pimpl->reset();
+}
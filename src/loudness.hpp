@@ -0,0 +1,145 @@
+/**
+ * @file loudness.hpp
+ * @brief Provides @b LoudnessMeter, streaming EBU R128 / ITU-R BS.1770 loudness
+ */
+#ifndef SIMPLY_LOUDNESS_HPP_
+#define SIMPLY_LOUDNESS_HPP_
+
+#include <string>
+#include <exception>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class LoudnessException
+ * @brief This is the base class of all exceptions thrown by @b LoudnessMeter
+ */
+class LoudnessException: public std::exception {
+    protected:
+        std::string msg;
+        explicit LoudnessException(const std::string& msg): msg(msg) {}
+
+    public:
+        /// @brief Get a message describing the error
+        /// @return NULL-terminated c-string
+        const char* what() const noexcept override { return msg.c_str(); }
+};
+
+/**
+ * @class LoudnessUserError
+ * @brief This means a channel count, sample rate or channel weight was invalid
+ */
+class LoudnessUserError: public LoudnessException {
+    public:
+        explicit LoudnessUserError(const std::string& msg): LoudnessException("LoudnessUserError: " + msg) {}
+};
+
+/**
+ * @struct LoudnessReading
+ * @brief Loudness in LUFS and loudness range in LU
+ *
+ * Values that can't be measured yet (e.g. before 400 ms of audio, or if
+ * everything so far was gated out) are minus infinity.
+ */
+struct LoudnessReading {
+    /// 400 ms window
+    double   momentary    = 0.0;
+    /// 3 s window
+    double   short_term   = 0.0;
+    /// Gated over everything since the start (or @b LoudnessMeter::reset)
+    double   integrated   = 0.0;
+    /// Spread of the gated short-term loudness, 10th to 95th percentile
+    double   range        = 0.0;
+    /// Frames measured since the start
+    uint64_t frames       = 0;
+};
+
+/**
+ * @class LoudnessMeter
+ * @brief Measures momentary, short-term and integrated loudness and loudness range
+ *
+ * The input is K-weighted by a two-stage @b BiquadCascade across all
+ * channels, and its mean square is summed into 100 ms sub-blocks, from
+ * which the 400 ms (momentary) and 3 s (short-term) windows are formed
+ * every 100 ms.
+ *
+ * Integrated loudness and loudness range are gated (absolute at -70 LUFS,
+ * then relative at -10 LU and -20 LU). Instead of keeping every block,
+ * blocks are counted in histograms of 0.1 dB bins that also sum each
+ * bin's energy, so memory is fixed however long the programme runs and
+ * the gated means stay exact; only the gate thresholds and range
+ * percentiles are resolved to a bin.
+ *
+ * For live use, a @b LoudnessReading is published every 100 ms and can be
+ * taken by another thread with @b read; for file QC the getters give the
+ * current values directly.
+ *
+ * @note @b process, @b reset and the getters belong to one thread; @b read may be called by (one) other thread
+ */
+class LoudnessMeter {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /**
+         * @struct Options
+         * @brief Buffering
+         */
+        struct Options {
+            /// Frames filtered at a time
+            size_t max_block = 1024;
+        };
+
+        /// @brief Meter for @p channels channels at @p sample_rate
+        ///
+        /// Channel weights follow BS.1770: 1.0, except for the surrounds
+        /// (1.41). With 5 channels, the 4th and 5th are the surrounds, as in
+        /// the L R C Ls Rs order. With 6 or more, the 4th is taken to be the
+        /// LFE (ignored) and the 5th and 6th the surrounds, as in L R C LFE Ls Rs
+        /// @throws LoudnessUserError if @p channels is 0 or @p sample_rate is too low
+        LoudnessMeter(unsigned channels, uint32_t sample_rate);
+
+        /// @brief Create with @p options
+        LoudnessMeter(unsigned channels, uint32_t sample_rate, const Options& options);
+
+        ~LoudnessMeter();
+
+        LoudnessMeter(const LoudnessMeter&) = delete;
+        LoudnessMeter& operator=(const LoudnessMeter&) = delete;
+
+        /// @brief Number of channels
+        unsigned channels() const;
+
+        /// @brief Change the weight of @p channel, 0 to ignore it
+        /// @throws LoudnessUserError if @p channel is out of range or @p weight negative
+        void set_weight(unsigned channel, double weight);
+
+        /// @brief Measure @p frames interleaved frames
+        void process(const float* in, size_t frames);
+
+        /// @brief Measure @p frames frames of planar channels
+        void process(const float* const* in, size_t frames);
+
+        /// @brief Momentary loudness (400 ms) as of the last full 100 ms, in LUFS
+        double momentary() const;
+
+        /// @brief Short-term loudness (3 s) as of the last full 100 ms, in LUFS
+        double short_term() const;
+
+        /// @brief Gated integrated loudness, in LUFS
+        double integrated() const;
+
+        /// @brief Loudness range (EBU Tech 3342), in LU
+        double range() const;
+
+        /// @brief Copy the latest published reading into @p reading, from the monitoring thread
+        /// @return `false` if nothing was published since the last call (@p reading is left as is)
+        bool read(LoudnessReading& reading);
+
+        /// @brief Start measuring from scratch
+        void reset();
+};
+
+#endif // SIMPLY_LOUDNESS_HPP_
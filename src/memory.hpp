@@ -0,0 +1,97 @@
+/**
+ * @file memory.hpp
+ * @brief Provides @b AlignedBuffer for SIMD- and IO-friendly allocations
+ */
+#ifndef SIMPLY_MEMORY_HPP_
+#define SIMPLY_MEMORY_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <utility>
+
+/**
+ * @class AlignedBuffer
+ * @brief Owning, zero-initialized array whose first element is aligned
+ *
+ * Used wherever the alignment matters, such as buffers handed to
+ * unbuffered file IO or loaded with aligned vector instructions.
+ * Only intended for trivially copyable @p T (samples, coefficients, bytes).
+ */
+template <typename T>
+class AlignedBuffer {
+    private:
+        unsigned char* raw   = nullptr;
+        T*             ptr   = nullptr;
+        size_t         count = 0;
+
+        void clear() {
+            delete[] raw;
+            raw   = nullptr;
+            ptr   = nullptr;
+            count = 0;
+        }
+
+    public:
+        AlignedBuffer() = default;
+
+        /// @brief Allocate @p n zeroed elements aligned to @p alignment bytes
+        /// @param alignment Must be a power of two
+        explicit AlignedBuffer(size_t n, size_t alignment=64) {
+            allocate(n, alignment);
+        }
+
+        ~AlignedBuffer() {
+            clear();
+        }
+
+        AlignedBuffer(const AlignedBuffer&) = delete;
+        AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+        AlignedBuffer(AlignedBuffer&& o) {
+            std::swap(raw, o.raw);
+            std::swap(ptr, o.ptr);
+            std::swap(count, o.count);
+        }
+
+        AlignedBuffer& operator=(AlignedBuffer&& o) {
+            if ( this != &o ) {
+                clear();
+                std::swap(raw, o.raw);
+                std::swap(ptr, o.ptr);
+                std::swap(count, o.count);
+            }
+            return *this;
+        }
+
+        /// @brief Replace the contents with @p n zeroed elements
+        void allocate(size_t n, size_t alignment=64) {
+            clear();
+            if ( n == 0 )
+                return;
+            raw = new unsigned char[n * sizeof(T) + alignment];
+            uintptr_t addr = reinterpret_cast<uintptr_t>(raw);
+            addr = (addr + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+            ptr   = reinterpret_cast<T*>(addr);
+            count = n;
+            std::memset(ptr, 0, n * sizeof(T));
+        }
+
+        /// @brief Set every element to zero
+        void zero() {
+            if ( ptr )
+                std::memset(ptr, 0, count * sizeof(T));
+        }
+
+        T*       data()       { return ptr; }
+        const T* data() const { return ptr; }
+        size_t   size() const { return count; }
+
+        T&       operator[](size_t i)       { return ptr[i]; }
+        const T& operator[](size_t i) const { return ptr[i]; }
+
+        explicit operator bool() const { return ptr != nullptr; }
+};
+
+#endif // SIMPLY_MEMORY_HPP_
@@ -0,0 +1,234 @@
+#include "meter.hpp"
+#include "lockfree.hpp"
+#include "memory.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static const double PI = 3.14159265358979323846;
+
+static const unsigned PHASES = 4;
+static const unsigned TAPS   = 12; // per phase
+static const unsigned HIST   = TAPS - 1;
+
+// Zeroth-order modified Bessel function of the first kind
+static double bessel_i0(double x) {
+    double sum  = 1.0;
+    double term = 1.0;
+    for ( int k = 1; k < 64; k++ ) {
+        double f = x / (2.0 * k);
+        term *= f * f;
+        sum  += term;
+        if ( term < sum * 1e-17 )
+            break;
+    }
+    return sum;
+}
+
+// ====== Meter Implementation ======
+struct Meter::Impl {
+    // Window accumulators of one channel
+    struct Accum {
+        float4 peak;
+        float4 true_peak;
+        double squares; // summed per block in double, so long windows stay exact
+    };
+
+    unsigned                   nchannels;
+    Options                    opts;
+    size_t                     stride;      // floats per channel in work: history + block
+    AlignedBuffer<float>       work;        // per channel, [HIST history | block]
+    AlignedBuffer<float>       coefs;       // PHASES x TAPS, time-reversed
+    std::vector<Accum>         accum;
+    size_t                     window = 0;  // frames in the current window
+    uint64_t                   sequence = 0;
+    TripleBuffer<MeterReading> readings;
+
+    static MeterReading blank(unsigned channels) {
+        MeterReading r;
+        r.channels.resize(channels);
+        return r;
+    }
+
+    Impl(unsigned channels, const Options& options):
+        nchannels(channels), opts(options), readings(blank(channels)) {
+        if ( !channels )
+            throw MeterUserError("A meter needs at least one channel!");
+        if ( !opts.max_block )
+            opts.max_block = 1;
+        stride = (HIST + opts.max_block + 3 + 15) & ~static_cast<size_t>(15);
+        work.allocate(stride * nchannels);
+        accum.resize(nchannels);
+        design();
+        reset();
+    }
+
+    // Kaiser-windowed sinc interpolating by PHASES; within 0.15 dB of
+    // flat up to 0.4 of the sample rate
+    void design() {
+        const unsigned length = PHASES * TAPS;
+        const double   cutoff = 1.0;
+        const double   beta   = 4.0;
+        const double   centre = (length - 1) / 2.0;
+        coefs.allocate(length);
+        for ( unsigned p = 0; p < PHASES; p++ ) {
+            double sum = 0.0;
+            double h[TAPS];
+            for ( unsigned k = 0; k < TAPS; k++ ) {
+                double t    = (k * PHASES + p - centre) / PHASES;
+                double x    = cutoff * t;
+                double sinc = x == 0.0 ? 1.0 : std::sin(PI * x) / (PI * x);
+                double r    = (k * PHASES + p - centre) / (centre + 1.0);
+                h[k] = cutoff * sinc * bessel_i0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / bessel_i0(beta);
+                sum += h[k];
+            }
+            // Unity gain at DC in every phase; taps reversed to run forward over the history
+            for ( unsigned k = 0; k < TAPS; k++ )
+                coefs[p * TAPS + k] = static_cast<float>(h[TAPS - 1 - k] / sum);
+        }
+    }
+
+    void reset() {
+        work.zero();
+        clear_window();
+    }
+
+    void clear_window() {
+        for ( Accum& a : accum ) {
+            a.peak      = float4::zero();
+            a.true_peak = float4::zero();
+            a.squares   = 0.0;
+        }
+        window = 0;
+    }
+
+    // Measure the samples at buf[HIST .. HIST+frames), buf[0 .. HIST) being the history
+    void measure(float* buf, size_t frames, Accum& a) {
+        // Pad to whole vectors; zeros don't change the peak or RMS, and the
+        // interpolator outputs of padded lanes are masked off below
+        std::fill(buf + HIST + frames, buf + HIST + ((frames + 3) & ~static_cast<size_t>(3)), 0.0f);
+        static const float lanes[8] = {1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+        float4 h[TAPS][PHASES];
+        for ( unsigned k = 0; k < TAPS; k++ )
+            for ( unsigned p = 0; p < PHASES; p++ )
+                h[k][p] = float4::broadcast(coefs[p * TAPS + k]);
+
+        float4 peak = a.peak, tp = a.true_peak, sq = float4::zero();
+        for ( size_t n = 0; n < frames; n += 4 ) {
+            float4 x = float4::load(buf + HIST + n);
+            peak = float4::max(peak, x.abs());
+            sq   = float4::mul_add(x, x, sq);
+
+            // Output phase p of input frames n..n+3, one frame per lane;
+            // even and odd taps of each phase are separate chains so the
+            // additions overlap
+            float4 e0 = float4::zero(), e1 = e0, e2 = e0, e3 = e0;
+            float4 o0 = e0, o1 = e0, o2 = e0, o3 = e0;
+            for ( unsigned k = 0; k < TAPS; k += 2 ) {
+                float4 xe = float4::load(buf + n + k);
+                float4 xo = float4::load(buf + n + k + 1);
+                e0 = float4::mul_add(h[k][0], xe, e0);
+                e1 = float4::mul_add(h[k][1], xe, e1);
+                e2 = float4::mul_add(h[k][2], xe, e2);
+                e3 = float4::mul_add(h[k][3], xe, e3);
+                o0 = float4::mul_add(h[k + 1][0], xo, o0);
+                o1 = float4::mul_add(h[k + 1][1], xo, o1);
+                o2 = float4::mul_add(h[k + 1][2], xo, o2);
+                o3 = float4::mul_add(h[k + 1][3], xo, o3);
+            }
+            float4 y = float4::max(float4::max((e0 + o0).abs(), (e1 + o1).abs()),
+                                   float4::max((e2 + o2).abs(), (e3 + o3).abs()));
+            if ( n + 4 > frames )
+                y *= float4::load(lanes + 4 - (frames - n));
+            tp = float4::max(tp, y);
+        }
+        a.peak      = peak;
+        a.true_peak = tp;
+        a.squares  += sq.sum();
+
+        // Keep the last HIST samples as history for the next block
+        std::copy(buf + frames, buf + frames + HIST, buf);
+    }
+
+    void finish_block(size_t frames) {
+        window += frames;
+        if ( window < opts.window_frames )
+            return;
+
+        MeterReading& r = readings.write_slot();
+        for ( unsigned ch = 0; ch < nchannels; ch++ ) {
+            const Accum& a = accum[ch];
+            MeterLevels& l = r.channels[ch];
+            l.peak      = a.peak.max_lane();
+            l.rms       = static_cast<float>(std::sqrt(a.squares / window));
+            l.true_peak = std::max(l.peak, a.true_peak.max_lane());
+        }
+        r.frames   = window;
+        r.sequence = ++sequence;
+        readings.publish();
+        clear_window();
+    }
+
+    void process(const float* in, size_t frames) {
+        while ( frames ) {
+            size_t n = std::min(frames, opts.max_block);
+            for ( unsigned ch = 0; ch < nchannels; ch++ ) {
+                float*       buf = work.data() + ch * stride;
+                const float* src = in + ch;
+                for ( size_t i = 0; i < n; i++ )
+                    buf[HIST + i] = src[i * nchannels];
+                measure(buf, n, accum[ch]);
+            }
+            finish_block(n);
+            in     += n * nchannels;
+            frames -= n;
+        }
+    }
+
+    void process(const float* const* in, size_t frames) {
+        size_t done = 0;
+        while ( done < frames ) {
+            size_t n = std::min(frames - done, opts.max_block);
+            for ( unsigned ch = 0; ch < nchannels; ch++ ) {
+                float* buf = work.data() + ch * stride;
+                std::copy(in[ch] + done, in[ch] + done + n, buf + HIST);
+                measure(buf, n, accum[ch]);
+            }
+            finish_block(n);
+            done += n;
+        }
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- Meter Class Methods --- -----------------------------------------
+Meter::Meter(unsigned channels): Meter(channels, Options()) {}
+
+Meter::Meter(unsigned channels, const Options& options): pimpl(new Impl(channels, options)) {}
+
+Meter::~Meter() = default;
+
+unsigned Meter::channels() const {
+    return pimpl->nchannels;
+}
+
+void Meter::process(const float* in, size_t frames) {
+    pimpl->process(in, frames);
+}
+
+void Meter::process(const float* const* in, size_t frames) {
+    pimpl->process(in, frames);
+}
+
+bool Meter::read(MeterReading& reading) {
+    if ( !pimpl->readings.update() )
+        return false;
+    reading = pimpl->readings.read_slot();
+    return true;
+}
+
+void Meter::reset() {
+    pimpl->reset();
+}
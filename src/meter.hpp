@@ -0,0 +1,122 @@
+/**
+ * @file meter.hpp
+ * @brief Provides @b Meter, peak/RMS/true-peak metering published to other threads
+ */
+#ifndef SIMPLY_METER_HPP_
+#define SIMPLY_METER_HPP_
+
+#include <string>
+#include <exception>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class MeterException
+ * @brief This is the base class of all exceptions thrown by @b Meter
+ */
+class MeterException: public std::exception {
+    protected:
+        std::string msg;
+        explicit MeterException(const std::string& msg): msg(msg) {}
+
+    public:
+        /// @brief Get a message describing the error
+        /// @return NULL-terminated c-string
+        const char* what() const noexcept override { return msg.c_str(); }
+};
+
+/**
+ * @class MeterUserError
+ * @brief This means the meter was created without channels
+ */
+class MeterUserError: public MeterException {
+    public:
+        explicit MeterUserError(const std::string& msg): MeterException("MeterUserError: " + msg) {}
+};
+
+/**
+ * @struct MeterLevels
+ * @brief Linear levels of one channel over one window, 1.0 being full scale
+ */
+struct MeterLevels {
+    float peak      = 0.0f;
+    float rms       = 0.0f;
+    /// Peak of the signal oversampled 4x, which catches inter-sample peaks
+    float true_peak = 0.0f;
+};
+
+/**
+ * @struct MeterReading
+ * @brief Levels of every channel over one window
+ */
+struct MeterReading {
+    std::vector<MeterLevels> channels;
+    /// Frames the window covered
+    size_t                   frames   = 0;
+    /// Counts the windows published, starting at 1
+    uint64_t                 sequence = 0;
+};
+
+/**
+ * @class Meter
+ * @brief Measures peak, RMS and true peak of a stream in one SIMD pass
+ *
+ * Each block is read once: the same loads feed the peak, the sum of
+ * squares and a 4-phase polyphase interpolator (12 taps per phase), whose
+ * outputs give the true peak in the manner of ITU-R BS.1770.
+ *
+ * After every @b Options::window_frames frames (rounded up to whole blocks)
+ * a @b MeterReading is published through a @b TripleBuffer, so a monitoring
+ * thread can @b read the latest levels while the audio thread never waits.
+ *
+ * @note @b process belongs to one thread and @b read to (one) other thread
+ */
+class Meter {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /**
+         * @struct Options
+         * @brief Publishing and buffering
+         */
+        struct Options {
+            /// Frames measured per published reading
+            size_t window_frames = 4800;
+            /// Frames of interleaved input de-interleaved at a time
+            size_t max_block     = 1024;
+        };
+
+        /// @brief Meter for @p channels channels
+        /// @throws MeterUserError if @p channels is 0
+        explicit Meter(unsigned channels);
+
+        /// @brief Create with @p options
+        Meter(unsigned channels, const Options& options);
+
+        ~Meter();
+
+        Meter(const Meter&) = delete;
+        Meter& operator=(const Meter&) = delete;
+
+        /// @brief Number of channels
+        unsigned channels() const;
+
+        /// @brief Measure @p frames interleaved frames
+        void process(const float* in, size_t frames);
+
+        /// @brief Measure @p frames frames of planar channels
+        void process(const float* const* in, size_t frames);
+
+        /// @brief Copy the latest reading into @p reading, from the monitoring thread
+        /// @return `false` if nothing was published since the last call (@p reading is left as is)
+        bool read(MeterReading& reading);
+
+        /// @brief Forget the current window and the interpolator history
+        void reset();
+};
+
+#endif // SIMPLY_METER_HPP_
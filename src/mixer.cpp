@@ -0,0 +1,176 @@
+#include "mixer.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------
+// --- Mixing Kernel --- -----------------------------------------------
+// An input feeding the bus being built: gain at sample 0 and per sample
+struct MixTerm {
+    const float* x;
+    float        g;
+    float        step;
+};
+
+// Gains of lanes 0..3 of the first vector
+static float4 first_gains(const MixTerm& t, bool ramp) {
+    return ramp ? float4::set(t.g, t.g + t.step, t.g + 2 * t.step, t.g + 3 * t.step) : float4::broadcast(t.g);
+}
+
+// out (=, or += unless first) sum of K terms, in one pass over the block;
+// terms are named rather than looped over so gains stay in registers
+template <unsigned K, bool RAMP>
+static void mix_pass(const MixTerm* t, float* out, size_t frames, bool first) {
+    const float* x0 = t[0].x;
+    const float* x1 = t[K > 1 ? 1 : 0].x;
+    const float* x2 = t[K > 2 ? 2 : 0].x;
+    const float* x3 = t[K > 3 ? 3 : 0].x;
+    float4 g0 = first_gains(t[0], RAMP), d0 = float4::broadcast(4 * t[0].step);
+    float4 g1 = first_gains(t[K > 1 ? 1 : 0], RAMP), d1 = float4::broadcast(4 * t[K > 1 ? 1 : 0].step);
+    float4 g2 = first_gains(t[K > 2 ? 2 : 0], RAMP), d2 = float4::broadcast(4 * t[K > 2 ? 2 : 0].step);
+    float4 g3 = first_gains(t[K > 3 ? 3 : 0], RAMP), d3 = float4::broadcast(4 * t[K > 3 ? 3 : 0].step);
+
+    size_t i = 0;
+    for ( ; i + 4 <= frames; i += 4 ) {
+        float4 acc = first ? float4::zero() : float4::load(out + i);
+        acc = float4::fused_mul_add(float4::load(x0 + i), g0, acc);
+        if ( K > 1 )
+            acc = float4::fused_mul_add(float4::load(x1 + i), g1, acc);
+        if ( K > 2 )
+            acc = float4::fused_mul_add(float4::load(x2 + i), g2, acc);
+        if ( K > 3 )
+            acc = float4::fused_mul_add(float4::load(x3 + i), g3, acc);
+        acc.store(out + i);
+        if ( RAMP ) {
+            g0 += d0;
+            g1 += d1;
+            g2 += d2;
+            g3 += d3;
+        }
+    }
+    for ( ; i < frames; i++ ) {
+        float acc = first ? 0.0f : out[i];
+        for ( unsigned k = 0; k < K; k++ )
+            acc += t[k].x[i] * (t[k].g + t[k].step * i);
+        out[i] = acc;
+    }
+}
+
+template <bool RAMP>
+static void mix_pass(const MixTerm* t, size_t n, float* out, size_t frames, bool first) {
+    switch ( n ) {
+        case 1:  mix_pass<1, RAMP>(t, out, frames, first); break;
+        case 2:  mix_pass<2, RAMP>(t, out, frames, first); break;
+        case 3:  mix_pass<3, RAMP>(t, out, frames, first); break;
+        default: mix_pass<4, RAMP>(t, out, frames, first); break;
+    }
+}
+
+// ====== Mixer Implementation ======
+struct Mixer::Impl {
+    unsigned                                n_in;
+    unsigned                                n_bus;
+    std::unique_ptr<std::atomic<float>[]>   targets;  // [bus * n_in + input]
+    std::unique_ptr<std::atomic<bool>[]>    mutes;
+    std::vector<float>                      current;  // gains reached by the last block
+    std::vector<MixTerm>                    terms;    // scratch, one bus at a time
+
+    Impl(unsigned inputs, unsigned buses): n_in(inputs), n_bus(buses) {
+        if ( !inputs || !buses )
+            throw MixerUserError("A mixer needs at least one input and one bus!");
+        size_t n = static_cast<size_t>(inputs) * buses;
+        targets.reset(new std::atomic<float>[n]);
+        mutes.reset(new std::atomic<bool>[inputs]);
+        for ( size_t i = 0; i < n; i++ )
+            targets[i].store(0.0f, std::memory_order_relaxed);
+        for ( unsigned i = 0; i < inputs; i++ )
+            mutes[i].store(false, std::memory_order_relaxed);
+        current.assign(n, 0.0f);
+        terms.reserve(inputs);
+    }
+
+    size_t index(unsigned input, unsigned bus) const {
+        if ( input >= n_in )
+            throw MixerUserError("Input " + std::to_string(input) + " doesn't exist!");
+        if ( bus >= n_bus )
+            throw MixerUserError("Bus " + std::to_string(bus) + " doesn't exist!");
+        return static_cast<size_t>(bus) * n_in + input;
+    }
+
+    void process(const float* const* in, float* const* out, size_t frames) {
+        if ( !frames )
+            return;
+        const float inv = 1.0f / static_cast<float>(frames);
+
+        for ( unsigned b = 0; b < n_bus; b++ ) {
+            // Gather the terms of this bus, ramps first so they share passes
+            terms.clear();
+            size_t ramps = 0;
+            for ( unsigned k = 0; k < n_in; k++ ) {
+                size_t idx    = static_cast<size_t>(b) * n_in + k;
+                float  target = mutes[k].load(std::memory_order_relaxed) ? 0.0f
+                                                                         : targets[idx].load(std::memory_order_relaxed);
+                float  from   = current[idx];
+                current[idx]  = target;
+                if ( !in[k] || (from == 0.0f && target == 0.0f) )
+                    continue;
+
+                // Reaches the target on the last sample
+                float step = (target - from) * inv;
+                terms.push_back(MixTerm{in[k], from + step, step});
+                if ( step != 0.0f )
+                    std::swap(terms[ramps++], terms.back());
+            }
+
+            float* dst = out[b];
+            if ( terms.empty() ) {
+                std::fill(dst, dst + frames, 0.0f);
+                continue;
+            }
+            for ( size_t t = 0; t < terms.size(); t += 4 ) {
+                size_t n = std::min<size_t>(4, terms.size() - t);
+                if ( t < ramps )
+                    mix_pass<true>(&terms[t], n, dst, frames, t == 0);
+                else
+                    mix_pass<false>(&terms[t], n, dst, frames, t == 0);
+            }
+        }
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- Mixer Class Methods --- -----------------------------------------
+Mixer::Mixer(unsigned inputs, unsigned buses): pimpl(new Impl(inputs, buses)) {}
+
+Mixer::~Mixer() = default;
+
+unsigned Mixer::inputs() const {
+    return pimpl->n_in;
+}
+
+unsigned Mixer::buses() const {
+    return pimpl->n_bus;
+}
+
+void Mixer::set_gain(unsigned input, unsigned bus, float gain) {
+    pimpl->targets[pimpl->index(input, bus)].store(gain, std::memory_order_relaxed);
+}
+
+float Mixer::gain(unsigned input, unsigned bus) const {
+    return pimpl->targets[pimpl->index(input, bus)].load(std::memory_order_relaxed);
+}
+
+void Mixer::set_muted(unsigned input, bool muted) {
+    pimpl->mutes[pimpl->index(input, 0)].store(muted, std::memory_order_relaxed);
+}
+
+bool Mixer::muted(unsigned input) const {
+    return pimpl->mutes[pimpl->index(input, 0)].load(std::memory_order_relaxed);
+}
+
+void Mixer::process(const float* const* in, float* const* out, size_t frames) {
+    pimpl->process(in, out, frames);
+}
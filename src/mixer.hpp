@@ -0,0 +1,94 @@
+/**
+ * @file mixer.hpp
+ * @brief Provides @b Mixer, summing inputs into buses with ramped gains
+ */
+#ifndef SIMPLY_MIXER_HPP_
+#define SIMPLY_MIXER_HPP_
+
+#include <string>
+#include <exception>
+#include <memory>
+#include <cstddef>
+
+/**
+ * @class MixerException
+ * @brief This is the base class of all exceptions thrown by @b Mixer
+ */
+class MixerException: public std::exception {
+    protected:
+        std::string msg;
+        explicit MixerException(const std::string& msg): msg(msg) {}
+
+    public:
+        /// @brief Get a message describing the error
+        /// @return NULL-terminated c-string
+        const char* what() const noexcept override { return msg.c_str(); }
+};
+
+/**
+ * @class MixerUserError
+ * @brief This means an input or bus index was out of range
+ */
+class MixerUserError: public MixerException {
+    public:
+        explicit MixerUserError(const std::string& msg): MixerException("MixerUserError: " + msg) {}
+};
+
+/**
+ * @class Mixer
+ * @brief Sums N mono inputs into M mono buses, with a gain per input and bus
+ *
+ * Gains and mutes may be set from any thread; they are picked up at the
+ * start of the next block, and a gain that changed ramps linearly across
+ * that block, reaching its new value on the last sample.
+ *
+ * Each bus is built in passes of up to 4 inputs, so every pass loads and
+ * stores the bus once for 4 multiply-adds. Where the target has FMA,
+ * these are fused, so the mix may differ in the last bit between builds
+ * with and without it. Inputs that are null, muted or at a gain of 0 for
+ * the whole block are left out of the passes altogether.
+ */
+class Mixer {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /// @brief Mixer of @p inputs inputs into @p buses buses, all gains 0
+        /// @throws MixerUserError if either is 0
+        Mixer(unsigned inputs, unsigned buses);
+
+        ~Mixer();
+
+        Mixer(const Mixer&) = delete;
+        Mixer& operator=(const Mixer&) = delete;
+
+        /// @brief Number of inputs
+        unsigned inputs() const;
+
+        /// @brief Number of buses
+        unsigned buses() const;
+
+        /// @brief Set the gain of @p input into @p bus, from any thread
+        /// @throws MixerUserError if @p input or @p bus is out of range
+        void set_gain(unsigned input, unsigned bus, float gain);
+
+        /// @brief Gain of @p input into @p bus last set
+        /// @throws MixerUserError if @p input or @p bus is out of range
+        float gain(unsigned input, unsigned bus) const;
+
+        /// @brief Mute or unmute @p input on every bus, from any thread; ramps like a gain change
+        /// @throws MixerUserError if @p input is out of range
+        void set_muted(unsigned input, bool muted);
+
+        /// @brief Check if @p input is muted
+        /// @throws MixerUserError if @p input is out of range
+        bool muted(unsigned input) const;
+
+        /// @brief Mix @p frames frames of @p in into @p out
+        /// @param in One buffer per input; null for a silent input
+        /// @param out One buffer per bus, written in full
+        void process(const float* const* in, float* const* out, size_t frames);
+};
+
+#endif // SIMPLY_MIXER_HPP_
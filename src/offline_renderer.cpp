@@ -0,0 +1,171 @@
+#include "offline_renderer.hpp"
+#include "graph_runner.hpp"
+#include "memory.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// ====== OfflineRenderer Implementation ======
+struct OfflineRenderer::Impl {
+    // One file, with its channels and conversion scratch
+    struct Output {
+        WavWriter*                 writer;
+        std::vector<unsigned>      channels;
+        std::unique_ptr<Quantizer> quantizer; // null for float files
+        std::vector<const float*>  planes;    // scratch, the channels at an offset
+        AlignedBuffer<uint8_t>     interleaved;
+    };
+
+    Options                              opts;
+    std::unique_ptr<GraphPlan>           plan;
+    std::unique_ptr<ParallelGraphRunner> runner;
+    uint32_t                             rate;
+    std::vector<Output>                  outputs;
+    render_source_t                      source = nullptr;
+    void*                                data   = nullptr;
+
+    AlignedBuffer<float>                 in_buf;  // inputs x stride
+    AlignedBuffer<float>                 out_buf; // outputs x stride
+    size_t                               stride;
+    std::vector<float*>                  ins;
+    std::vector<float*>                  outs;
+    uint64_t                             pulled   = 0; // input frames asked of the source
+    uint64_t                             rendered = 0; // output frames written
+    size_t                               skip;         // latency frames still to drop
+    size_t                               ready_at = 0; // rendered frames not yet written,
+    size_t                               ready    = 0; // at this offset in outs
+
+    Impl(const Graph& graph, uint32_t sample_rate, const Options& options): opts(options), rate(sample_rate) {
+        unsigned helpers = opts.helpers >= 0 ? static_cast<unsigned>(opts.helpers)
+                                             : std::max(std::thread::hardware_concurrency(), 1u) - 1;
+        Graph::CompileOptions compile;
+        compile.parallel = helpers > 0;
+        plan = graph.compile(sample_rate, opts.block, compile);
+        if ( helpers ) {
+            ParallelGraphRunner::Options team;
+            team.priority = opts.priority;
+            runner.reset(new ParallelGraphRunner(helpers, team));
+        }
+
+        stride = (opts.block + 15) & ~static_cast<size_t>(15);
+        in_buf.allocate(std::max(plan->inputs(), 1u) * stride);
+        out_buf.allocate(std::max(plan->outputs(), 1u) * stride);
+        for ( unsigned ch = 0; ch < plan->inputs(); ch++ )
+            ins.push_back(in_buf.data() + ch * stride);
+        for ( unsigned ch = 0; ch < plan->outputs(); ch++ )
+            outs.push_back(out_buf.data() + ch * stride);
+        skip = opts.trim_latency ? plan->latency() : 0;
+    }
+
+    void add_output(WavWriter& writer, const std::vector<unsigned>& channels) {
+        const WavFormat& f = writer.format();
+        if ( channels.empty() || channels.size() != f.channels )
+            throw OfflineRendererUserError("The file has " + std::to_string(f.channels) + " channels, not " +
+                                           std::to_string(channels.size()) + "!");
+        for ( unsigned ch : channels )
+            if ( ch >= plan->outputs() )
+                throw OfflineRendererUserError("The graph has no output " + std::to_string(ch) + "!");
+        if ( f.sample_rate != rate )
+            throw OfflineRendererUserError("The file's sample rate differs from the graph's!");
+        bool pcm = !f.is_float && (f.bits_per_sample == 16 || f.bits_per_sample == 24 || f.bits_per_sample == 32);
+        if ( !pcm && !(f.is_float && f.bits_per_sample == 32) )
+            throw OfflineRendererUserError("Only 16, 24 and 32-bit PCM or 32-bit float files can be rendered to!");
+
+        Output out;
+        out.writer   = &writer;
+        out.channels = channels;
+        if ( pcm )
+            out.quantizer.reset(new Quantizer(f.channels, f.bits_per_sample, opts.quantize));
+        out.planes.resize(channels.size());
+        out.interleaved.allocate(opts.block * f.frame_bytes());
+        outputs.push_back(std::move(out));
+    }
+
+    void run(size_t frames) {
+        if ( source )
+            source(ins.data(), frames, pulled, data);
+        else
+            in_buf.zero();
+        pulled += frames;
+        if ( runner )
+            runner->process(*plan, ins.data(), outs.data(), frames);
+        else
+            plan->process(ins.data(), outs.data(), frames);
+    }
+
+    void emit(size_t offset, size_t frames) {
+        for ( Output& out : outputs ) {
+            std::vector<const float*>& planes = out.planes;
+            for ( size_t c = 0; c < planes.size(); c++ )
+                planes[c] = outs[out.channels[c]] + offset;
+            if ( out.quantizer ) {
+                out.quantizer->process(planes.data(), out.interleaved.data(), frames);
+            } else {
+                float* dst = reinterpret_cast<float*>(out.interleaved.data());
+                size_t n   = planes.size();
+                for ( size_t c = 0; c < n; c++ )
+                    for ( size_t i = 0; i < frames; i++ )
+                        dst[i * n + c] = planes[c][i];
+            }
+            out.writer->write(out.interleaved.data(), frames);
+        }
+        rendered += frames;
+    }
+
+    void render(uint64_t frames) {
+        uint64_t end = rendered + frames;
+        while ( rendered < end ) {
+            // The graph only ever runs whole blocks, so feedback is always
+            // one block late; what this render doesn't need waits in outs
+            // for the next one. The latency is rendered and dropped first
+            if ( !ready ) {
+                run(opts.block);
+                size_t dropped = std::min(skip, opts.block);
+                skip    -= dropped;
+                ready_at = dropped;
+                ready    = opts.block - dropped;
+                continue;
+            }
+            size_t n = static_cast<size_t>(std::min<uint64_t>(ready, end - rendered));
+            emit(ready_at, n);
+            ready_at += n;
+            ready    -= n;
+        }
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- OfflineRenderer Class Methods --- -------------------------------
+OfflineRenderer::OfflineRenderer(const Graph& graph, uint32_t sample_rate):
+    OfflineRenderer(graph, sample_rate, Options()) {}
+
+OfflineRenderer::OfflineRenderer(const Graph& graph, uint32_t sample_rate, const Options& options):
+    pimpl(new Impl(graph, sample_rate, options)) {}
+
+OfflineRenderer::~OfflineRenderer() = default;
+
+void OfflineRenderer::add_output(WavWriter& writer, const std::vector<unsigned>& channels) {
+    pimpl->add_output(writer, channels);
+}
+
+void OfflineRenderer::set_source(render_source_t source, void* data) {
+    pimpl->source = source;
+    pimpl->data   = data;
+}
+
+void OfflineRenderer::render(uint64_t frames) {
+    pimpl->render(frames);
+}
+
+uint64_t OfflineRenderer::position() const {
+    return pimpl->rendered;
+}
+
+size_t OfflineRenderer::latency() const {
+    return pimpl->plan->latency();
+}
+
+unsigned OfflineRenderer::helpers() const {
+    return pimpl->runner ? pimpl->runner->helpers() : 0;
+}
@@ -0,0 +1,148 @@
+/**
+ * @file offline_renderer.hpp
+ * @brief Provides @b OfflineRenderer, running a @b Graph as fast as possible into WAV files
+ */
+#ifndef SIMPLY_OFFLINE_RENDERER_HPP_
+#define SIMPLY_OFFLINE_RENDERER_HPP_
+
+#include "graph.hpp"
+#include "quantizer.hpp"
+#include "threads.hpp"
+#include "wav.hpp"
+
+#include <string>
+#include <exception>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/// @typedef render_source_t
+/// @brief Fills the graph inputs for an offline render
+/// @param in One buffer per graph input channel, to write in full
+/// @param frames Frames to write
+/// @param position Frame of the render the first one is, from 0
+/// @param data As given to @b OfflineRenderer::set_source
+typedef void (*render_source_t)(float* const* in, size_t frames, uint64_t position, void* data);
+
+/**
+ * @class OfflineRendererException
+ * @brief This is the base class of all exceptions thrown by @b OfflineRenderer
+ */
+class OfflineRendererException: public std::exception {
+    protected:
+        std::string msg;
+        explicit OfflineRendererException(const std::string& msg): msg(msg) {}
+
+    public:
+        /// @brief Get a message describing the error
+        /// @return NULL-terminated c-string
+        const char* what() const noexcept override { return msg.c_str(); }
+};
+
+/**
+ * @class OfflineRendererUserError
+ * @brief This means an output didn't match the graph, or had a format that can't be rendered to
+ */
+class OfflineRendererUserError: public OfflineRendererException {
+    public:
+        explicit OfflineRendererUserError(const std::string& msg): OfflineRendererException("OfflineRendererUserError: " + msg) {}
+};
+
+/**
+ * @class OfflineRenderer
+ * @brief Bounces a @b Graph to files, paced by the CPU and disk rather than an audio device
+ *
+ * The graph is compiled for blocks of @b Options::block frames, far larger
+ * than an audio callback's, so per-block overheads (scheduling, the
+ * plan's pointer tables, node setup) are spread over many samples. The
+ * plan is laid out for parallel runs and driven by a
+ * @b ParallelGraphRunner, so independent branches (tracks, buses) run on
+ * all cores at once.
+ *
+ * Each rendered block is converted to every output file's format
+ * (through a @b Quantizer for integer PCM) and handed to its
+ * @b WavWriter with @b WavWriter::write, which waits for the disk instead
+ * of dropping; the writers' own threads do the file I/O while the next
+ * block renders.
+ *
+ * With @b Options::trim_latency, the graph's latency is rendered and
+ * discarded up-front, so the files line up with the inputs.
+ *
+ * The graph always runs whole blocks: a @b render that ends mid-block
+ * keeps the rest for the next one, and the source is asked for up to a
+ * block past the end. Feedback connections are therefore delayed by
+ * exactly @b Options::block frames, not by the live block size; set it to
+ * that size to render a graph with feedback as it sounds live.
+ *
+ * @code
+ * OfflineRenderer render(graph, 48000);
+ * WavWriter mix("mix.wav", format);
+ * render.add_output(mix, {0, 1});
+ * render.set_source(read_stems, &stems);
+ * render.render(length);
+ * mix.close();
+ * @endcode
+ *
+ * @note Compiling prepares the graph's nodes for the offline block size, so don't render a graph a live plan is running
+ */
+class OfflineRenderer {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /**
+         * @struct Options
+         * @brief Blocks and threads
+         */
+        struct Options {
+            /// Frames per block the graph runs on, which is also the delay of its feedback connections
+            size_t             block        = 8192;
+            /// Threads besides the caller of @b render; -1 for one per remaining core
+            int                helpers      = -1;
+            /// Priority of the helper threads
+            Thread::Priority   priority     = Thread::NORMAL;
+            /// Render the graph's latency first and drop it, to align the output with the input
+            bool               trim_latency = true;
+            /// Dither and noise shaping for integer PCM outputs
+            Quantizer::Options quantize;
+        };
+
+        /// @brief Renderer of @p graph at @p sample_rate
+        /// @throws GraphUserError if the graph has a cycle
+        OfflineRenderer(const Graph& graph, uint32_t sample_rate);
+
+        /// @brief Create with @p options
+        /// @throws GraphUserError if the graph has a cycle or @b Options::block is 0
+        OfflineRenderer(const Graph& graph, uint32_t sample_rate, const Options& options);
+
+        /// @brief Stops and joins the helper threads; the writers stay open
+        ~OfflineRenderer();
+
+        OfflineRenderer(const OfflineRenderer&) = delete;
+        OfflineRenderer& operator=(const OfflineRenderer&) = delete;
+
+        /// @brief Write graph outputs @p channels, in order, to @p writer, which must outlive the renderer
+        /// @throws OfflineRendererUserError if the channels don't exist or don't match the file's, the
+        ///         sample rate differs, or the format is neither 16, 24 or 32-bit PCM nor 32-bit float
+        void add_output(WavWriter& writer, const std::vector<unsigned>& channels);
+
+        /// @brief Take the graph inputs from @p source (silence if null, the default)
+        void set_source(render_source_t source, void* data=nullptr);
+
+        /// @brief Render the next @p frames frames to every output, returning once all are queued
+        /// @throws WavUserError or WavRuntimeError if a writer fails
+        void render(uint64_t frames);
+
+        /// @brief Frames rendered to the outputs so far
+        uint64_t position() const;
+
+        /// @brief Latency of the compiled graph in frames
+        size_t latency() const;
+
+        /// @brief Number of helper threads
+        unsigned helpers() const;
+};
+
+#endif // SIMPLY_OFFLINE_RENDERER_HPP_
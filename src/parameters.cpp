@@ -0,0 +1,226 @@
+#include "parameters.hpp"
+#include "memory.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+// ---------------------------------------------------------------------
+// --- Ramp Kernels --- ------------------------------------------------
+// dst[i] = start + step * (i + 1)
+static void fill_linear(float* dst, size_t n, float start, float step) {
+    float4 v   = float4::broadcast(start) + float4::set(step, 2 * step, 3 * step, 4 * step);
+    float4 inc = float4::broadcast(4 * step);
+    size_t i = 0;
+    for ( ; i + 4 <= n; i += 4 ) {
+        v.store_aligned(dst + i);
+        v += inc;
+    }
+    for ( ; i < n; i++ )
+        dst[i] = start + step * (i + 1);
+}
+
+// dst[i] = start * ratio^(i + 1)
+static void fill_exponential(float* dst, size_t n, float start, float ratio) {
+    float r2 = ratio * ratio;
+    float4 v   = float4::broadcast(start) * float4::set(ratio, r2, r2 * ratio, r2 * r2);
+    float4 mul = float4::broadcast(r2 * r2);
+    size_t i = 0;
+    for ( ; i + 4 <= n; i += 4 ) {
+        v.store_aligned(dst + i);
+        v *= mul;
+    }
+    float last = i ? dst[i - 1] : start;
+    for ( ; i < n; i++ )
+        dst[i] = last *= ratio;
+}
+
+// ====== ParameterBank Implementation ======
+struct ParameterBank::Impl {
+    // Audio thread view of one parameter
+    struct State {
+        double   current   = 0.0; // value at the end of the last block
+        double   target    = 0.0;
+        double   step      = 0.0; // increment, or ratio when exponential
+        bool     geometric = false;
+        uint32_t remaining = 0;   // frames left in the ramp
+        uint32_t frames    = 0;   // length of a ramp
+        int32_t  slot      = -1;  // block buffer, while ramping
+        Ramp     ramp      = LINEAR;
+    };
+
+    size_t                                 capacity;
+    Options                                opts;
+    size_t                                 count = 0;
+
+    // Written by any thread
+    std::unique_ptr<std::atomic<float>[]>    targets;
+    std::unique_ptr<std::atomic<uint64_t>[]> dirty;
+    size_t                                   words;
+
+    // Audio thread only
+    std::vector<State>                     state;
+    std::vector<uint32_t>                  active_list;
+    std::vector<int32_t>                   free_slots;
+    AlignedBuffer<float>                   buffers; // max_ramps * max_block
+
+    Impl(size_t cap, const Options& options): capacity(cap), opts(options) {
+        opts.max_block = (options.max_block + 3) & ~static_cast<size_t>(3);
+        words = (capacity + 63) / 64;
+        targets.reset(new std::atomic<float>[capacity]);
+        dirty.reset(new std::atomic<uint64_t>[words]);
+        for ( size_t w = 0; w < words; w++ )
+            dirty[w].store(0, std::memory_order_relaxed);
+
+        state.resize(capacity);
+        active_list.reserve(opts.max_ramps);
+        for ( size_t s = opts.max_ramps; s-- > 0; )
+            free_slots.push_back(static_cast<int32_t>(s));
+        buffers.allocate(opts.max_ramps * opts.max_block);
+    }
+
+    size_t add(float initial, Ramp ramp, size_t ramp_frames) {
+        if ( count == capacity )
+            throw ParameterUserError("Parameter bank is full!");
+        targets[count].store(initial, std::memory_order_relaxed);
+        State& s  = state[count];
+        s.current = s.target = initial;
+        s.ramp    = ramp;
+        s.frames  = static_cast<uint32_t>(ramp_frames);
+        return count++;
+    }
+
+    void check(size_t id) const {
+        if ( id >= count )
+            throw ParameterUserError("Parameter " + std::to_string(id) + " doesn't exist!");
+    }
+
+    void start_ramp(uint32_t id) {
+        State& s = state[id];
+        s.target = targets[id].load(std::memory_order_relaxed);
+        if ( s.target == s.current ) {
+            s.remaining = 0;
+            return;
+        }
+        if ( !s.frames || (s.slot < 0 && free_slots.empty()) ) {
+            s.current   = s.target;
+            s.remaining = 0;
+            return;
+        }
+
+        s.remaining = s.frames;
+        s.geometric = s.ramp == EXPONENTIAL && s.current * s.target > 0.0;
+        if ( s.geometric )
+            s.step = std::pow(s.target / s.current, 1.0 / s.frames);
+        else
+            s.step = (s.target - s.current) / s.frames;
+
+        if ( s.slot < 0 ) {
+            s.slot = free_slots.back();
+            free_slots.pop_back();
+            active_list.push_back(id);
+        }
+    }
+
+    void begin_block(size_t frames) {
+        if ( frames > opts.max_block )
+            throw ParameterUserError("Block is larger than Options::max_block!");
+
+        // Ramps that finished last block leave the active list now,
+        // after their final block was read
+        for ( size_t i = 0; i < active_list.size(); ) {
+            State& s = state[active_list[i]];
+            if ( s.remaining ) {
+                i++;
+                continue;
+            }
+            free_slots.push_back(s.slot);
+            s.slot         = -1;
+            active_list[i] = active_list.back();
+            active_list.pop_back();
+        }
+
+        for ( size_t w = 0; w < words; w++ ) {
+            if ( !dirty[w].load(std::memory_order_relaxed) )
+                continue;
+            uint64_t bits = dirty[w].exchange(0, std::memory_order_acquire);
+            while ( bits ) {
+                unsigned b = 0;
+                while ( !((bits >> b) & 1) )
+                    b++;
+                bits &= bits - 1;
+                start_ramp(static_cast<uint32_t>(w * 64 + b));
+            }
+        }
+
+        for ( uint32_t id : active_list ) {
+            State& s   = state[id];
+            float* dst = buffers.data() + s.slot * opts.max_block;
+            size_t n   = std::min<size_t>(frames, s.remaining);
+            if ( s.geometric ) {
+                fill_exponential(dst, n, static_cast<float>(s.current), static_cast<float>(s.step));
+                s.current *= std::pow(s.step, static_cast<double>(n));
+            } else {
+                fill_linear(dst, n, static_cast<float>(s.current), static_cast<float>(s.step));
+                s.current += s.step * n;
+            }
+            s.remaining -= static_cast<uint32_t>(n);
+            if ( !s.remaining ) {
+                s.current = s.target;
+                std::fill(dst + n, dst + frames, static_cast<float>(s.target));
+                if ( n )
+                    dst[n - 1] = static_cast<float>(s.target);
+            }
+        }
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- ParameterBank Class Methods --- ---------------------------------
+ParameterBank::ParameterBank(size_t capacity): ParameterBank(capacity, Options()) {}
+
+ParameterBank::ParameterBank(size_t capacity, const Options& options): pimpl(new Impl(capacity, options)) {}
+
+ParameterBank::~ParameterBank() = default;
+
+size_t ParameterBank::add(float initial, Ramp ramp, size_t ramp_frames) {
+    return pimpl->add(initial, ramp, ramp_frames);
+}
+
+size_t ParameterBank::size() const {
+    return pimpl->count;
+}
+
+void ParameterBank::set(size_t id, float value) {
+    pimpl->check(id);
+    pimpl->targets[id].store(value, std::memory_order_relaxed);
+    pimpl->dirty[id / 64].fetch_or(uint64_t(1) << (id % 64), std::memory_order_release);
+}
+
+float ParameterBank::target(size_t id) const {
+    pimpl->check(id);
+    return pimpl->targets[id].load(std::memory_order_relaxed);
+}
+
+void ParameterBank::begin_block(size_t frames) {
+    pimpl->begin_block(frames);
+}
+
+const float* ParameterBank::block(size_t id) const {
+    const Impl::State& s = pimpl->state[id];
+    return s.slot < 0 ? nullptr : pimpl->buffers.data() + s.slot * pimpl->opts.max_block;
+}
+
+float ParameterBank::value(size_t id) const {
+    return static_cast<float>(pimpl->state[id].current);
+}
+
+size_t ParameterBank::active() const {
+    return pimpl->active_list.size();
+}
+
+const uint32_t* ParameterBank::active_ids() const {
+    return pimpl->active_list.data();
+}
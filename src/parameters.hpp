@@ -0,0 +1,127 @@
+/**
+ * @file parameters.hpp
+ * @brief Provides @b ParameterBank for changing parameters of real-time processing
+ */
+#ifndef SIMPLY_PARAMETERS_HPP_
+#define SIMPLY_PARAMETERS_HPP_
+
+#include <string>
+#include <exception>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class ParameterException
+ * @brief This is the base class of all exceptions thrown by @b ParameterBank
+ */
+class ParameterException: public std::exception {
+    protected:
+        std::string msg;
+        explicit ParameterException(const std::string& msg): msg(msg) {}
+
+    public:
+        /// @brief Get a message describing the error
+        /// @return NULL-terminated c-string
+        const char* what() const noexcept override { return msg.c_str(); }
+};
+
+/**
+ * @class ParameterUserError
+ * @brief This means a parameter id, block size or capacity was exceeded
+ */
+class ParameterUserError: public ParameterException {
+    public:
+        explicit ParameterUserError(const std::string& msg): ParameterException("ParameterUserError: " + msg) {}
+};
+
+/**
+ * @class ParameterBank
+ * @brief Parameters written by any thread and ramped smoothly by the audio thread
+ *
+ * @b set stores a new target atomically and marks the parameter in a
+ * bitmask of dirty words, so it never blocks. At the start of each block
+ * the audio thread calls @b begin_block, which swaps out each non-zero
+ * dirty word (64 parameters at a time) and starts a ramp towards every
+ * new target. Only parameters that are ramping are on the active list,
+ * so parameters that don't move cost nothing per block.
+ *
+ * A ramping parameter's per-sample values for the block are filled in
+ * with SIMD and returned by @b block; a static one returns `nullptr` and
+ * its @b value is used for the whole block.
+ *
+ * @note @b add, @b begin_block, @b block and @b value belong to the audio
+ * thread (or setup before it starts); @b set and @b target may be called from any thread
+ */
+class ParameterBank {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /**
+         * @enum Ramp
+         * @brief Shape of the transition to a new target
+         */
+        enum Ramp {
+            /// Constant step per sample
+            LINEAR,
+            /// Constant ratio per sample, for gains and frequencies (linear if the sign changes or a value is 0)
+            EXPONENTIAL
+        };
+
+        /**
+         * @struct Options
+         * @brief Capacity of the bank
+         */
+        struct Options {
+            /// Largest number of frames per block
+            size_t max_block = 1024;
+            /// Parameters that may ramp at once; further changes jump to their target
+            size_t max_ramps = 256;
+        };
+
+        /// @brief Bank with room for @p capacity parameters
+        explicit ParameterBank(size_t capacity);
+
+        /// @brief Bank with room for @p capacity parameters, with @p options
+        ParameterBank(size_t capacity, const Options& options);
+
+        ~ParameterBank();
+
+        ParameterBank(const ParameterBank&) = delete;
+        ParameterBank& operator=(const ParameterBank&) = delete;
+
+        /// @brief Add a parameter starting at @p initial
+        /// @param ramp_frames Length of every ramp, 0 to jump
+        /// @return Id of the parameter, counting from 0
+        /// @throws ParameterUserError if the bank is full
+        size_t add(float initial, Ramp ramp=LINEAR, size_t ramp_frames=480);
+
+        /// @brief Number of parameters added
+        size_t size() const;
+
+        /// @brief Set the target of parameter @p id, from any thread
+        void set(size_t id, float value);
+
+        /// @brief Latest target of parameter @p id, from any thread
+        float target(size_t id) const;
+
+        /// @brief Pick up new targets and compute the ramps for the next @p frames frames
+        /// @throws ParameterUserError if @p frames exceeds @b Options::max_block
+        void begin_block(size_t frames);
+
+        /// @brief Per-sample values of parameter @p id for this block, or `nullptr` if it isn't moving
+        const float* block(size_t id) const;
+
+        /// @brief Value of parameter @p id at the end of this block
+        float value(size_t id) const;
+
+        /// @brief Number of parameters ramping in this block
+        size_t active() const;
+
+        /// @brief Ids of the parameters ramping in this block
+        const uint32_t* active_ids() const;
+};
+
+#endif // SIMPLY_PARAMETERS_HPP_
@@ -0,0 +1,453 @@
+#include "pipe.hpp"
+#include "memory.hpp"
+
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+#ifdef _WIN32
+extern "C" {
+    #include <io.h>
+    #include <fcntl.h>
+}
+
+#else
+extern "C" {
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+    #include <sys/uio.h>
+}
+#endif
+
+#if defined(__linux__) && defined(F_SETPIPE_SZ)
+#define SIMPLY_PIPE_SPLICE 1
+#endif
+
+// ---------------------------------------------------------------------
+// --- Helpers --- -----------------------------------------------------
+static const char     PCM_MAGIC[4]  = {'S', 'A', 'P', 'C'};
+static const uint8_t  PCM_VERSION   = 1;
+static const size_t   PAGE_BYTES    = 4096;
+static const size_t   DEFAULT_PIPE  = 1 << 16;
+
+// Biggest single read/write, _read/_write take an unsigned int
+static const size_t   MAX_IO        = 1 << 30;
+
+static void put_u16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+static void put_u32(uint8_t* p, uint32_t v) {
+    put_u16(p, static_cast<uint16_t>(v));
+    put_u16(p + 2, static_cast<uint16_t>(v >> 16));
+}
+
+static uint16_t get_u16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+    return get_u16(p) | (static_cast<uint32_t>(get_u16(p + 2)) << 16);
+}
+
+static void set_binary(int fd) {
+    #ifdef _WIN32
+    _setmode(fd, _O_BINARY);
+    #else
+    (void) fd;
+    #endif
+}
+
+// Returns bytes read, 0 at the end of the stream
+static size_t read_some(int fd, void* data, size_t bytes) {
+    bytes = std::min(bytes, MAX_IO);
+    while ( true ) {
+        #ifdef _WIN32
+        int n = _read(fd, data, static_cast<unsigned int>(bytes));
+        #else
+        ssize_t n = ::read(fd, data, bytes);
+        #endif
+        if ( n >= 0 )
+            return static_cast<size_t>(n);
+        if ( errno != EINTR )
+            throw PipeRuntimeError("Failed to read from the stream!");
+    }
+}
+
+static void write_all(int fd, const void* data, size_t bytes) {
+    const uint8_t* src = static_cast<const uint8_t*>(data);
+    while ( bytes ) {
+        #ifdef _WIN32
+        int n = _write(fd, src, static_cast<unsigned int>(std::min(bytes, MAX_IO)));
+        #else
+        ssize_t n = ::write(fd, src, std::min(bytes, MAX_IO));
+        #endif
+        if ( n < 0 ) {
+            if ( errno == EINTR )
+                continue;
+            if ( errno == EPIPE )
+                throw PipeRuntimeError("The reader closed the stream!");
+            throw PipeRuntimeError("Failed to write to the stream!");
+        }
+        src   += n;
+        bytes -= static_cast<size_t>(n);
+    }
+}
+
+static bool is_pipe(int fd) {
+    #ifdef _WIN32
+    (void) fd;
+    return false;
+    #else
+    struct stat st;
+    return fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+    #endif
+}
+
+// ====== PcmPipeSink Implementation ======
+struct PcmPipeSink::Impl {
+    int                    fd;
+    PcmHeader              header;
+    size_t                 frame_bytes;
+    bool                   zero_copy = false;
+
+    // acquire() hands out contiguous regions of ring, wrapping to the
+    // start when a region doesn't fit. With the ring 3x the pipe's
+    // capacity and regions at most half of it, at least 2x the capacity
+    // is sent after a region before it is handed out again, by which
+    // time the reader has copied it out of the pipe
+    AlignedBuffer<uint8_t> ring;
+    size_t                 max_frames   = 0;
+    size_t                 ring_pos     = 0;
+    size_t                 acquired_pos = 0;
+    size_t                 acquired     = 0;
+
+    uint64_t               written = 0;
+
+    Impl(int fd, const PcmHeader& header, const Options& options):
+        fd(fd), header(header), frame_bytes(header.frame_bytes())
+    {
+        if ( header.format < PcmHeader::INT16 || header.format > PcmHeader::FLOAT32 )
+            throw PipeUserError("Unknown sample format!");
+        if ( !header.channels || !header.sample_rate )
+            throw PipeUserError("Channels and sample rate must be non-zero!");
+        set_binary(fd);
+
+        size_t capacity = DEFAULT_PIPE;
+        #ifdef SIMPLY_PIPE_SPLICE
+        if ( is_pipe(fd) ) {
+            if ( options.pipe_bytes )
+                fcntl(fd, F_SETPIPE_SZ, static_cast<int>(options.pipe_bytes)); // best-effort
+            int actual = fcntl(fd, F_GETPIPE_SZ);
+            if ( actual > 0 )
+                capacity = static_cast<size_t>(actual);
+            zero_copy = options.zero_copy;
+        }
+        #else
+        (void) options;
+        #endif
+
+        max_frames = std::max<size_t>(capacity / 2 / frame_bytes, 1);
+        size_t ring_bytes = std::max(3 * capacity, 3 * max_frames * frame_bytes);
+        ring.allocate((ring_bytes + PAGE_BYTES - 1) / PAGE_BYTES * PAGE_BYTES, PAGE_BYTES);
+
+        uint8_t raw[PcmHeader::BYTES] = {};
+        std::memcpy(raw, PCM_MAGIC, 4);
+        raw[4] = PCM_VERSION;
+        raw[5] = static_cast<uint8_t>(header.format);
+        put_u16(raw + 6, header.channels);
+        put_u32(raw + 8, header.sample_rate);
+        write_all(fd, raw, sizeof(raw));
+    }
+
+    void* acquire(size_t frames) {
+        if ( frames > max_frames )
+            throw PipeUserError("Can't acquire more than max_acquire() frames!");
+        if ( ring_pos + frames * frame_bytes > ring.size() )
+            ring_pos = 0;
+        acquired_pos = ring_pos;
+        acquired     = frames;
+        return ring.data() + ring_pos;
+    }
+
+    void commit(size_t frames) {
+        if ( frames > acquired )
+            throw PipeUserError("Can't commit more frames than were acquired!");
+        size_t bytes = frames * frame_bytes;
+        send(ring.data() + acquired_pos, bytes);
+        ring_pos = acquired_pos + bytes;
+        acquired = 0;
+        written += frames;
+    }
+
+    void write(const void* data, size_t frames) {
+        write_all(fd, data, frames * frame_bytes);
+        written += frames;
+    }
+
+    void send(const uint8_t* data, size_t bytes) {
+        #ifdef SIMPLY_PIPE_SPLICE
+        if ( zero_copy ) {
+            while ( bytes ) {
+                struct iovec iov = { const_cast<uint8_t*>(data), bytes };
+                ssize_t n = vmsplice(fd, &iov, 1, 0);
+                if ( n < 0 ) {
+                    if ( errno == EINTR )
+                        continue;
+                    if ( errno == EPIPE )
+                        throw PipeRuntimeError("The reader closed the stream!");
+                    zero_copy = false; // e.g. not permitted on this pipe
+                    break;
+                }
+                data  += n;
+                bytes -= static_cast<size_t>(n);
+            }
+        }
+        #endif
+        write_all(fd, data, bytes);
+    }
+};
+
+// ====== PcmPipeSource Implementation ======
+struct PcmPipeSource::Impl {
+    int                    fd;
+    PcmHeader              header;
+    size_t                 frame_bytes = 0;
+
+    // Unconsumed bytes are buffer[begin, end)
+    AlignedBuffer<uint8_t> buffer;
+    size_t                 begin = 0;
+    size_t                 end   = 0;
+    bool                   eof   = false;
+
+    uint64_t               read_frames = 0;
+
+    Impl(int fd, const Options& options): fd(fd) {
+        set_binary(fd);
+        buffer.allocate(std::max<size_t>(options.buffer_bytes, PAGE_BYTES), PAGE_BYTES);
+
+        while ( end < PcmHeader::BYTES && fill() )
+            ;
+        if ( end < PcmHeader::BYTES )
+            throw PipeRuntimeError("Stream ended before the header!");
+
+        const uint8_t* raw = buffer.data();
+        if ( std::memcmp(raw, PCM_MAGIC, 4) != 0 )
+            throw PipeRuntimeError("Stream doesn't start with a PCM header!");
+        if ( raw[4] != PCM_VERSION )
+            throw PipeRuntimeError("Unsupported PCM header version " + std::to_string(raw[4]) + "!");
+        if ( raw[5] < PcmHeader::INT16 || raw[5] > PcmHeader::FLOAT32 )
+            throw PipeRuntimeError("Unknown sample format " + std::to_string(raw[5]) + "!");
+        header.format      = static_cast<PcmHeader::SampleFormat>(raw[5]);
+        header.channels    = get_u16(raw + 6);
+        header.sample_rate = get_u32(raw + 8);
+        if ( !header.channels || !header.sample_rate )
+            throw PipeRuntimeError("Header has no channels or no sample rate!");
+        frame_bytes = header.frame_bytes();
+        begin       = PcmHeader::BYTES;
+
+        if ( buffer.size() < 2 * frame_bytes ) {
+            AlignedBuffer<uint8_t> larger(2 * frame_bytes, PAGE_BYTES);
+            std::memcpy(larger.data(), buffer.data() + begin, end - begin);
+            end   -= begin;
+            begin  = 0;
+            buffer = std::move(larger);
+        }
+    }
+
+    size_t available() const {
+        return (end - begin) / frame_bytes;
+    }
+
+    // Read once into the free space, moving leftovers to the front first
+    bool fill() {
+        if ( eof )
+            return false;
+        if ( begin ) {
+            std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+            end  -= begin;
+            begin = 0;
+        }
+        size_t n = read_some(fd, buffer.data() + end, buffer.size() - end);
+        if ( !n )
+            eof = true;
+        end += n;
+        return n != 0;
+    }
+
+    const void* peek(size_t& frames) {
+        while ( !available() && fill() )
+            ;
+        frames = available();
+        return buffer.data() + begin;
+    }
+
+    void consume(size_t frames) {
+        if ( frames > available() )
+            throw PipeUserError("Can't consume more frames than peek() returned!");
+        begin       += frames * frame_bytes;
+        read_frames += frames;
+        if ( begin == end )
+            begin = end = 0;
+    }
+
+    size_t read(void* data, size_t frames) {
+        uint8_t* dst  = static_cast<uint8_t*>(data);
+        size_t   done = 0;
+        while ( done < frames ) {
+            size_t want = frames - done;
+
+            // Large reads skip the buffer once it's empty, keeping any
+            // trailing partial frame for next time
+            if ( begin == end && !eof && want * frame_bytes >= buffer.size() / 2 ) {
+                size_t n = read_some(fd, dst + done * frame_bytes, want * frame_bytes);
+                if ( !n ) {
+                    eof = true;
+                    break;
+                }
+                size_t whole = n / frame_bytes;
+                size_t part  = n - whole * frame_bytes;
+                std::memcpy(buffer.data(), dst + (done + whole) * frame_bytes, part);
+                begin = 0;
+                end   = part;
+                done        += whole;
+                read_frames += whole;
+                continue;
+            }
+
+            size_t avail;
+            const void* src = peek(avail);
+            if ( !avail )
+                break;
+            size_t n = std::min(avail, want);
+            std::memcpy(dst + done * frame_bytes, src, n * frame_bytes);
+            consume(n);
+            done += n;
+        }
+        return done;
+    }
+
+    uint64_t forward(int out, uint64_t frames) {
+        set_binary(out);
+        uint64_t done = 0;
+
+        // Whatever is already buffered has to go first
+        if ( end - begin ) {
+            size_t n = static_cast<size_t>(std::min<uint64_t>(available(), frames));
+            write_all(out, buffer.data() + begin, n * frame_bytes);
+            consume(n);
+            done += n;
+            if ( done == frames )
+                return done;
+        }
+
+        #ifdef SIMPLY_PIPE_SPLICE
+        // Only works when one side is a pipe, otherwise fails with EINVAL
+        // and the buffered copy below takes over. Pages are not moved, as
+        // they may belong to a zero-copy sink's ring
+        if ( begin == end && (is_pipe(fd) || is_pipe(out)) ) {
+            uint64_t bytes = (frames - done) * frame_bytes;
+            uint64_t moved = 0;
+            while ( moved < bytes && !eof ) {
+                size_t chunk = static_cast<size_t>(std::min<uint64_t>(bytes - moved, MAX_IO));
+                ssize_t n = splice(fd, nullptr, out, nullptr, chunk, SPLICE_F_MORE);
+                if ( n < 0 ) {
+                    if ( errno == EINTR )
+                        continue;
+                    if ( errno == EPIPE )
+                        throw PipeRuntimeError("The reader closed the stream!");
+                    if ( errno == EINVAL && !moved )
+                        break;
+                    throw PipeRuntimeError("Failed to splice the stream!");
+                }
+                if ( !n )
+                    eof = true;
+                moved += static_cast<uint64_t>(n);
+            }
+            read_frames += moved / frame_bytes;
+            done        += moved / frame_bytes;
+            if ( moved )
+                return done;
+        }
+        #endif
+
+        while ( done < frames ) {
+            size_t avail;
+            const void* src = peek(avail);
+            if ( !avail )
+                break;
+            size_t n = static_cast<size_t>(std::min<uint64_t>(avail, frames - done));
+            write_all(out, src, n * frame_bytes);
+            consume(n);
+            done += n;
+        }
+        return done;
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- PcmPipeSink Class Methods --- -----------------------------------
+PcmPipeSink::PcmPipeSink(int fd, const PcmHeader& header): PcmPipeSink(fd, header, Options()) {}
+
+PcmPipeSink::PcmPipeSink(int fd, const PcmHeader& header, const Options& options):
+    pimpl(new Impl(fd, header, options)) {}
+
+PcmPipeSink::~PcmPipeSink() = default;
+
+const PcmHeader& PcmPipeSink::header() const {
+    return pimpl->header;
+}
+
+size_t PcmPipeSink::max_acquire() const {
+    return pimpl->max_frames;
+}
+
+void* PcmPipeSink::acquire(size_t frames) {
+    return pimpl->acquire(frames);
+}
+
+void PcmPipeSink::commit(size_t frames) {
+    pimpl->commit(frames);
+}
+
+void PcmPipeSink::write(const void* data, size_t frames) {
+    pimpl->write(data, frames);
+}
+
+uint64_t PcmPipeSink::frames_written() const {
+    return pimpl->written;
+}
+
+// ---------------------------------------------------------------------
+// --- PcmPipeSource Class Methods --- ---------------------------------
+PcmPipeSource::PcmPipeSource(int fd): PcmPipeSource(fd, Options()) {}
+
+PcmPipeSource::PcmPipeSource(int fd, const Options& options): pimpl(new Impl(fd, options)) {}
+
+PcmPipeSource::~PcmPipeSource() = default;
+
+const PcmHeader& PcmPipeSource::header() const {
+    return pimpl->header;
+}
+
+size_t PcmPipeSource::read(void* data, size_t frames) {
+    return pimpl->read(data, frames);
+}
+
+const void* PcmPipeSource::peek(size_t& frames) {
+    return pimpl->peek(frames);
+}
+
+void PcmPipeSource::consume(size_t frames) {
+    pimpl->consume(frames);
+}
+
+uint64_t PcmPipeSource::forward(int fd, uint64_t frames) {
+    return pimpl->forward(fd, frames);
+}
+
+uint64_t PcmPipeSource::frames_read() const {
+    return pimpl->read_frames;
+}
@@ -0,0 +1,220 @@
+/**
+ * @file pipe.hpp
+ * @brief Provides @b PcmPipeSink and @b PcmPipeSource for streaming raw PCM through pipes
+ */
+#ifndef SIMPLY_PIPE_HPP_
+#define SIMPLY_PIPE_HPP_
+
+#include <string>
+#include <exception>
+#include <memory>
+#include <cstdint>
+
+/**
+ * @class PipeException
+ * @brief This is the base class of all exceptions thrown by the PCM pipe classes
+ */
+class PipeException: public std::exception {
+    protected:
+        std::string msg;
+        explicit PipeException(const std::string& msg): msg(msg) {}
+
+    public:
+        /// @brief Get a message describing the error
+        /// @return NULL-terminated c-string
+        const char* what() const noexcept override { return msg.c_str(); }
+};
+
+/**
+ * @class PipeUserError
+ * @brief This means some pipe operations were used in incorrect order/combination
+ */
+class PipeUserError: public PipeException {
+    public:
+        explicit PipeUserError(const std::string& msg): PipeException("PipeUserError: " + msg) {}
+};
+
+/**
+ * @class PipeRuntimeError
+ * @brief This means the stream is malformed or your system failed to handle a valid operation
+ */
+class PipeRuntimeError: public PipeException {
+    public:
+        explicit PipeRuntimeError(const std::string& msg): PipeException("PipeRuntimeError: " + msg) {}
+};
+
+/**
+ * @struct PcmHeader
+ * @brief Describes the samples that follow it in a PCM stream
+ *
+ * Sent as the first 16 bytes of every stream, so each stage of a
+ * pipeline learns the format from its input:
+ * `"SAPC" | version u8 | format u8 | channels u16 | sample rate u32 | reserved u32`
+ * (little-endian), followed by interleaved frames.
+ */
+struct PcmHeader {
+    /**
+     * @enum SampleFormat
+     * @brief Encoding of each sample, always little-endian
+     */
+    enum SampleFormat {
+        /// Signed 16-bit integer
+        INT16   = 1,
+        /// Signed 24-bit integer, packed in 3 bytes
+        INT24   = 2,
+        /// Signed 32-bit integer
+        INT32   = 3,
+        /// 32-bit IEEE float
+        FLOAT32 = 4
+    };
+
+    /// Size of the header on the wire
+    static const size_t BYTES = 16;
+
+    /// Encoding of each sample
+    SampleFormat format      = FLOAT32;
+    /// Number of interleaved channels
+    uint16_t     channels    = 2;
+    /// Frames per second
+    uint32_t     sample_rate = 48000;
+
+    /// @brief Bytes per sample
+    size_t sample_bytes() const { return format == INT16 ? 2 : format == INT24 ? 3 : 4; }
+
+    /// @brief Bytes per interleaved frame
+    size_t frame_bytes() const { return sample_bytes() * channels; }
+};
+
+/**
+ * @class PcmPipeSink
+ * @brief Writes a headed PCM stream to a file descriptor, typically stdout
+ *
+ * @b write copies @p data into the descriptor, as does @b commit by
+ * default. With @b Options::zero_copy, render straight into the memory
+ * returned by @b acquire and hand it over with @b commit: if the
+ * descriptor is a pipe (on Linux), the pages are attached to the pipe
+ * with `vmsplice` instead of being copied.
+ *
+ * That memory comes from a ring several times the pipe's capacity, so
+ * a region is only reused once enough data has followed it that the
+ * reader must have consumed it.
+ *
+ * @warning Zero-copy relies on the reader copying data out of the pipe
+ * (`read`). Only enable it when no later stage moves the pages on with
+ * `splice`, since the ring would then overwrite data still queued
+ * downstream.
+ */
+class PcmPipeSink {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /**
+         * @struct Options
+         * @brief Buffering for the sink
+         */
+        struct Options {
+            /// Pipe capacity to request, 0 to keep the system default
+            size_t pipe_bytes = 1 << 20;
+            /// Attach @b acquire -d memory to the pipe with `vmsplice`; see the warning above
+            bool   zero_copy  = false;
+        };
+
+        /// @brief Write @p header to @p fd
+        /// @param fd Descriptor to write to, not closed by the sink
+        /// @throws PipeRuntimeError if the header can't be written
+        PcmPipeSink(int fd, const PcmHeader& header);
+
+        /// @brief Write @p header to @p fd with @p options
+        PcmPipeSink(int fd, const PcmHeader& header, const Options& options);
+
+        ~PcmPipeSink();
+
+        PcmPipeSink(const PcmPipeSink&) = delete;
+        PcmPipeSink& operator=(const PcmPipeSink&) = delete;
+
+        /// @brief Format of the stream
+        const PcmHeader& header() const;
+
+        /// @brief Largest number of frames a single @b acquire can provide
+        size_t max_acquire() const;
+
+        /// @brief Get memory to render up to @p frames frames into
+        /// @throws PipeUserError if @p frames exceeds @b max_acquire
+        void* acquire(size_t frames);
+
+        /// @brief Send the first @p frames frames of the last @b acquire
+        /// @throws PipeRuntimeError if the reader has gone away
+        void commit(size_t frames);
+
+        /// @brief Send @p frames interleaved frames from @p data
+        /// @throws PipeRuntimeError if the reader has gone away
+        void write(const void* data, size_t frames);
+
+        /// @brief Number of frames sent so far
+        uint64_t frames_written() const;
+};
+
+/**
+ * @class PcmPipeSource
+ * @brief Reads a headed PCM stream from a file descriptor, typically stdin
+ *
+ * Reads are done in large chunks into an internal buffer, which
+ * @b peek exposes directly so a stage can process samples in place.
+ * @b forward passes the stream on to another descriptor with `splice`
+ * where possible, so a stage that only inspects a stream never copies it.
+ */
+class PcmPipeSource {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /**
+         * @struct Options
+         * @brief Buffering for the source
+         */
+        struct Options {
+            /// Size of the read buffer
+            size_t buffer_bytes = 1 << 20;
+        };
+
+        /// @brief Read and validate the header from @p fd
+        /// @param fd Descriptor to read from, not closed by the source
+        /// @throws PipeRuntimeError if the stream doesn't start with a valid header
+        explicit PcmPipeSource(int fd);
+
+        /// @brief Read the header from @p fd with @p options
+        PcmPipeSource(int fd, const Options& options);
+
+        ~PcmPipeSource();
+
+        PcmPipeSource(const PcmPipeSource&) = delete;
+        PcmPipeSource& operator=(const PcmPipeSource&) = delete;
+
+        /// @brief Format of the stream
+        const PcmHeader& header() const;
+
+        /// @brief Copy up to @p frames frames into @p data
+        /// @return Number of frames read, 0 at the end of the stream
+        size_t read(void* data, size_t frames);
+
+        /// @brief Get buffered frames without copying them
+        /// @param frames Set to the number of frames available
+        /// @return Pointer into the internal buffer, valid until the next call
+        const void* peek(size_t& frames);
+
+        /// @brief Drop @p frames frames returned by @b peek
+        void consume(size_t frames);
+
+        /// @brief Pass up to @p frames frames on to @p fd unchanged
+        /// Does not write a header; pair with a @b PcmPipeSink created on @p fd
+        /// @return Number of frames forwarded, less than @p frames at the end of the stream
+        uint64_t forward(int fd, uint64_t frames);
+
+        /// @brief Number of frames read (or forwarded) so far
+        uint64_t frames_read() const;
+};
+
+#endif // SIMPLY_PIPE_HPP_
@@ -0,0 +1,309 @@
+#include "quantizer.hpp"
+#include "memory.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(SIMPLY_SIMD_SSE) && (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SIMPLY_QUANTIZER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+static const unsigned CHUNK     = 256; // frames of planar input interleaved at a time
+static const unsigned MAX_ORDER = 9;
+
+// Error feedback filters; the noise is shaped by 1 - sum(c[k] z^-(k+1))
+static const float FIRST_ORDER[]  = {1.0f};
+static const float WANNAMAKER_3[] = {1.623f, -0.982f, 0.109f};
+static const float WANNAMAKER_9[] = {2.412f, -3.370f, 3.937f, -4.174f, 3.353f, -2.205f, 1.281f, -0.569f, 0.0847f};
+
+// ---------------------------------------------------------------------
+// --- Dither Generator --- --------------------------------------------
+// Four xorshift32 generators, one per lane
+struct Xorshift4 {
+    #ifdef SIMPLY_QUANTIZER_SSE2
+    __m128i s;
+
+    void seed(const uint32_t* lanes) {
+        s = _mm_setr_epi32(static_cast<int>(lanes[0]), static_cast<int>(lanes[1]),
+                           static_cast<int>(lanes[2]), static_cast<int>(lanes[3]));
+    }
+
+    /// Triangular noise in (-1, 1), from the two halves of one draw
+    float4 tpdf() {
+        s = _mm_xor_si128(s, _mm_slli_epi32(s, 13));
+        s = _mm_xor_si128(s, _mm_srli_epi32(s, 17));
+        s = _mm_xor_si128(s, _mm_slli_epi32(s, 5));
+        __m128 lo = _mm_cvtepi32_ps(_mm_and_si128(s, _mm_set1_epi32(0xffff)));
+        __m128 hi = _mm_cvtepi32_ps(_mm_srli_epi32(s, 16));
+        return float4(_mm_mul_ps(_mm_sub_ps(lo, hi), _mm_set1_ps(1.0f / 65536.0f)));
+    }
+    #else
+    uint32_t s[4];
+
+    void seed(const uint32_t* lanes) {
+        std::copy(lanes, lanes + 4, s);
+    }
+
+    float4 tpdf() {
+        float d[4];
+        for ( int i = 0; i < 4; i++ ) {
+            s[i] ^= s[i] << 13;
+            s[i] ^= s[i] >> 17;
+            s[i] ^= s[i] << 5;
+            d[i] = (static_cast<float>(s[i] & 0xffff) - static_cast<float>(s[i] >> 16)) * (1.0f / 65536.0f);
+        }
+        return float4::load(d);
+    }
+    #endif
+};
+
+// Convert to integers, rounding to nearest (the SSE default rounding mode)
+static void to_int(float4 x, int32_t* out) {
+    #ifdef SIMPLY_QUANTIZER_SSE2
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_cvtps_epi32(x.v));
+    #else
+    float f[4];
+    x.store(f);
+    for ( int i = 0; i < 4; i++ )
+        out[i] = static_cast<int32_t>(std::lrint(f[i]));
+    #endif
+}
+
+// Round to the nearest integer, staying in floats
+static float4 round4(float4 x) {
+    #ifdef SIMPLY_QUANTIZER_SSE2
+    return float4(_mm_cvtepi32_ps(_mm_cvtps_epi32(x.v)));
+    #else
+    float f[4];
+    x.store(f);
+    for ( int i = 0; i < 4; i++ )
+        f[i] = std::nearbyint(f[i]);
+    return float4::load(f);
+    #endif
+}
+
+static uint8_t* pack(uint8_t* dst, int32_t v, unsigned bits) {
+    dst[0] = static_cast<uint8_t>(v);
+    dst[1] = static_cast<uint8_t>(v >> 8);
+    if ( bits == 16 )
+        return dst + 2;
+    dst[2] = static_cast<uint8_t>(v >> 16);
+    if ( bits == 24 )
+        return dst + 3;
+    dst[3] = static_cast<uint8_t>(v >> 24);
+    return dst + 4;
+}
+
+// ====== Quantizer Implementation ======
+struct Quantizer::Impl {
+    unsigned               nchannels;
+    unsigned               nbits;
+    Options                opts;
+    unsigned               groups;   // of 4 channels, when shaping
+    float                  scale;    // full scale in LSBs
+    float                  lowest, highest;
+    const float*           taps  = nullptr;
+    unsigned               order = 0;
+    std::vector<Xorshift4> noise;    // one per group
+    AlignedBuffer<float>   errors;   // groups x MAX_ORDER float4, newest first
+    AlignedBuffer<float>   scratch;  // CHUNK interleaved frames of planar input
+
+    Impl(unsigned channels, unsigned bits, const Options& options):
+        nchannels(channels), nbits(bits), opts(options) {
+        if ( !channels )
+            throw QuantizerUserError("A quantizer needs at least one channel!");
+        if ( bits != 16 && bits != 24 && bits != 32 )
+            throw QuantizerUserError("Bits must be 16, 24 or 32!");
+
+        // Largest float below 2^31, so 32-bit full scale doesn't overflow
+        scale   = std::ldexp(1.0f, static_cast<int>(bits) - 1);
+        lowest  = -scale;
+        highest = bits == 32 ? 2147483520.0f : scale - 1.0f;
+        if ( bits == 32 ) {
+            opts.dither  = false;
+            opts.shaping = NONE;
+        }
+
+        switch ( opts.shaping ) {
+            case FIRST_ORDER:  taps = ::FIRST_ORDER;  order = 1; break;
+            case WANNAMAKER_3: taps = ::WANNAMAKER_3; order = 3; break;
+            case WANNAMAKER_9: taps = ::WANNAMAKER_9; order = 9; break;
+            default: break;
+        }
+
+        groups = (nchannels + 3) / 4;
+        noise.resize(groups);
+        uint32_t x = opts.seed;
+        for ( Xorshift4& g : noise ) {
+            uint32_t lanes[4];
+            for ( uint32_t& lane : lanes ) {
+                // splitmix32-style scramble; xorshift needs a non-zero state
+                x += 0x9E3779B9u;
+                uint32_t z = x;
+                z = (z ^ (z >> 16)) * 0x85EBCA6Bu;
+                z = (z ^ (z >> 13)) * 0xC2B2AE35u;
+                lane = (z ^ (z >> 16)) | 1u;
+            }
+            g.seed(lanes);
+        }
+
+        errors.allocate(static_cast<size_t>(groups) * MAX_ORDER * 4);
+        scratch.allocate(static_cast<size_t>(CHUNK) * nchannels + 4);
+    }
+
+    // Without shaping, every sample is independent: run 4 at a time
+    // through the interleaved stream
+    void convert_flat(const float* in, uint8_t* out, size_t samples) {
+        const float4 s  = float4::broadcast(scale);
+        const float4 lo = float4::broadcast(lowest);
+        const float4 hi = float4::broadcast(highest);
+        Xorshift4&   gen = noise[0];
+        int32_t      q[4];
+
+        size_t i = 0;
+        for ( ; i < samples; i += 4 ) {
+            size_t n = std::min<size_t>(4, samples - i);
+            float4 x;
+            if ( n == 4 ) {
+                x = float4::load(in + i);
+            } else {
+                float tail[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+                std::copy(in + i, in + i + n, tail);
+                x = float4::load(tail);
+            }
+            x = x * s;
+            if ( opts.dither )
+                x += gen.tpdf();
+            to_int(float4::max(lo, float4::min(hi, x)), q);
+            for ( size_t k = 0; k < n; k++ )
+                out = pack(out, q[k], nbits);
+        }
+    }
+
+    // With shaping, lane c of group g is channel 4g + c, carrying its own
+    // error history from frame to frame (kept in registers within a call)
+    template <unsigned ORDER>
+    void convert_shaped(const float* in, uint8_t* out, size_t frames) {
+        const float4 s  = float4::broadcast(scale);
+        const float4 lo = float4::broadcast(lowest);
+        const float4 hi = float4::broadcast(highest);
+        const size_t frame_bytes = static_cast<size_t>(nchannels) * (nbits / 8);
+        int32_t q[4];
+
+        float4 c[ORDER];
+        for ( unsigned k = 0; k < ORDER; k++ )
+            c[k] = float4::broadcast(taps[k]);
+
+        for ( unsigned g = 0; g < groups; g++ ) {
+            unsigned   first = g * 4;
+            unsigned   n     = std::min(4u, nchannels - first);
+            float*     saved = errors.data() + static_cast<size_t>(g) * MAX_ORDER * 4;
+            Xorshift4& gen   = noise[g];
+            uint8_t*   dst   = out + first * (nbits / 8);
+
+            float4 e[ORDER];
+            for ( unsigned k = 0; k < ORDER; k++ )
+                e[k] = float4::load_aligned(saved + 4 * k);
+
+            // Spare lanes may read the next frame's samples, which is
+            // harmless, except past the end of the input
+            const size_t samples = frames * nchannels;
+            for ( size_t f = 0; f < frames; f++ ) {
+                const float* src = in + f * nchannels + first;
+                float4 x;
+                if ( f * nchannels + first + 4 <= samples ) {
+                    x = float4::load(src);
+                } else {
+                    float lanes[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+                    std::copy(src, src + n, lanes);
+                    x = float4::load(lanes);
+                }
+
+                // w = x - sum(c[k] e[n-1-k]); y = round(w + d); e[n] = y - w
+                // The older errors are summed first, off the frame-to-frame
+                // dependency through e[0]
+                float4 w = x * s;
+                for ( unsigned k = ORDER - 1; k > 0; k-- )
+                    w = w - c[k] * e[k];
+                w = w - c[0] * e[0];
+                float4 v = w;
+                if ( opts.dither )
+                    v += gen.tpdf();
+                float4 y = round4(v);
+
+                // The error is taken before clipping, so overloads can't
+                // wind up the filter
+                for ( unsigned k = ORDER - 1; k > 0; k-- )
+                    e[k] = e[k - 1];
+                e[0] = y - w;
+
+                to_int(float4::max(lo, float4::min(hi, y)), q);
+                uint8_t* p = dst + f * frame_bytes;
+                for ( unsigned k = 0; k < n; k++ )
+                    p = pack(p, q[k], nbits);
+            }
+
+            for ( unsigned k = 0; k < ORDER; k++ )
+                e[k].store_aligned(saved + 4 * k);
+        }
+    }
+
+    void convert(const float* in, uint8_t* out, size_t frames) {
+        switch ( order ) {
+            case 1:  convert_shaped<1>(in, out, frames); break;
+            case 3:  convert_shaped<3>(in, out, frames); break;
+            case 9:  convert_shaped<9>(in, out, frames); break;
+            default: convert_flat(in, out, frames * nchannels); break;
+        }
+    }
+
+    void process(const float* const* in, uint8_t* out, size_t frames) {
+        size_t frame_bytes = static_cast<size_t>(nchannels) * (nbits / 8);
+        size_t done = 0;
+        while ( done < frames ) {
+            size_t n   = std::min<size_t>(frames - done, CHUNK);
+            float* dst = scratch.data();
+            for ( size_t f = 0; f < n; f++ )
+                for ( unsigned ch = 0; ch < nchannels; ch++ )
+                    *dst++ = in[ch][done + f];
+            convert(scratch.data(), out + done * frame_bytes, n);
+            done += n;
+        }
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- Quantizer Class Methods --- -------------------------------------
+Quantizer::Quantizer(unsigned channels, unsigned bits): Quantizer(channels, bits, Options()) {}
+
+Quantizer::Quantizer(unsigned channels, unsigned bits, const Options& options):
+    pimpl(new Impl(channels, bits, options)) {}
+
+Quantizer::~Quantizer() = default;
+
+unsigned Quantizer::channels() const {
+    return pimpl->nchannels;
+}
+
+unsigned Quantizer::bits() const {
+    return pimpl->nbits;
+}
+
+size_t Quantizer::frame_bytes() const {
+    return static_cast<size_t>(pimpl->nchannels) * (pimpl->nbits / 8);
+}
+
+void Quantizer::process(const float* in, void* out, size_t frames) {
+    pimpl->convert(in, static_cast<uint8_t*>(out), frames);
+}
+
+void Quantizer::process(const float* const* in, void* out, size_t frames) {
+    pimpl->process(in, static_cast<uint8_t*>(out), frames);
+}
+
+void Quantizer::reset() {
+    pimpl->errors.zero();
+}
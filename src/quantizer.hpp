@@ -0,0 +1,124 @@
+/**
+ * @file quantizer.hpp
+ * @brief Provides @b Quantizer, dithered float to integer PCM conversion
+ */
+#ifndef SIMPLY_QUANTIZER_HPP_
+#define SIMPLY_QUANTIZER_HPP_
+
+#include <string>
+#include <exception>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class QuantizerException
+ * @brief This is the base class of all exceptions thrown by @b Quantizer
+ */
+class QuantizerException: public std::exception {
+    protected:
+        std::string msg;
+        explicit QuantizerException(const std::string& msg): msg(msg) {}
+
+    public:
+        /// @brief Get a message describing the error
+        /// @return NULL-terminated c-string
+        const char* what() const noexcept override { return msg.c_str(); }
+};
+
+/**
+ * @class QuantizerUserError
+ * @brief This means the channel count or bit depth was invalid
+ */
+class QuantizerUserError: public QuantizerException {
+    public:
+        explicit QuantizerUserError(const std::string& msg): QuantizerException("QuantizerUserError: " + msg) {}
+};
+
+/**
+ * @class Quantizer
+ * @brief Converts float samples to 16, 24 or 32-bit integer PCM with dither and noise shaping
+ *
+ * Samples are scaled, dithered, noise-shaped, rounded, clipped and packed
+ * little-endian (as in WAV files and @b PcmHeader streams) in one pass,
+ * so the data is only touched once.
+ *
+ * Dither is TPDF (triangular, 2 LSB peak to peak), from xorshift
+ * generators running in 4 independent SIMD lanes. Noise shaping feeds the
+ * quantization error back through a short filter, moving the noise out of
+ * the band where hearing is most sensitive. Without shaping the samples are
+ * processed 4 at a time regardless of channel count; with shaping each
+ * channel has its own error history in its own lane, as in @b BiquadCascade.
+ *
+ * At 32 bits the float input has less resolution than the output, so
+ * dither and shaping are skipped.
+ *
+ * @note Each @b Quantizer keeps per-channel state, so use one per stream
+ */
+class Quantizer {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /**
+         * @enum Shaping
+         * @brief Noise shaping filter
+         */
+        enum Shaping {
+            /// Flat (white) dither and quantization noise
+            NONE,
+            /// First-order highpass, (1 - z^-1)
+            FIRST_ORDER,
+            /// Wannamaker's 3-tap psychoacoustic filter, designed at 44.1 kHz
+            WANNAMAKER_3,
+            /// Wannamaker's 9-tap psychoacoustic filter, designed at 44.1 kHz
+            WANNAMAKER_9
+        };
+
+        /**
+         * @struct Options
+         * @brief Dither and noise shaping
+         */
+        struct Options {
+            /// Add TPDF dither before rounding
+            bool     dither  = true;
+            /// Noise shaping filter
+            Shaping  shaping = NONE;
+            /// Seed of the dither generators
+            uint32_t seed    = 1;
+        };
+
+        /// @brief Quantizer for @p channels interleaved channels to @p bits bits
+        /// @throws QuantizerUserError if @p channels is 0 or @p bits not 16, 24 or 32
+        Quantizer(unsigned channels, unsigned bits);
+
+        /// @brief Create with @p options
+        Quantizer(unsigned channels, unsigned bits, const Options& options);
+
+        ~Quantizer();
+
+        Quantizer(const Quantizer&) = delete;
+        Quantizer& operator=(const Quantizer&) = delete;
+
+        /// @brief Number of channels
+        unsigned channels() const;
+
+        /// @brief Bits per output sample
+        unsigned bits() const;
+
+        /// @brief Bytes per interleaved output frame
+        size_t frame_bytes() const;
+
+        /// @brief Convert @p frames interleaved float frames (full scale ±1.0) into @p out
+        /// @param out Room for @p frames * @b frame_bytes bytes
+        void process(const float* in, void* out, size_t frames);
+
+        /// @brief Convert @p frames frames of planar channels into interleaved @p out
+        void process(const float* const* in, void* out, size_t frames);
+
+        /// @brief Clear the noise shaping history
+        void reset();
+};
+
+#endif // SIMPLY_QUANTIZER_HPP_
@@ -0,0 +1,206 @@
+#include "resampler.hpp"
+#include "memory.hpp"
+#include "simd.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <string>
+
+// ---------------------------------------------------------------------
+// --- Filter Design --- -----------------------------------------------
+static const double PI = 3.14159265358979323846;
+
+// Biggest polyphase table allowed, in coefficients
+static const uint64_t MAX_TABLE = 1 << 24;
+
+struct QualityPreset {
+    unsigned taps;   // per phase when upsampling
+    double   beta;   // Kaiser window shape
+    double   cutoff; // fraction of the lower Nyquist frequency
+};
+
+static const QualityPreset PRESETS[] = {
+    {  16,  5.10, 0.80 }, // FAST
+    {  32,  6.76, 0.87 }, // MEDIUM
+    {  64,  8.96, 0.92 }, // HIGH
+    { 128, 11.16, 0.95 }  // BEST
+};
+
+static uint32_t gcd(uint32_t a, uint32_t b) {
+    while ( b ) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Zeroth-order modified Bessel function of the first kind
+static double bessel_i0(double x) {
+    double sum  = 1.0;
+    double term = 1.0;
+    for ( int k = 1; k < 64; k++ ) {
+        double f = x / (2.0 * k);
+        term *= f * f;
+        sum  += term;
+        if ( term < sum * 1e-17 )
+            break;
+    }
+    return sum;
+}
+
+// ====== Resampler Implementation ======
+struct Resampler::Impl {
+    uint32_t             up;   // L
+    uint32_t             down; // M
+    unsigned             nchannels;
+    unsigned             ntaps;
+
+    // Phase p's taps are coefs[p * ntaps ...], stored oldest-sample-first
+    // so they line up with the history window
+    AlignedBuffer<float> coefs;
+
+    // Per channel: the last ntaps inputs, written twice (at pos and
+    // pos + ntaps) so a full window always starts at history + pos
+    AlignedBuffer<float> history;
+    unsigned             pos   = 0;
+    uint32_t             phase = 0;
+
+    Impl(uint32_t in_rate, uint32_t out_rate, unsigned channels, Quality quality): nchannels(channels) {
+        if ( !in_rate || !out_rate )
+            throw ResamplerUserError("Sample rates must be non-zero!");
+        if ( !channels )
+            throw ResamplerUserError("Need at least one channel!");
+        if ( quality < FAST || quality > BEST )
+            throw ResamplerUserError("Unknown quality preset!");
+
+        uint32_t g = gcd(in_rate, out_rate);
+        up   = out_rate / g;
+        down = in_rate / g;
+        if ( up > MAX_PHASES )
+            throw ResamplerUserError(
+                "Ratio " + std::to_string(out_rate) + "/" + std::to_string(in_rate) +
+                " reduces to " + std::to_string(up) + "/" + std::to_string(down) +
+                ", which needs more than " + std::to_string(MAX_PHASES) + " phases!"
+            );
+
+        const QualityPreset& preset = PRESETS[quality];
+        double taps = preset.taps;
+        if ( down > up )
+            taps *= static_cast<double>(down) / up;
+        ntaps = (static_cast<unsigned>(std::ceil(taps)) + 3) & ~3u;
+        if ( static_cast<uint64_t>(ntaps) * up > MAX_TABLE )
+            throw ResamplerUserError("Downsampling ratio too large for the filter table!");
+
+        design(preset);
+        history.allocate(static_cast<size_t>(nchannels) * 2 * ntaps);
+    }
+
+    void design(const QualityPreset& preset) {
+        size_t length = static_cast<size_t>(up) * ntaps;
+        double center = (length - 1) / 2.0;
+        double fc     = preset.cutoff * 0.5 / std::max(up, down); // cycles per upsampled sample
+        double norm   = bessel_i0(preset.beta);
+
+        std::unique_ptr<double[]> h(new double[length]);
+        double total = 0.0;
+        for ( size_t n = 0; n < length; n++ ) {
+            double t    = n - center;
+            double x    = 2.0 * fc * t;
+            double sinc = t == 0.0 ? 1.0 : std::sin(PI * x) / (PI * x);
+            double r    = t / center;
+            double win  = bessel_i0(preset.beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / norm;
+            h[n]   = 2.0 * fc * sinc * win;
+            total += h[n];
+        }
+
+        // Unity gain at DC through every phase
+        double scale = up / total;
+        coefs.allocate(length);
+        for ( uint32_t p = 0; p < up; p++ )
+            for ( unsigned j = 0; j < ntaps; j++ )
+                coefs[p * ntaps + j] = static_cast<float>(h[p + static_cast<size_t>(ntaps - 1 - j) * up] * scale);
+    }
+
+    size_t output_frames(size_t in_frames) const {
+        uint64_t span = static_cast<uint64_t>(in_frames) * up;
+        if ( span <= phase )
+            return 0;
+        return static_cast<size_t>((span - phase + down - 1) / down);
+    }
+
+    size_t input_frames(size_t out_frames) const {
+        if ( !out_frames )
+            return 0;
+        return static_cast<size_t>((phase + static_cast<uint64_t>(out_frames - 1) * down) / up + 1);
+    }
+
+    size_t process(const float* const* in, size_t in_frames, float* const* out) {
+        size_t   produced = 0;
+        unsigned end_pos  = pos;
+        uint32_t end_phase = phase;
+
+        for ( unsigned ch = 0; ch < nchannels; ch++ ) {
+            const float* src = in[ch];
+            float*       dst = out[ch];
+            float*       buf = history.data() + static_cast<size_t>(ch) * 2 * ntaps;
+            unsigned     w   = pos;
+            uint32_t     p   = phase;
+            size_t       n   = 0;
+
+            for ( size_t i = 0; i < in_frames; i++ ) {
+                buf[w] = buf[w + ntaps] = src[i];
+                if ( ++w == ntaps )
+                    w = 0;
+                for ( ; p < up; p += down )
+                    dst[n++] = simd_dot(coefs.data() + static_cast<size_t>(p) * ntaps, buf + w, ntaps);
+                p -= up;
+            }
+
+            produced  = n;
+            end_pos   = w;
+            end_phase = p;
+        }
+
+        pos   = end_pos;
+        phase = end_phase;
+        return produced;
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- Resampler Class Methods --- -------------------------------------
+Resampler::Resampler(uint32_t in_rate, uint32_t out_rate, unsigned channels, Quality quality):
+    pimpl(new Impl(in_rate, out_rate, channels, quality)) {}
+
+Resampler::~Resampler() = default;
+
+unsigned Resampler::channels() const {
+    return pimpl->nchannels;
+}
+
+unsigned Resampler::taps() const {
+    return pimpl->ntaps;
+}
+
+double Resampler::latency() const {
+    return (static_cast<double>(pimpl->up) * pimpl->ntaps - 1) / (2.0 * pimpl->up);
+}
+
+size_t Resampler::output_frames(size_t in_frames) const {
+    return pimpl->output_frames(in_frames);
+}
+
+size_t Resampler::input_frames(size_t out_frames) const {
+    return pimpl->input_frames(out_frames);
+}
+
+size_t Resampler::process(const float* const* in, size_t in_frames, float* const* out) {
+    return pimpl->process(in, in_frames, out);
+}
+
+void Resampler::reset() {
+    pimpl->history.zero();
+    pimpl->pos   = 0;
+    pimpl->phase = 0;
+}
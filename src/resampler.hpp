@@ -0,0 +1,111 @@
+/**
+ * @file resampler.hpp
+ * @brief Provides @b Resampler for streaming sample rate conversion
+ */
+#ifndef SIMPLY_RESAMPLER_HPP_
+#define SIMPLY_RESAMPLER_HPP_
+
+#include <string>
+#include <exception>
+#include <memory>
+#include <cstdint>
+
+/**
+ * @class ResamplerException
+ * @brief This is the base class of all exceptions thrown by @b Resampler
+ */
+class ResamplerException: public std::exception {
+    protected:
+        std::string msg;
+        explicit ResamplerException(const std::string& msg): msg(msg) {}
+
+    public:
+        /// @brief Get a message describing the error
+        /// @return NULL-terminated c-string
+        const char* what() const noexcept override { return msg.c_str(); }
+};
+
+/**
+ * @class ResamplerUserError
+ * @brief This means the rates/options requested are not supported
+ */
+class ResamplerUserError: public ResamplerException {
+    public:
+        explicit ResamplerUserError(const std::string& msg): ResamplerException("ResamplerUserError: " + msg) {}
+};
+
+/**
+ * @class Resampler
+ * @brief Converts planar float streams between two fixed sample rates
+ *
+ * The ratio is reduced to L/M (48000/44100 becomes 160/147) and the
+ * stream is upsampled by L, low-pass filtered and downsampled by M in
+ * one step: each output sample is the dot product of one of L
+ * precomputed Kaiser-windowed sinc phases with the latest input.
+ *
+ * All buffers are allocated by the constructor, so @b process is safe
+ * to call from a real-time thread.
+ */
+class Resampler {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /**
+         * @enum Quality
+         * @brief Trades filter length (taps per output sample) for CPU time
+         *
+         * Cutoffs are relative to the lower of the two Nyquist frequencies.
+         * When downsampling, the taps are scaled up by the ratio to keep
+         * the transition band the same width relative to the output rate.
+         */
+        enum Quality {
+            /// 16 taps, ~55 dB stopband, cutoff at 80% of Nyquist
+            FAST,
+            /// 32 taps, ~70 dB stopband, cutoff at 87% of Nyquist
+            MEDIUM,
+            /// 64 taps, ~90 dB stopband, cutoff at 92% of Nyquist
+            HIGH,
+            /// 128 taps, ~110 dB stopband, cutoff at 95% of Nyquist
+            BEST
+        };
+
+        /// @brief Largest L (output rate / gcd of the rates) supported
+        static const uint32_t MAX_PHASES = 4096;
+
+        /// @brief Prepare to convert @p channels channels from @p in_rate to @p out_rate
+        /// @throws ResamplerUserError if a rate is 0 or the reduced ratio needs more than @b MAX_PHASES phases
+        Resampler(uint32_t in_rate, uint32_t out_rate, unsigned channels, Quality quality=HIGH);
+
+        ~Resampler();
+
+        Resampler(const Resampler&) = delete;
+        Resampler& operator=(const Resampler&) = delete;
+
+        /// @brief Number of channels
+        unsigned channels() const;
+
+        /// @brief Taps evaluated per output sample
+        unsigned taps() const;
+
+        /// @brief Delay of the filter, in input frames
+        double latency() const;
+
+        /// @brief Exact number of frames @b process produces from @p in_frames more input
+        size_t output_frames(size_t in_frames) const;
+
+        /// @brief Smallest input for which @b process produces at least @p out_frames frames
+        /// Use from a pull-style callback that must fill a fixed number of frames
+        size_t input_frames(size_t out_frames) const;
+
+        /// @brief Convert @p in_frames frames from each channel of @p in
+        /// @param out One buffer per channel, each with room for @b output_frames(in_frames)
+        /// @return Number of frames written to each channel of @p out
+        size_t process(const float* const* in, size_t in_frames, float* const* out);
+
+        /// @brief Clear the filter history, as if newly constructed
+        void reset();
+};
+
+#endif // SIMPLY_RESAMPLER_HPP_
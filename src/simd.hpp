@@ -0,0 +1,218 @@
+/**
+ * @file simd.hpp
+ * @brief Provides @b float4, a thin 4-lane float vector used by the DSP kernels
+ *
+ * Maps onto SSE where available (all x86-64 targets) and falls back to
+ * plain arrays elsewhere, which compilers still auto-vectorize well.
+ * Loads and stores are unaligned unless named otherwise.
+ */
+#ifndef SIMPLY_SIMD_HPP_
+#define SIMPLY_SIMD_HPP_
+
+#include <cstddef>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SIMPLY_SIMD_SSE 1
+#include <xmmintrin.h>
+#endif
+
+// GCC and Clang define __FMA__ only when FMA is enabled (AVX2 alone doesn't
+// imply it); MSVC never defines it, but its /arch:AVX2 does include FMA
+#if defined(SIMPLY_SIMD_SSE) && (defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__)))
+#define SIMPLY_SIMD_FMA 1
+#include <immintrin.h>
+#endif
+
+/**
+ * @struct float4
+ * @brief Four floats processed together
+ */
+struct float4 {
+    #ifdef SIMPLY_SIMD_SSE
+    __m128 v;
+
+    float4() = default;
+    explicit float4(__m128 v): v(v) {}
+
+    static float4 zero()                  { return float4(_mm_setzero_ps()); }
+    static float4 broadcast(float x)      { return float4(_mm_set1_ps(x)); }
+    static float4 set(float a, float b, float c, float d) { return float4(_mm_setr_ps(a, b, c, d)); }
+    static float4 load(const float* p)    { return float4(_mm_loadu_ps(p)); }
+    static float4 load_aligned(const float* p) { return float4(_mm_load_ps(p)); }
+    void store(float* p) const            { _mm_storeu_ps(p, v); }
+    void store_aligned(float* p) const    { _mm_store_ps(p, v); }
+
+    friend float4 operator+(float4 a, float4 b) { return float4(_mm_add_ps(a.v, b.v)); }
+    friend float4 operator-(float4 a, float4 b) { return float4(_mm_sub_ps(a.v, b.v)); }
+    friend float4 operator*(float4 a, float4 b) { return float4(_mm_mul_ps(a.v, b.v)); }
+
+    /// @brief Lane-wise absolute value
+    float4 abs() const { return float4(_mm_andnot_ps(_mm_set1_ps(-0.0f), v)); }
+
+    /// @brief Lane-wise maximum
+    static float4 max(float4 a, float4 b) { return float4(_mm_max_ps(a.v, b.v)); }
+
+    /// @brief Lane-wise minimum
+    static float4 min(float4 a, float4 b) { return float4(_mm_min_ps(a.v, b.v)); }
+
+    /// @brief Lanes (1, 0, 3, 2), i.e. re/im swapped for two interleaved complex values
+    float4 swap_pairs() const { return float4(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1))); }
+
+    /// @brief Lanes (0, 0, 2, 2), i.e. the real parts of two interleaved complex values
+    float4 dup_even() const { return float4(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 0, 0))); }
+
+    /// @brief Lanes (1, 1, 3, 3), i.e. the imaginary parts of two interleaved complex values
+    float4 dup_odd() const { return float4(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 1, 1))); }
+
+    /// @brief Lanes (0, v0, v1, v2), i.e. shifted one lane later in time
+    float4 shift1() const { return float4(_mm_move_ss(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 1, 0, 0)), _mm_setzero_ps())); }
+
+    /// @brief Lanes (0, 0, v0, v1)
+    float4 shift2() const { return float4(_mm_movelh_ps(_mm_setzero_ps(), v)); }
+
+    /// @brief Lane 3 in every lane
+    float4 dup_last() const { return float4(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))); }
+
+    /// @brief Sum of the four lanes
+    float sum() const {
+        __m128 hi  = _mm_movehl_ps(v, v);
+        __m128 s   = _mm_add_ps(v, hi);
+        __m128 odd = _mm_shuffle_ps(s, s, 0x55);
+        return _mm_cvtss_f32(_mm_add_ss(s, odd));
+    }
+    #else
+    float v[4];
+
+    static float4 zero()                  { return broadcast(0.0f); }
+    static float4 broadcast(float x)      { float4 r; for ( int i = 0; i < 4; i++ ) r.v[i] = x; return r; }
+    static float4 set(float a, float b, float c, float d) { float4 r; r.v[0] = a; r.v[1] = b; r.v[2] = c; r.v[3] = d; return r; }
+    static float4 load(const float* p)    { float4 r; for ( int i = 0; i < 4; i++ ) r.v[i] = p[i]; return r; }
+    static float4 load_aligned(const float* p) { return load(p); }
+    void store(float* p) const            { for ( int i = 0; i < 4; i++ ) p[i] = v[i]; }
+    void store_aligned(float* p) const    { store(p); }
+
+    friend float4 operator+(float4 a, float4 b) { for ( int i = 0; i < 4; i++ ) a.v[i] += b.v[i]; return a; }
+    friend float4 operator-(float4 a, float4 b) { for ( int i = 0; i < 4; i++ ) a.v[i] -= b.v[i]; return a; }
+    friend float4 operator*(float4 a, float4 b) { for ( int i = 0; i < 4; i++ ) a.v[i] *= b.v[i]; return a; }
+
+    /// @brief Lane-wise absolute value
+    float4 abs() const { float4 r; for ( int i = 0; i < 4; i++ ) r.v[i] = v[i] < 0.0f ? -v[i] : v[i]; return r; }
+
+    /// @brief Lane-wise maximum
+    static float4 max(float4 a, float4 b) { for ( int i = 0; i < 4; i++ ) a.v[i] = a.v[i] < b.v[i] ? b.v[i] : a.v[i]; return a; }
+
+    /// @brief Lane-wise minimum
+    static float4 min(float4 a, float4 b) { for ( int i = 0; i < 4; i++ ) a.v[i] = b.v[i] < a.v[i] ? b.v[i] : a.v[i]; return a; }
+
+    /// @brief Lanes (1, 0, 3, 2), i.e. re/im swapped for two interleaved complex values
+    float4 swap_pairs() const { return set(v[1], v[0], v[3], v[2]); }
+
+    /// @brief Lanes (0, 0, 2, 2), i.e. the real parts of two interleaved complex values
+    float4 dup_even() const { return set(v[0], v[0], v[2], v[2]); }
+
+    /// @brief Lanes (1, 1, 3, 3), i.e. the imaginary parts of two interleaved complex values
+    float4 dup_odd() const { return set(v[1], v[1], v[3], v[3]); }
+
+    /// @brief Lanes (0, v0, v1, v2), i.e. shifted one lane later in time
+    float4 shift1() const { return set(0.0f, v[0], v[1], v[2]); }
+
+    /// @brief Lanes (0, 0, v0, v1)
+    float4 shift2() const { return set(0.0f, 0.0f, v[0], v[1]); }
+
+    /// @brief Lane 3 in every lane
+    float4 dup_last() const { return broadcast(v[3]); }
+
+    /// @brief Sum of the four lanes
+    float sum() const { return (v[0] + v[2]) + (v[1] + v[3]); }
+    #endif
+
+    float4& operator+=(float4 b) { return *this = *this + b; }
+    float4& operator*=(float4 b) { return *this = *this * b; }
+
+    /// @brief @p a * @p b + @p c
+    static float4 mul_add(float4 a, float4 b, float4 c) { return a * b + c; }
+
+    /// @brief @p a * @p b + @p c, fused (rounded once) where the target has FMA
+    /// @note Results then depend on the build flags, so this is opt-in per kernel rather than what @b mul_add does.
+    ///       GCC and Clang fuse plain `a * b + c` too unless built with `-ffp-contract=off`, which the
+    ///       CMake target passes on to its users
+    #ifdef SIMPLY_SIMD_FMA
+    static float4 fused_mul_add(float4 a, float4 b, float4 c) { return float4(_mm_fmadd_ps(a.v, b.v, c.v)); }
+    #else
+    static float4 fused_mul_add(float4 a, float4 b, float4 c) { return a * b + c; }
+    #endif
+
+    /// @brief Largest of the four lanes
+    float max_lane() const {
+        float lanes[4];
+        store(lanes);
+        float a = lanes[0] < lanes[1] ? lanes[1] : lanes[0];
+        float b = lanes[2] < lanes[3] ? lanes[3] : lanes[2];
+        return a < b ? b : a;
+    }
+};
+
+/**
+ * @class DenormalGuard
+ * @brief Flushes denormals to zero on this thread while in scope
+ *
+ * Recursive filters decaying towards silence produce denormal numbers,
+ * which are many times slower to compute with on x86. Put one of these
+ * at the top of a processing function.
+ */
+class DenormalGuard {
+    private:
+        #ifdef SIMPLY_SIMD_SSE
+        unsigned int saved;
+
+    public:
+        DenormalGuard(): saved(_mm_getcsr()) { _mm_setcsr(saved | 0x8040); } // FTZ | DAZ
+        ~DenormalGuard() { _mm_setcsr(saved); }
+        #else
+    public:
+        DenormalGuard() {}
+        #endif
+
+        DenormalGuard(const DenormalGuard&) = delete;
+        DenormalGuard& operator=(const DenormalGuard&) = delete;
+};
+
+/// @brief Dot product of @p a and @p b, fastest when @p n is a multiple of 8
+inline float simd_dot(const float* a, const float* b, size_t n) {
+    float4 acc0 = float4::zero();
+    float4 acc1 = float4::zero();
+    size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 ) {
+        acc0 = float4::mul_add(float4::load(a + i), float4::load(b + i), acc0);
+        acc1 = float4::mul_add(float4::load(a + i + 4), float4::load(b + i + 4), acc1);
+    }
+    if ( i + 4 <= n ) {
+        acc0 = float4::mul_add(float4::load(a + i), float4::load(b + i), acc0);
+        i += 4;
+    }
+    float sum = (acc0 + acc1).sum();
+    for ( ; i < n; i++ )
+        sum += a[i] * b[i];
+    return sum;
+}
+
+/// @brief Transpose the 4x4 matrix whose rows are @p r0 .. @p r3
+inline void transpose4(float4& r0, float4& r1, float4& r2, float4& r3) {
+    #ifdef SIMPLY_SIMD_SSE
+    _MM_TRANSPOSE4_PS(r0.v, r1.v, r2.v, r3.v);
+    #else
+    float4 c0 = float4::set(r0.v[0], r1.v[0], r2.v[0], r3.v[0]);
+    float4 c1 = float4::set(r0.v[1], r1.v[1], r2.v[1], r3.v[1]);
+    float4 c2 = float4::set(r0.v[2], r1.v[2], r2.v[2], r3.v[2]);
+    float4 c3 = float4::set(r0.v[3], r1.v[3], r2.v[3], r3.v[3]);
+    r0 = c0; r1 = c1; r2 = c2; r3 = c3;
+    #endif
+}
+
+/// @brief Multiply two pairs of interleaved complex values, @p a * @p b
+inline float4 complex_mul(float4 a, float4 b) {
+    float4 cross = a.swap_pairs() * b.dup_odd() * float4::set(-1.0f, 1.0f, -1.0f, 1.0f);
+    return float4::mul_add(a, b.dup_even(), cross);
+}
+
+#endif // SIMPLY_SIMD_HPP_
@@ -137,6 +137,13 @@ struct Thread::Impl {
                 throw ThreadRuntimeError("Failed to set priority...");
         }
 
+        void set_affinity(uint64_t mask) {
+            if ( completed() )
+                throw ThreadExited("Thread already completed!");
+            if ( !SetThreadAffinityMask(thread, static_cast<DWORD_PTR>(mask)) )
+                throw ThreadRuntimeError("Failed to set affinity...");
+        }
+
         void start() {
             if ( context->started )
                 throw ThreadUserError("Cannot start thread more than once!");
@@ -279,6 +286,12 @@ void Thread::set_priority(Priority priority) {
     pimpl->set_priority(priority);
 }
 
+void Thread::set_affinity(uint64_t mask) {
+    if ( !pimpl )
+        throw ThreadUserError("Cannot set affinity without a thread!");
+    pimpl->set_affinity(mask);
+}
+
 void Thread::start() {
     if ( !pimpl )
         throw ThreadUserError("Cannot start without a thread!");
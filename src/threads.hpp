@@ -8,6 +8,7 @@
 #include <string>
 #include <exception>
 #include <memory>
+#include <cstdint>
 
 /// @typedef callback_t
 /// @brief The method that is called by the thread
@@ -67,7 +68,6 @@ class ThreadExited: ThreadException {
  * @todo Consider how to add the following
  * - Suspend / resume
  * - Sleep / switch / yield
- * - Affinity (which CPUs to use)
  * - Thread ID
  * - Process priority/name/ID/etc.
  * - Thread status (kernel/user time, etc.)
@@ -131,6 +131,11 @@ class Thread {
         /// @brief Set the thread priority
         void set_priority(Priority priority);
 
+        /// @brief Restrict the thread to the CPUs whose bits are set in @p mask
+        /// @note Only the first 64 CPUs (the first processor group on Windows) can be selected
+        /// @throws ThreadRuntimeError if no CPU in @p mask is available
+        void set_affinity(uint64_t mask);
+
         /// @brief Start the created thread
         void start();
 
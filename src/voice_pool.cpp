@@ -0,0 +1,227 @@
+#include "voice_pool.hpp"
+#include "memory.hpp"
+
+#include <algorithm>
+#include <vector>
+
+static const uint32_t NO_INDEX = UINT32_MAX;
+
+// ====== VoicePool Implementation ======
+// Slots are fixed homes that handles name; entries are positions in the
+// dense arrays. Each slot records its entry and each entry its slot, so
+// moving a voice between entries is two writes besides its fields.
+// Active slots are also linked in claim order, so the oldest voice is
+// the head of that list rather than the result of a search
+struct VoicePool::Impl {
+    unsigned              cap;
+    unsigned              nfields;
+    Options               opts;
+    size_t                stride;      // floats per array, a multiple of 4
+    AlignedBuffer<float>  data;        // fields, then levels, stride apart
+    std::vector<uint32_t> slot_of;     // per entry
+    std::vector<uint32_t> index_of;    // per slot, NO_INDEX if free
+    std::vector<uint32_t> generation;  // per slot, bumped on every claim
+    std::vector<uint32_t> free_slots;  // stack
+    std::vector<uint32_t> older;       // per slot, previous in claim order
+    std::vector<uint32_t> newer;       // per slot, next in claim order
+    uint32_t              oldest = NO_INDEX;
+    uint32_t              newest = NO_INDEX;
+    unsigned              count  = 0;
+
+    Impl(unsigned capacity, unsigned fields, const Options& options):
+        cap(capacity), nfields(fields), opts(options) {
+        if ( !capacity )
+            throw VoicePoolUserError("Capacity must be at least 1!");
+        stride = (static_cast<size_t>(capacity) + 3) & ~static_cast<size_t>(3);
+        data.allocate((nfields + 1) * stride);
+        slot_of.resize(capacity, 0);
+        index_of.resize(capacity, NO_INDEX);
+        generation.resize(capacity, 0);
+        older.resize(capacity, NO_INDEX);
+        newer.resize(capacity, NO_INDEX);
+        free_slots.reserve(capacity);
+        for ( unsigned s = capacity; s-- > 0; )
+            free_slots.push_back(s);
+    }
+
+    float* array(unsigned f) { return data.data() + f * stride; }
+
+    float* level() { return array(nfields); }
+
+    static Handle make(uint32_t slot, uint32_t gen) { return (static_cast<Handle>(gen) << 32) | slot; }
+
+    uint32_t lookup(Handle voice) const {
+        uint32_t slot = static_cast<uint32_t>(voice);
+        uint32_t gen  = static_cast<uint32_t>(voice >> 32);
+        if ( slot >= cap || !gen || generation[slot] != gen )
+            return NO_INDEX;
+        return index_of[slot];
+    }
+
+    void link(uint32_t slot) {
+        older[slot] = newest;
+        newer[slot] = NO_INDEX;
+        if ( newest != NO_INDEX )
+            newer[newest] = slot;
+        else
+            oldest = slot;
+        newest = slot;
+    }
+
+    void unlink(uint32_t slot) {
+        if ( older[slot] != NO_INDEX )
+            newer[older[slot]] = newer[slot];
+        else
+            oldest = newer[slot];
+        if ( newer[slot] != NO_INDEX )
+            older[newer[slot]] = older[slot];
+        else
+            newest = older[slot];
+    }
+
+    // Fills entry i from the last active one
+    void remove(uint32_t i) {
+        unlink(slot_of[i]);
+        index_of[slot_of[i]] = NO_INDEX;
+        free_slots.push_back(slot_of[i]);
+        uint32_t last = --count;
+        if ( i != last ) {
+            for ( unsigned f = 0; f <= nfields; f++ )
+                array(f)[i] = array(f)[last];
+            slot_of[i]           = slot_of[last];
+            index_of[slot_of[i]] = i;
+        }
+    }
+
+    uint32_t victim() {
+        if ( opts.stealing == OLDEST )
+            return index_of[oldest];
+        // Levels change every block, so the quietest has to be searched for
+        uint32_t     v = 0;
+        const float* l = level();
+        for ( uint32_t i = 1; i < count; i++ )
+            if ( l[i] < l[v] )
+                v = i;
+        return v;
+    }
+
+    Handle claim(Handle* stolen) {
+        if ( stolen )
+            *stolen = 0;
+        if ( free_slots.empty() ) {
+            if ( opts.stealing == NO_STEALING )
+                return 0;
+            uint32_t v = victim();
+            if ( stolen )
+                *stolen = make(slot_of[v], generation[slot_of[v]]);
+            remove(v);
+        }
+
+        uint32_t slot = free_slots.back();
+        free_slots.pop_back();
+        if ( !++generation[slot] )
+            generation[slot] = 1; // 0 would make the handle look free
+        uint32_t i     = count++;
+        index_of[slot] = i;
+        slot_of[i]     = slot;
+        link(slot);
+        for ( unsigned f = 0; f <= nfields; f++ )
+            array(f)[i] = 0.0f;
+        return make(slot, generation[slot]);
+    }
+
+    unsigned release_below(float threshold) {
+        unsigned     released = 0;
+        const float* l        = level();
+        for ( uint32_t i = 0; i < count; ) {
+            if ( l[i] < threshold ) {
+                remove(i); // the entry now holds another voice to check
+                released++;
+            } else {
+                i++;
+            }
+        }
+        return released;
+    }
+
+    void clear() {
+        while ( count )
+            remove(count - 1);
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- VoicePool Class Methods --- -------------------------------------
+VoicePool::VoicePool(unsigned capacity, unsigned fields):
+    VoicePool(capacity, fields, Options()) {}
+
+VoicePool::VoicePool(unsigned capacity, unsigned fields, const Options& options):
+    pimpl(new Impl(capacity, fields, options)) {}
+
+VoicePool::~VoicePool() = default;
+
+unsigned VoicePool::capacity() const {
+    return pimpl->cap;
+}
+
+unsigned VoicePool::fields() const {
+    return pimpl->nfields;
+}
+
+unsigned VoicePool::active() const {
+    return pimpl->count;
+}
+
+VoicePool::Handle VoicePool::claim(Handle* stolen) {
+    return pimpl->claim(stolen);
+}
+
+bool VoicePool::release(Handle voice) {
+    uint32_t i = pimpl->lookup(voice);
+    if ( i == NO_INDEX )
+        return false;
+    pimpl->remove(i);
+    return true;
+}
+
+unsigned VoicePool::release_below(float threshold) {
+    return pimpl->release_below(threshold);
+}
+
+void VoicePool::clear() {
+    pimpl->clear();
+}
+
+bool VoicePool::valid(Handle voice) const {
+    return pimpl->lookup(voice) != NO_INDEX;
+}
+
+int VoicePool::index(Handle voice) const {
+    uint32_t i = pimpl->lookup(voice);
+    return i == NO_INDEX ? -1 : static_cast<int>(i);
+}
+
+VoicePool::Handle VoicePool::handle(unsigned index) const {
+    uint32_t slot = pimpl->slot_of[index];
+    return Impl::make(slot, pimpl->generation[slot]);
+}
+
+float* VoicePool::field(unsigned f) {
+    if ( f >= pimpl->nfields )
+        throw VoicePoolUserError("Field " + std::to_string(f) + " doesn't exist!");
+    return pimpl->array(f);
+}
+
+const float* VoicePool::field(unsigned f) const {
+    if ( f >= pimpl->nfields )
+        throw VoicePoolUserError("Field " + std::to_string(f) + " doesn't exist!");
+    return pimpl->array(f);
+}
+
+float* VoicePool::levels() {
+    return pimpl->level();
+}
+
+const float* VoicePool::levels() const {
+    return pimpl->level();
+}
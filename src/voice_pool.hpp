@@ -0,0 +1,168 @@
+/**
+ * @file voice_pool.hpp
+ * @brief Provides @b VoicePool, preallocated voice state kept dense for vectorized processing
+ */
+#ifndef SIMPLY_VOICE_POOL_HPP_
+#define SIMPLY_VOICE_POOL_HPP_
+
+#include <string>
+#include <exception>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class VoicePoolException
+ * @brief This is the base class of all exceptions thrown by @b VoicePool
+ */
+class VoicePoolException: public std::exception {
+    protected:
+        std::string msg;
+        explicit VoicePoolException(const std::string& msg): msg(msg) {}
+
+    public:
+        /// @brief Get a message describing the error
+        /// @return NULL-terminated c-string
+        const char* what() const noexcept override { return msg.c_str(); }
+};
+
+/**
+ * @class VoicePoolUserError
+ * @brief This means a capacity or field index was invalid
+ */
+class VoicePoolUserError: public VoicePoolException {
+    public:
+        explicit VoicePoolUserError(const std::string& msg): VoicePoolException("VoicePoolUserError: " + msg) {}
+};
+
+/**
+ * @class VoicePool
+ * @brief Fixed set of voices (or any per-instance state) that start and stop without allocating
+ *
+ * Voice state is a number of float fields (phase, increment, gain,
+ * envelope...), each stored as one array across voices (structure of
+ * arrays), allocated once for @p capacity voices. The active voices are
+ * always the first @b active entries of every array: releasing a voice
+ * moves the last active one into its place. Processing every voice is
+ * then a sweep over contiguous arrays, 4 voices at a time:
+ *
+ * @code
+ * float* phase = pool.field(PHASE);
+ * float* step  = pool.field(STEP);
+ * for ( unsigned i = 0; i < pool.active(); i += 4 )
+ *     (float4::load(phase + i) + float4::load(step + i)).store(phase + i);
+ * @endcode
+ *
+ * Arrays are 16-byte aligned and padded to a multiple of 4 voices, so
+ * such sweeps may run past @b active into the (ignored) padding.
+ *
+ * Voices are named by handles carrying a generation, so a handle to a
+ * voice that was released or stolen (say, by a late note-off) is simply
+ * stale rather than naming whichever voice took its slot.
+ *
+ * When the pool is full, @b claim steals the oldest voice or the quietest
+ * one, going by the @b levels the processing keeps up to date. Voices are
+ * kept in a list by claim order, so stealing the oldest is constant time;
+ * finding the quietest takes a pass over the active levels.
+ *
+ * @note Claim, release and processing belong to one thread (usually the audio thread), where none
+ *       of them locks or allocates; pass requests from other threads in through an @b SpscQueue.
+ *       @b claim and @b release are constant time, except a @b claim stealing the quietest voice,
+ *       which like @b release_below is linear in @b active
+ */
+class VoicePool {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /// @typedef Handle
+        /// @brief Names one voice for as long as it plays; 0 never does
+        typedef uint64_t Handle;
+
+        /**
+         * @enum Stealing
+         * @brief Which voice @b claim takes over when the pool is full
+         */
+        enum Stealing {
+            /// None, @b claim fails instead
+            NO_STEALING,
+            /// The one claimed longest ago
+            OLDEST,
+            /// The one with the lowest @b levels entry
+            QUIETEST
+        };
+
+        /**
+         * @struct Options
+         * @brief Voice stealing
+         */
+        struct Options {
+            /// Which voice to take over when full
+            Stealing stealing = OLDEST;
+        };
+
+        /// @brief Pool of @p capacity voices of @p fields float fields each
+        /// @throws VoicePoolUserError if @p capacity is 0
+        VoicePool(unsigned capacity, unsigned fields);
+
+        /// @brief Create with @p options
+        /// @throws VoicePoolUserError if @p capacity is 0
+        VoicePool(unsigned capacity, unsigned fields, const Options& options);
+
+        ~VoicePool();
+
+        VoicePool(const VoicePool&) = delete;
+        VoicePool& operator=(const VoicePool&) = delete;
+
+        /// @brief Number of voices
+        unsigned capacity() const;
+
+        /// @brief Number of fields per voice
+        unsigned fields() const;
+
+        /// @brief Number of active voices, the first entries of every array
+        unsigned active() const;
+
+        /// @brief Start a voice, with all its fields and level at 0, as the last active entry
+        /// @param stolen Set to the voice taken over to make room, or 0 if none was
+        /// @return The new voice, or 0 if the pool is full and stealing is off
+        Handle claim(Handle* stolen=nullptr);
+
+        /// @brief Stop @p voice; the last active voice moves into its entry
+        /// @return `false` if @p voice was stale
+        bool release(Handle voice);
+
+        /// @brief Stop every voice whose level is below @p threshold, in one pass over the active voices
+        /// @return Number of voices stopped
+        unsigned release_below(float threshold);
+
+        /// @brief Stop every voice
+        void clear();
+
+        /// @brief Check if @p voice is still playing
+        bool valid(Handle voice) const;
+
+        /// @brief Entry of @p voice in the arrays, or -1 if it is stale
+        /// @note Only holds until the next @b claim or release
+        int index(Handle voice) const;
+
+        /// @brief Voice at entry @p index, below @b active
+        Handle handle(unsigned index) const;
+
+        /// @brief Array of field @p f, one entry per voice
+        /// @throws VoicePoolUserError if @p f is not below @b fields
+        float* field(unsigned f);
+
+        /// @brief Array of field @p f
+        /// @throws VoicePoolUserError if @p f is not below @b fields
+        const float* field(unsigned f) const;
+
+        /// @brief Array of voice levels, for stealing and @b release_below; kept by the processing
+        float* levels();
+
+        /// @brief Array of voice levels
+        const float* levels() const;
+};
+
+#endif // SIMPLY_VOICE_POOL_HPP_
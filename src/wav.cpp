@@ -0,0 +1,637 @@
+#include "wav.hpp"
+#include "file.hpp"
+#include "lockfree.hpp"
+#include "memory.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------
+// --- Header Helpers --- ----------------------------------------------
+// All WAV fields are little-endian, independent of the host
+static void put_u16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+static void put_u32(uint8_t* p, uint32_t v) {
+    for ( int i = 0; i < 4; i++ )
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+static void put_u64(uint8_t* p, uint64_t v) {
+    for ( int i = 0; i < 8; i++ )
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+static uint16_t get_u16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+    uint32_t v = 0;
+    for ( int i = 3; i >= 0; i-- )
+        v = (v << 8) | p[i];
+    return v;
+}
+
+static uint64_t get_u64(const uint8_t* p) {
+    uint64_t v = 0;
+    for ( int i = 7; i >= 0; i-- )
+        v = (v << 8) | p[i];
+    return v;
+}
+
+static void put_tag(uint8_t* p, const char* tag) {
+    std::memcpy(p, tag, 4);
+}
+
+static bool is_tag(const uint8_t* p, const char* tag) {
+    return std::memcmp(p, tag, 4) == 0;
+}
+
+static const uint16_t WAVE_FORMAT_PCM        = 0x0001;
+static const uint16_t WAVE_FORMAT_IEEE_FLOAT = 0x0003;
+static const uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+// Tail shared by KSDATAFORMAT_SUBTYPE_PCM and _IEEE_FLOAT, after the
+// leading format tag
+static const uint8_t SUBTYPE_TAIL[14] = {
+    0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00,
+    0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71
+};
+
+// Sony Wave64 chunk IDs; apart from "riff" these are the RIFF tag
+// followed by a common tail
+static const uint8_t W64_RIFF[16] = {
+    0x72, 0x69, 0x66, 0x66, 0x2E, 0x91, 0xCF, 0x11,
+    0xA5, 0xD6, 0x28, 0xDB, 0x04, 0xC1, 0x00, 0x00
+};
+static const uint8_t W64_TAIL[12] = {
+    0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0,
+    0x4F, 0x8E, 0xDB, 0x8A
+};
+
+static void put_w64_id(uint8_t* p, const char* tag) {
+    put_tag(p, tag);
+    std::memcpy(p + 4, W64_TAIL, sizeof(W64_TAIL));
+}
+
+static bool is_w64_id(const uint8_t* p, const char* tag) {
+    return is_tag(p, tag) && std::memcmp(p + 4, W64_TAIL, sizeof(W64_TAIL)) == 0;
+}
+
+// Data always starts here, so batched writes line up with the disk's
+// pages; the gap after "fmt " is filled with a JUNK chunk
+static const uint64_t DATA_OFFSET = 4096;
+
+// Header offsets of the fields patched while recording
+//   RIFF/RF64: the first chunk is JUNK (WAV) or ds64 (RF64), of the
+//              same size, so a WAV can be promoted to RF64 in place
+//   W64:       sizes are 64-bit and count their own 24 byte header
+static const uint64_t DS64_OFFSET     = 12;
+static const uint32_t DS64_SIZE       = 28;
+static const uint64_t W64_RIFF_SIZE   = 16;
+static const uint64_t W64_DATA_HEADER = DATA_OFFSET - 24;
+
+static void validate(const WavFormat& fmt) {
+    if ( fmt.channels == 0 )
+        throw WavUserError("Cannot write a file without channels!");
+    if ( fmt.sample_rate == 0 )
+        throw WavUserError("Cannot write a file with a sample rate of 0!");
+    if ( fmt.is_float ) {
+        if ( fmt.bits_per_sample != 32 )
+            throw WavUserError("Float samples must be 32 bits!");
+    } else if ( fmt.bits_per_sample != 8  && fmt.bits_per_sample != 16 &&
+                fmt.bits_per_sample != 24 && fmt.bits_per_sample != 32 ) {
+        throw WavUserError("Unsupported bits per sample!");
+    }
+}
+
+// Writes the body of the "fmt " chunk to @p p
+// @return Size of the body
+static uint32_t build_fmt(uint8_t* p, const WavFormat& fmt) {
+    // WAVE_FORMAT_EXTENSIBLE is expected for anything beyond basic stereo
+    bool     extensible = fmt.channels > 2 || fmt.bits_per_sample > 16;
+    uint16_t tag        = fmt.is_float ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM;
+
+    put_u16(p, extensible ? WAVE_FORMAT_EXTENSIBLE : tag);
+    put_u16(p + 2, fmt.channels);
+    put_u32(p + 4, fmt.sample_rate);
+    put_u32(p + 8, static_cast<uint32_t>(fmt.sample_rate * fmt.frame_bytes()));
+    put_u16(p + 12, static_cast<uint16_t>(fmt.frame_bytes()));
+    put_u16(p + 14, fmt.bits_per_sample);
+    if ( !extensible )
+        return 16;
+    put_u16(p + 16, 22);                  // cbSize
+    put_u16(p + 18, fmt.bits_per_sample); // wValidBitsPerSample
+    put_u32(p + 20, 0);                   // dwChannelMask, unassigned
+    put_u16(p + 24, tag);                 // SubFormat GUID
+    std::memcpy(p + 26, SUBTYPE_TAIL, sizeof(SUBTYPE_TAIL));
+    return 40;
+}
+
+// Writes everything up to the first data byte into the first
+// DATA_OFFSET bytes of @p hdr, with all sizes left at 0
+static void build_header(uint8_t* hdr, const WavFormat& fmt) {
+    std::memset(hdr, 0, DATA_OFFSET);
+    uint8_t* data = hdr + DATA_OFFSET;
+
+    if ( fmt.container == WavFormat::W64 ) {
+        std::memcpy(hdr, W64_RIFF, sizeof(W64_RIFF));
+        put_w64_id(hdr + 24, "wave");
+        uint8_t* p = hdr + 40;
+        put_w64_id(p, "fmt ");
+        uint32_t body = build_fmt(p + 24, fmt);
+        put_u64(p + 16, 24 + body);
+        p += 24 + ((body + 7) & ~7u);
+        put_w64_id(p, "junk");
+        put_u64(p + 16, static_cast<uint64_t>(data - 24 - p));
+        put_w64_id(data - 24, "data");
+        put_u64(data - 8, 24);
+        return;
+    }
+
+    bool rf64 = fmt.container == WavFormat::RF64;
+    put_tag(hdr, rf64 ? "RF64" : "RIFF");
+    put_tag(hdr + 8, "WAVE");
+    put_tag(hdr + DS64_OFFSET, rf64 ? "ds64" : "JUNK");
+    put_u32(hdr + DS64_OFFSET + 4, DS64_SIZE);
+
+    uint8_t* p = hdr + DS64_OFFSET + 8 + DS64_SIZE;
+    put_tag(p, "fmt ");
+    uint32_t body = build_fmt(p + 8, fmt);
+    put_u32(p + 4, body);
+    p += 8 + body;
+
+    put_tag(p, "JUNK");
+    put_u32(p + 4, static_cast<uint32_t>(data - 8 - (p + 8)));
+    put_tag(data - 8, "data");
+    if ( rf64 ) {
+        put_u32(hdr + 4, 0xFFFFFFFF);
+        put_u32(data - 4, 0xFFFFFFFF);
+    }
+}
+
+// Reads the body of a "fmt " chunk into @p fmt
+static void parse_fmt(const uint8_t* p, uint64_t size, WavFormat& fmt) {
+    if ( size < 16 )
+        throw WavRuntimeError("Truncated fmt chunk!");
+    uint16_t tag        = get_u16(p);
+    fmt.channels        = get_u16(p + 2);
+    fmt.sample_rate     = get_u32(p + 4);
+    fmt.bits_per_sample = get_u16(p + 14);
+    if ( tag == WAVE_FORMAT_EXTENSIBLE ) {
+        if ( size < 40 || std::memcmp(p + 26, SUBTYPE_TAIL, sizeof(SUBTYPE_TAIL)) != 0 )
+            throw WavRuntimeError("Unsupported extensible sub-format!");
+        tag = get_u16(p + 24);
+    }
+    if ( tag != WAVE_FORMAT_PCM && tag != WAVE_FORMAT_IEEE_FLOAT )
+        throw WavRuntimeError("Unsupported format tag " + std::to_string(tag) + "!");
+    fmt.is_float = tag == WAVE_FORMAT_IEEE_FLOAT;
+    try {
+        validate(fmt);
+    } catch ( const WavUserError& e ) {
+        throw WavRuntimeError(e.what());
+    }
+}
+
+// ---------------------------------------------------------------------
+// --- WavWriter Implementation --- ------------------------------------
+// One preallocated slot of the audio -> writer queue
+struct WavBlock {
+    AlignedBuffer<uint8_t> data;
+    size_t                 bytes = 0;
+};
+
+struct WavWriter::Impl {
+    WavFormat            fmt;
+    Options              opts;
+    WavFormat::Container container; // Differs from fmt once promoted to RF64
+    RawFile              file;
+    SpscQueue<WavBlock>  queue;
+    size_t               block_bytes;
+
+    // Only touched by the writing thread (and close, after joining)
+    AlignedBuffer<uint8_t> batch;
+    size_t                 batch_used   = 0;
+    uint64_t               batch_offset = DATA_OFFSET; // Where batch lands in the file
+    uint64_t               data_bytes   = 0;           // Bytes in the data chunk on disk
+
+    std::atomic<bool>      stopping{false};
+    std::atomic<uint64_t>  frames_done{0};
+    std::atomic<uint64_t>  dropped{0};
+    Thread                 writer;
+    std::atomic<bool>      open{true};  // read by push on the audio thread, cleared by close
+
+    Impl(const std::string& path, const WavFormat& f, const Options& o):
+        fmt(f), opts(o), container(f.container), queue(o.queue_blocks), block_bytes(o.block_frames * f.frame_bytes())
+    {
+        validate(fmt);
+        if ( opts.block_frames == 0 || opts.queue_blocks == 0 )
+            throw WavUserError("Block size and queue length must be non-zero!");
+        if ( opts.write_bytes == 0 || opts.write_bytes % 4096 != 0 )
+            throw WavUserError("Write size must be a multiple of 4096!");
+
+        for ( size_t i = 0; i < queue.capacity(); i++ )
+            queue.slot_at(i).data.allocate(block_bytes);
+        batch.allocate(opts.write_bytes, 4096);
+
+        try {
+            file.open(path, RawFile::WRITE);
+            if ( opts.preallocate_bytes )
+                file.preallocate(DATA_OFFSET + opts.preallocate_bytes);
+            std::vector<uint8_t> hdr(DATA_OFFSET);
+            build_header(hdr.data(), fmt);
+            file.write_at(0, hdr.data(), hdr.size());
+        } catch ( const FileException& e ) {
+            throw WavRuntimeError(e.what());
+        }
+
+        writer.create(writer_main, this);
+        writer.set_priority(opts.priority);
+        writer.start();
+    }
+
+    // ====== Audio thread ======
+    bool push(const uint8_t* src, size_t frames) {
+        bool   ok          = true;
+        size_t frame_bytes = fmt.frame_bytes();
+        while ( frames > 0 ) {
+            size_t n = frames < opts.block_frames ? frames : opts.block_frames;
+            if ( WavBlock* slot = queue.write_slot() ) {
+                std::memcpy(slot->data.data(), src, n * frame_bytes);
+                slot->bytes = n * frame_bytes;
+                queue.commit();
+            } else {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                ok = false;
+            }
+            src    += n * frame_bytes;
+            frames -= n;
+        }
+        return ok;
+    }
+
+    // ====== Offline producer ======
+    void write(const uint8_t* src, size_t frames) {
+        size_t frame_bytes = fmt.frame_bytes();
+        while ( frames > 0 ) {
+            WavBlock* slot = queue.write_slot();
+            if ( !slot ) {
+                // The writer only stops early on an error, which close raises
+                if ( writer.completed() ) {
+                    close();
+                    throw WavRuntimeError("The writing thread stopped!");
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            size_t n = frames < opts.block_frames ? frames : opts.block_frames;
+            std::memcpy(slot->data.data(), src, n * frame_bytes);
+            slot->bytes = n * frame_bytes;
+            queue.commit();
+            src    += n * frame_bytes;
+            frames -= n;
+        }
+    }
+
+    // ====== Writing thread ======
+    static int writer_main(void* data) {
+        static_cast<Impl*>(data)->run();
+        return 0;
+    }
+
+    // Writes the whole batch and starts a new one right after it, so
+    // every full write starts at DATA_OFFSET + k * write_bytes
+    void write_full_batch() {
+        file.write_at(batch_offset, batch.data(), batch_used);
+        batch_offset += batch_used;
+        batch_used    = 0;
+    }
+
+    // Writes what is in the batch without consuming it, so the next
+    // full write still starts at the aligned offset and overwrites this
+    void write_partial_batch() {
+        if ( batch_used )
+            file.write_at(batch_offset, batch.data(), batch_used);
+    }
+
+    void append(const uint8_t* src, size_t bytes) {
+        while ( bytes > 0 ) {
+            size_t n = batch.size() - batch_used;
+            if ( n > bytes )
+                n = bytes;
+            std::memcpy(batch.data() + batch_used, src, n);
+            batch_used += n;
+            src        += n;
+            bytes      -= n;
+            if ( batch_used == batch.size() )
+                write_full_batch();
+        }
+    }
+
+    // Bytes of padding after the data chunk
+    uint64_t data_padding() const {
+        if ( container == WavFormat::W64 )
+            return (8 - (data_bytes & 7)) & 7;
+        return data_bytes & 1;
+    }
+
+    // Rewrites a RIFF header as RF64 once it outgrows 32-bit sizes. The
+    // ds64 chunk takes the place of the leading JUNK chunk, and is
+    // written before the tag flips, so the file is valid at every step
+    void promote_to_rf64() {
+        uint8_t ds64[8];
+        put_tag(ds64, "ds64");
+        put_u32(ds64 + 4, DS64_SIZE);
+        container = WavFormat::RF64;
+        patch_ds64();
+        file.write_at(DS64_OFFSET, ds64, 8);
+
+        uint8_t riff[8];
+        put_tag(riff, "RF64");
+        put_u32(riff + 4, 0xFFFFFFFF);
+        file.write_at(0, riff, 8);
+        put_u32(riff, 0xFFFFFFFF);
+        file.write_at(DATA_OFFSET - 4, riff, 4);
+    }
+
+    void patch_ds64() {
+        uint8_t ds64[DS64_SIZE] = {};
+        put_u64(ds64, DATA_OFFSET - 8 + data_bytes + data_padding());
+        put_u64(ds64 + 8, data_bytes);
+        put_u64(ds64 + 16, data_bytes / fmt.frame_bytes());
+        file.write_at(DS64_OFFSET + 8, ds64, DS64_SIZE);
+    }
+
+    void patch_header() {
+        write_partial_batch();
+        data_bytes = batch_offset + batch_used - DATA_OFFSET;
+        uint64_t riff_bytes = DATA_OFFSET - 8 + data_bytes + data_padding();
+
+        if ( container == WavFormat::W64 ) {
+            uint8_t size[8];
+            put_u64(size, riff_bytes + 8);
+            file.write_at(W64_RIFF_SIZE, size, 8);
+            put_u64(size, 24 + data_bytes);
+            file.write_at(W64_DATA_HEADER + 16, size, 8);
+        } else if ( container == WavFormat::WAV && riff_bytes > 0xFFFFFFFFull ) {
+            promote_to_rf64();
+        } else if ( container == WavFormat::RF64 ) {
+            patch_ds64();
+        } else {
+            uint8_t size[4];
+            put_u32(size, static_cast<uint32_t>(riff_bytes));
+            file.write_at(4, size, 4);
+            put_u32(size, static_cast<uint32_t>(data_bytes));
+            file.write_at(DATA_OFFSET - 4, size, 4);
+        }
+        frames_done.store(data_bytes / fmt.frame_bytes(), std::memory_order_relaxed);
+    }
+
+    void run() {
+        using clock = std::chrono::steady_clock;
+        auto interval   = std::chrono::milliseconds(opts.patch_interval_ms);
+        auto last_patch = clock::now();
+        while ( true ) {
+            bool stop    = stopping.load(std::memory_order_acquire);
+            bool drained = false;
+            while ( WavBlock* slot = queue.read_slot() ) {
+                append(slot->data.data(), slot->bytes);
+                queue.release();
+                drained = true;
+            }
+            if ( clock::now() - last_patch >= interval ) {
+                patch_header();
+                last_patch = clock::now();
+            }
+            // The flag was read before draining, so anything pushed
+            // before close() has been written by now
+            if ( stop )
+                break;
+            if ( !drained )
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        patch_header();
+        uint64_t end = DATA_OFFSET + data_bytes;
+        if ( uint64_t padding = data_padding() ) {
+            uint8_t pad[8] = {};
+            file.write_at(end, pad, padding);
+            end += padding;
+        }
+        file.truncate(end);
+        file.flush();
+    }
+
+    void close() {
+        if ( !open.exchange(false, std::memory_order_acq_rel) )
+            return;
+        stopping.store(true, std::memory_order_release);
+        writer.join();
+        try {
+            writer.exit_code();
+        } catch ( const FileException& e ) {
+            file.close();
+            throw WavRuntimeError(e.what());
+        }
+        file.close();
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- WavWriter Class Methods --- -------------------------------------
+WavWriter::WavWriter(const std::string& path, const WavFormat& format):
+    WavWriter(path, format, Options()) {}
+
+WavWriter::WavWriter(const std::string& path, const WavFormat& format, const Options& options) {
+    pimpl = std::make_unique<Impl>(path, format, options);
+}
+
+WavWriter::~WavWriter() {
+    if ( pimpl )
+        try {
+            pimpl->close();
+        }
+        catch ( ... ) { ; }
+}
+
+bool WavWriter::push(const void* data, size_t frames) {
+    if ( !pimpl->open.load(std::memory_order_acquire) )
+        return false;
+    return pimpl->push(static_cast<const uint8_t*>(data), frames);
+}
+
+void WavWriter::write(const void* data, size_t frames) {
+    if ( !pimpl->open.load(std::memory_order_acquire) )
+        throw WavUserError("Can't write to a closed file!");
+    pimpl->write(static_cast<const uint8_t*>(data), frames);
+}
+
+void WavWriter::close() {
+    pimpl->close();
+}
+
+bool WavWriter::is_open() const {
+    return pimpl->open.load(std::memory_order_acquire);
+}
+
+const WavFormat& WavWriter::format() const {
+    return pimpl->fmt;
+}
+
+uint64_t WavWriter::frames_written() const {
+    return pimpl->frames_done.load(std::memory_order_relaxed);
+}
+
+uint64_t WavWriter::dropped_blocks() const {
+    return pimpl->dropped.load(std::memory_order_relaxed);
+}
+
+// ---------------------------------------------------------------------
+// --- WavReader Implementation --- ------------------------------------
+struct WavReader::Impl {
+    RawFile   file;
+    WavFormat fmt;
+    uint64_t  data_offset = 0;
+    uint64_t  total       = 0; // Frames
+    uint64_t  position    = 0; // Frames
+
+    explicit Impl(const std::string& path) {
+        try {
+            file.open(path, RawFile::READ);
+            uint8_t hdr[40] = {};
+            file.read_at(0, hdr, sizeof(hdr));
+            if ( std::memcmp(hdr, W64_RIFF, sizeof(W64_RIFF)) == 0 && is_w64_id(hdr + 24, "wave") )
+                parse_w64();
+            else if ( (is_tag(hdr, "RIFF") || is_tag(hdr, "RF64")) && is_tag(hdr + 8, "WAVE") )
+                parse_riff(is_tag(hdr, "RF64"));
+            else
+                throw WavRuntimeError("'" + path + "' is not a WAV, RF64 or Wave64 file!");
+        } catch ( const FileException& e ) {
+            throw WavRuntimeError(e.what());
+        }
+    }
+
+    std::vector<uint8_t> read_body(uint64_t offset, uint64_t size) {
+        if ( size > 0x10000 )
+            throw WavRuntimeError("Oversized fmt chunk!");
+        std::vector<uint8_t> body(static_cast<size_t>(size));
+        if ( file.read_at(offset, body.data(), body.size()) != body.size() )
+            throw WavRuntimeError("Truncated fmt chunk!");
+        return body;
+    }
+
+    // A size that was never patched (0 for a WAV/W64, or one pointing
+    // past the end of the file) means "up to the end of the file"
+    void set_data(uint64_t offset, uint64_t bytes) {
+        uint64_t available = file.size() - offset;
+        if ( bytes == 0 || bytes > available )
+            bytes = available;
+        data_offset = offset;
+        total       = bytes / fmt.frame_bytes();
+    }
+
+    void parse_riff(bool rf64) {
+        fmt.container = rf64 ? WavFormat::RF64 : WavFormat::WAV;
+        uint64_t ds64_data = 0;
+        bool     have_fmt  = false;
+        uint64_t offset    = 12;
+        uint64_t end       = file.size();
+        while ( offset + 8 <= end ) {
+            uint8_t chunk[8];
+            file.read_at(offset, chunk, 8);
+            uint64_t size = get_u32(chunk + 4);
+            if ( is_tag(chunk, "ds64") && size >= DS64_SIZE ) {
+                std::vector<uint8_t> body = read_body(offset + 8, size);
+                ds64_data = get_u64(body.data() + 8);
+            } else if ( is_tag(chunk, "fmt ") ) {
+                std::vector<uint8_t> body = read_body(offset + 8, size);
+                parse_fmt(body.data(), size, fmt);
+                fmt.container = rf64 ? WavFormat::RF64 : WavFormat::WAV;
+                have_fmt = true;
+            } else if ( is_tag(chunk, "data") ) {
+                if ( !have_fmt )
+                    throw WavRuntimeError("Data chunk before fmt chunk!");
+                if ( rf64 && size == 0xFFFFFFFF )
+                    size = ds64_data;
+                set_data(offset + 8, size);
+                return;
+            }
+            offset += 8 + size + (size & 1);
+        }
+        throw WavRuntimeError("No data chunk!");
+    }
+
+    void parse_w64() {
+        bool     have_fmt = false;
+        uint64_t offset   = 40;
+        uint64_t end      = file.size();
+        while ( offset + 24 <= end ) {
+            uint8_t chunk[24];
+            file.read_at(offset, chunk, 24);
+            uint64_t size = get_u64(chunk + 16);
+            if ( size < 24 && !is_w64_id(chunk, "data") )
+                throw WavRuntimeError("Corrupt Wave64 chunk!");
+            if ( is_w64_id(chunk, "fmt ") ) {
+                std::vector<uint8_t> body = read_body(offset + 24, size - 24);
+                parse_fmt(body.data(), size - 24, fmt);
+                have_fmt = true;
+            } else if ( is_w64_id(chunk, "data") ) {
+                if ( !have_fmt )
+                    throw WavRuntimeError("Data chunk before fmt chunk!");
+                set_data(offset + 24, size > 24 ? size - 24 : 0);
+                fmt.container = WavFormat::W64;
+                return;
+            }
+            offset += (size + 7) & ~static_cast<uint64_t>(7);
+        }
+        throw WavRuntimeError("No data chunk!");
+    }
+
+    size_t read(uint8_t* dst, size_t frames) {
+        if ( frames > total - position )
+            frames = static_cast<size_t>(total - position);
+        size_t bytes = frames * fmt.frame_bytes();
+        size_t got;
+        try {
+            got = file.read_at(data_offset + position * fmt.frame_bytes(), dst, bytes);
+        } catch ( const FileException& e ) {
+            throw WavRuntimeError(e.what());
+        }
+        frames    = got / fmt.frame_bytes();
+        position += frames;
+        return frames;
+    }
+};
+
+// ---------------------------------------------------------------------
+// --- WavReader Class Methods --- -------------------------------------
+WavReader::WavReader(const std::string& path) {
+    pimpl = std::make_unique<Impl>(path);
+}
+
+WavReader::~WavReader() = default;
+
+const WavFormat& WavReader::format() const {
+    return pimpl->fmt;
+}
+
+uint64_t WavReader::frames() const {
+    return pimpl->total;
+}
+
+uint64_t WavReader::tell() const {
+    return pimpl->position;
+}
+
+void WavReader::seek(uint64_t frame) {
+    pimpl->position = frame < pimpl->total ? frame : pimpl->total;
+}
+
+size_t WavReader::read(void* data, size_t frames) {
+    return pimpl->read(static_cast<uint8_t*>(data), frames);
+}
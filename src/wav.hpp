@@ -0,0 +1,210 @@
+/**
+ * @file wav.hpp
+ * @brief Provides @b WavWriter and @b WavReader for WAV, RF64 and Wave64 files
+ */
+#ifndef SIMPLY_WAV_HPP_
+#define SIMPLY_WAV_HPP_
+
+#include "threads.hpp"
+
+#include <string>
+#include <exception>
+#include <memory>
+#include <cstdint>
+
+/**
+ * @class WavException
+ * @brief This is the base class of all exceptions thrown by the WAV classes
+ */
+class WavException: public std::exception {
+    protected:
+        std::string msg;
+        explicit WavException(const std::string& msg): msg(msg) {}
+
+    public:
+        /// @brief Get a message describing the error
+        /// @return NULL-terminated c-string
+        const char* what() const noexcept override { return msg.c_str(); }
+};
+
+/**
+ * @class WavUserError
+ * @brief This means some WAV operations were used in incorrect order/combination
+ */
+class WavUserError: public WavException {
+    public:
+        explicit WavUserError(const std::string& msg): WavException("WavUserError: " + msg) {}
+};
+
+/**
+ * @class WavRuntimeError
+ * @brief This means the file or your system failed to handle a valid operation
+ */
+class WavRuntimeError: public WavException {
+    public:
+        explicit WavRuntimeError(const std::string& msg): WavException("WavRuntimeError: " + msg) {}
+};
+
+/**
+ * @struct WavFormat
+ * @brief Sample layout of a WAV file, mirrors the relevant `WAVEFORMATEX` fields
+ */
+struct WavFormat {
+    /**
+     * @enum Container
+     * @brief The file layout wrapped around the samples
+     */
+    enum Container {
+        /// RIFF WAV, limited to 4 GB; the writer promotes it to RF64 in place if it grows past that
+        WAV,
+        /// EBU RF64, a RIFF variant with 64-bit sizes in a "ds64" chunk
+        RF64,
+        /// Sony Wave64, with GUID chunk IDs and 64-bit sizes
+        W64
+    };
+
+    /// Number of interleaved channels (`nChannels`)
+    uint16_t channels        = 2;
+    /// Frames per second (`nSamplesPerSec`)
+    uint32_t sample_rate     = 48000;
+    /// Bits per sample (`wBitsPerSample`), one of 8, 16, 24 or 32
+    uint16_t bits_per_sample = 16;
+    /// `true` for IEEE float samples, `false` for integer PCM
+    bool     is_float        = false;
+    /// File layout
+    Container container      = WAV;
+
+    /// @brief Bytes per interleaved frame (`nBlockAlign`)
+    size_t frame_bytes() const { return static_cast<size_t>(channels) * (bits_per_sample / 8); }
+};
+
+/**
+ * @class WavWriter
+ * @brief Records to a WAV file without ever blocking the pushing thread
+ *
+ * The audio thread copies its blocks into a preallocated lock-free
+ * queue with @b push. A separate, lower-priority @b Thread drains the
+ * queue and batches the blocks into large writes, aligned to the
+ * batch size within the file.
+ *
+ * The RIFF and data sizes are patched periodically, so if the process
+ * dies the file is readable up to the last patch. A @b WavFormat::WAV
+ * recording that grows past 4 GB is promoted to RF64 during one of
+ * these patches, so long sessions end up in a single file. If the disk can't
+ * keep up and the queue fills, the block is dropped and counted in
+ * @b dropped_blocks rather than stalling the audio thread. Offline
+ * producers use @b write instead, which waits for the disk.
+ */
+class WavWriter {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /**
+         * @struct Options
+         * @brief Tuning for the write-behind thread
+         */
+        struct Options {
+            /// Frames per queued block; larger pushes are split
+            size_t           block_frames      = 512;
+            /// Number of blocks the queue can hold before dropping
+            size_t           queue_blocks      = 256;
+            /// Size of each batched write in bytes (multiple of 4096)
+            size_t           write_bytes       = 1 << 20;
+            /// Disk space to reserve up-front, 0 to not reserve any
+            uint64_t         preallocate_bytes = 0;
+            /// How often to patch the header sizes
+            uint32_t         patch_interval_ms = 1000;
+            /// Priority of the writing thread
+            Thread::Priority priority          = Thread::LOW;
+        };
+
+        /// @brief Create @p path and start the writing thread
+        /// @throws WavUserError if @p format is not supported
+        /// @throws WavRuntimeError if the file can't be created
+        WavWriter(const std::string& path, const WavFormat& format);
+
+        /// @brief Create @p path and start the writing thread with @p options
+        WavWriter(const std::string& path, const WavFormat& format, const Options& options);
+
+        /// @brief Closes the file, discarding any errors
+        ~WavWriter();
+
+        WavWriter(const WavWriter&) = delete;
+        WavWriter& operator=(const WavWriter&) = delete;
+
+        /// @brief Queue interleaved frames to be written
+        /// Safe to call from a REAL_TIME thread: never blocks or allocates
+        /// @param data Interleaved samples in the file's format
+        /// @param frames Number of frames in @p data
+        /// @return `false` if any block was dropped because the queue was full, or the file is closed
+        /// @note May run while another thread calls @b close; frames pushed once it has begun may be lost
+        bool push(const void* data, size_t frames);
+
+        /// @brief Queue interleaved frames to be written, waiting for room rather than dropping
+        /// For offline use, where the disk should pace the producer
+        /// @param data Interleaved samples in the file's format
+        /// @param frames Number of frames in @p data
+        /// @throws WavUserError if the file is closed
+        /// @throws WavRuntimeError if the writing thread failed
+        void write(const void* data, size_t frames);
+
+        /// @brief Drain the queue, finalize the header and close the file
+        /// @throws Any error raised by the writing thread
+        void close();
+
+        /// @brief Check if the file is still open
+        bool is_open() const;
+
+        /// @brief Format the file was opened with
+        /// @note @b container stays @b WavFormat::WAV after promotion to RF64
+        const WavFormat& format() const;
+
+        /// @brief Number of frames written to disk so far
+        uint64_t frames_written() const;
+
+        /// @brief Number of blocks dropped because the queue was full
+        uint64_t dropped_blocks() const;
+};
+
+/**
+ * @class WavReader
+ * @brief Reads interleaved frames from a WAV, RF64 or Wave64 file
+ *
+ * Files whose sizes were never patched (such as a recording cut short)
+ * are read up to the end of the file.
+ */
+class WavReader {
+    protected:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl;
+
+    public:
+        /// @brief Open @p path and parse its header
+        /// @throws WavRuntimeError if the file can't be opened or isn't supported
+        explicit WavReader(const std::string& path);
+
+        ~WavReader();
+
+        WavReader(const WavReader&) = delete;
+        WavReader& operator=(const WavReader&) = delete;
+
+        /// @brief Format of the file, including the container it was found in
+        const WavFormat& format() const;
+
+        /// @brief Total number of frames in the file
+        uint64_t frames() const;
+
+        /// @brief Frame the next @b read starts at
+        uint64_t tell() const;
+
+        /// @brief Move to @p frame, clamped to the end of the file
+        void seek(uint64_t frame);
+
+        /// @brief Read up to @p frames interleaved frames in the file's format
+        /// @return Number of frames read, 0 at the end of the file
+        size_t read(void* data, size_t frames);
+};
+
+#endif // SIMPLY_WAV_HPP_